@@ -31,6 +31,7 @@
 #include <ostream>                          // std::ostringstream, std::endl
 #include <regex>                            // std::regex (Requires CXXFLAGS += "-std=c++11")
 #include <set>                              // std::set
+#include <sstream>                          // std::istringstream
 #include <stdexcept>                        // std::runtime_error
 #include <string>                           // std::string
 #include <vector>                           // std::vector
@@ -38,6 +39,7 @@
 #include <boost/tuple/tuple.hpp>            // boost::tie
 
 #include "ns3/command-line.h"               // ns3::CommandLine
+#include "ns3/csma-helper.h"                // ns3::CsmaHelper
 #include "ns3/dce-manager-helper.h"         // ns3::DceManagerHelper
 #include "ns3/ibgp2d-helper.h"              // ns3::IBgp2dHelper
 #include "ns3/ipv4-dce-routing-helper.h"    // ns3::Ipv4DceRoutingHelper
@@ -70,6 +72,8 @@
 #define RE_PREFIX_V4 "(\\d{1,3}\\.\\d{1,3}\\.\\d{1,3}\\.\\d{1,3}/\\d{1,3})"
 #define RE_IBGP      "(UP|OVER|DOWN)"
 #define RE_COMMENT   "\\s*(#.*)?"
+#define RE_LAN       "\\s*lan"
+#define RE_LAN_PORTS "((\\s+[^\\s]+\\s+\\d+)+)\\s*"
 
 // Intern simulation parameters
 #define ASN1                    1            // AS1 is the simulated AS
@@ -332,16 +336,26 @@ std::pair<Hostname, Hostname>,
     std::pair<IgpWeight, IgpWeight>
     > IgpLinks;
 
+typedef std::map<
+    std::string,                    // LAN name
+    std::map<Hostname, IgpWeight>   // weight of each router attached to the LAN
+    > IgpLans;
+
 /**
  * \brief Parse an input stream and convert it into a IgpLinks structure.
  *   This stream must contains TSV lines containing successively :
  *   hostname_u hostname_v weight_uv weight_vu
+ *   A broadcast LAN segment is described by a line containing successively:
+ *   lan lan_name hostname_1 weight_1 hostname_2 weight_2 ...
  * \param ifs The input stream
+ * \param igpLinks The IGP links (between two routers).
+ * \param igpLans The IGP LAN segments.
  */
 
 NodeContainer ParseIgpFile (
     std::istream & ifs,
-    IgpLinks     & igpLinks
+    IgpLinks     & igpLinks,
+    IgpLans      & igpLans
 ) {
     std::string line;
     std::set<Hostname> nodeNames;
@@ -350,6 +364,7 @@ NodeContainer ParseIgpFile (
     const std::regex regexIgp1 ( RE_WORD RE_SPACE RE_WORD RE_SPACE RE_METRIC );
     const std::regex regexIgp2 ( RE_WORD RE_SPACE RE_WORD RE_SPACE RE_METRIC RE_SPACE RE_METRIC );
     const std::regex regexComment ( RE_COMMENT );
+    const std::regex regexLan ( RE_LAN RE_SPACE RE_WORD RE_LAN_PORTS );
     const IgpWeight infinity = std::numeric_limits<uint32_t>::max();
 
     for ( std::string line; std::getline ( ifs, line ); ) {
@@ -359,6 +374,21 @@ NodeContainer ParseIgpFile (
 
         if ( std::regex_match ( line, sm, regexComment ) ) {
             continue;
+        } else if ( std::regex_match ( line, sm, regexLan ) ) {
+            const std::string lanName = sm[1];
+            std::map<Hostname, IgpWeight> & ports = igpLans[lanName];
+            std::istringstream iss ( sm[2] );
+            Hostname name;
+            IgpWeight weight;
+
+            while ( iss >> name >> weight ) {
+                if ( ports.find ( name ) != ports.end() ) {
+                    std::cerr << "[!!] Router " << name << " attached twice to LAN " << lanName << std::endl;
+                }
+                ports[name] = weight;
+                nodeNames.insert ( name );
+            }
+            continue;
         } else if ( std::regex_match ( line, sm, regexIgp1 ) ) {
             srcName = sm[1];
             dstName = sm[2];
@@ -765,12 +795,14 @@ bool ParseIbgpFile (
  * @param node The corresponding Node.
  * @param interface The interface that must be configured.
  * @param weight The corresponding OSPF weight.
+ * @param networkType The OSPF network type of the interface.
  */
 
 void SetupOspfInterface (
     Ptr<Node> node,
     const Ipv4InterfaceAddress & interface,
-    const IgpWeight & weight
+    const IgpWeight & weight,
+    OspfNetworkType networkType
 ) {
     Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
     const Ipv4Prefix prefix ( interface.GetLocal(), interface.GetMask() );
@@ -789,6 +821,7 @@ void SetupOspfInterface (
     ospfInterface.SetDeadInterval ( 3 * ospfInterface.GetHelloInterval() );
     ospfInterface.SetTransmitDelay ( 1 );
     ospfInterface.SetRetransmitInterval ( 3 );
+    ospfInterface.SetNetworkType ( networkType );
     ospfConfig->AddInterface ( ospfInterface );
 }
 
@@ -798,13 +831,22 @@ void SetupOspfInterface (
  * @param ptp PointToPointHelper setting links set up between each pair of adjacent Nodes.
  * @param igpLinks The IGP links that must been configured.
  * @param mapLinkIps This map is filled according to the Ipv4Address assigned to each nodes.
+ * @param networkType The OSPF network type of the interfaces (each IGP link
+ *   only connects two routers, so OSPF_NETWORK_POINT_TO_POINT avoids the
+ *   DR/BDR election).
+ * @param csma CsmaHelper setting the LAN segments.
+ * @param igpLans The IGP LAN segments that must been configured. Their
+ *   interfaces are always configured as OSPF broadcast interfaces.
  */
 
 void BuildOspfTopology (
     Ipv4AddressHelper & ipv4AddressHelper, // based on igpPrefix
     PointToPointHelper & ptp,
     const IgpLinks & igpLinks,
-    MapLinkIps & mapLinkIps
+    MapLinkIps & mapLinkIps,
+    OspfNetworkType networkType,
+    CsmaHelper & csma,
+    const IgpLans & igpLans
 ) {
     const uint32_t infinity = std::numeric_limits<uint32_t>::max();
     for ( auto & lw : igpLinks ) {
@@ -832,15 +874,62 @@ void BuildOspfTopology (
 
         // Configure src interface
         if ( srcWeight != infinity ) {
-            SetupOspfInterface ( srcNode, srcIf, srcWeight );
+            SetupOspfInterface ( srcNode, srcIf, srcWeight, networkType );
             std::cout << "[OSPF]: Node [" << srcName << "]: interface " << srcIf.GetLocal() << ": metric = " << srcWeight << std::endl;
         }
 
         if ( dstWeight != infinity ) {
-            SetupOspfInterface ( dstNode, dstIf, dstWeight );
+            SetupOspfInterface ( dstNode, dstIf, dstWeight, networkType );
             std::cout << "[OSPF]: Node [" << dstName << "]: interface " << dstIf.GetLocal() << ": metric = " << dstWeight << std::endl;
         }
     }
+
+    for ( auto & lan : igpLans ) {
+        const std::string & lanName = lan.first;
+        const std::map<Hostname, IgpWeight> & ports = lan.second;
+
+        NodeContainer lanNodes;
+        for ( auto & port : ports ) {
+            Ptr<Node> node = Names::Find<Node> ( port.first );
+            if ( !node ) {
+                throw std::runtime_error ( std::string ( "BuildOspfTopology: router not found: " ) + port.first );
+            }
+            lanNodes.Add ( node );
+        }
+
+        // Install the LAN segment. This adds a new interface on each router,
+        // all of them in the same IP network.
+        NetDeviceContainer dc = csma.Install ( lanNodes );
+        Ipv4InterfaceContainer ifs = ipv4AddressHelper.Assign ( dc );
+        ipv4AddressHelper.NewNetwork();
+
+        std::vector<Ipv4InterfaceAddress> lanIfs;
+        for ( uint32_t i = 0; i < ifs.GetN(); ++i ) {
+            lanIfs.push_back ( ifs.Get ( i ).first->GetAddress ( ifs.Get ( i ).second, 0 ) );
+        }
+        std::cout << "[IPV4]: LAN installed: [" << lanName << "] (" << Ipv4Prefix ( lanIfs[0].GetLocal(), lanIfs[0].GetMask() ) << ")" << std::endl;
+
+        uint32_t i = 0;
+        for ( auto & port : ports ) {
+            const Hostname & name = port.first;
+            const IgpWeight & weight = port.second;
+            Ptr<Node> node = lanNodes.Get ( i );
+
+            // Routers of the LAN are directly connected, unless a link has
+            // already been installed between them.
+            for ( uint32_t j = i + 1; j < lanNodes.GetN(); ++j ) {
+                if ( mapLinkIps.find ( MakeKey ( node, lanNodes.Get ( j ) ) ) == mapLinkIps.end() ) {
+                    AddIpv4Link ( mapLinkIps, node, lanNodes.Get ( j ), lanIfs[i].GetLocal(), lanIfs[j].GetLocal() );
+                }
+            }
+
+            if ( weight != infinity ) {
+                SetupOspfInterface ( node, lanIfs[i], weight, OSPF_NETWORK_BROADCAST );
+                std::cout << "[OSPF]: Node [" << name << "]: interface " << lanIfs[i].GetLocal() << ": metric = " << weight << std::endl;
+            }
+            ++i;
+        }
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -1149,11 +1238,13 @@ void DumpIfConfig (
 #define HELP_DEBUG           "Set debug mode"
 #define HELP_QUAGGA          "Set debug mode (quagga)"
 #define HELP_ROUTES          "Output route every 10s if set to true"
-#define HELP_IGP             "Path to an input CSV file (router_src,router_dst,network,metric) describing the IGP network topology"
+#define HELP_IGP             "Path to an input CSV file (router_src,router_dst,network,metric) describing the IGP network topology. A line 'lan name router_1 metric_1 router_2 metric_2 ...' describes a broadcast LAN segment"
 #define HELP_EBGP            "Path to an input CSV file (border_router,prefix) describing the concurrent quasi-equivalent eBGP routes"
 #define HELP_IBGP            "Path to an input CSV file (router_src,router_dst,UP|OVER|DOWN) where DOWN stands for a RR-to-client iBGP session, OVER for a legacy iBGP session"
 #define HELP_IBGP_MODE       "Set the iBGP topology: 0 = iBGP full mesh, 1 = Route Reflection (requires --ibgp), 2 = iBGPv2. Default: 2"
+#define HELP_OSPF_PTP        "Configure the IGP links as OSPF point-to-point links (no DR/BDR election, faster IGP convergence) if set to true, as broadcast links otherwise. Default: true"
 #define HELP_ROUTES_INTERVAL "Specify the interval (in seconds) between each route dump (see ns3/source/ns-3-dce/routes_*.log). If set to 0, no route dump is performed. Default: 0"
+#define HELP_IBGP2_STATS     "Path to an output CSV file (router_id,metric,bin_start,value) where the counters and histograms of each iBGP2 daemon are written at the end of the simulation (requires --ibgpMode=2). Default: none"
 
 typedef enum {
     IBGP_FM = 0,
@@ -1170,7 +1261,8 @@ int main ( int argc, char *argv[] ) {
     bool     debugQuagga   = false;
     double   routeInterval = DEFAULT_ROUTE_INTERVAL;
     int      ibgpMode      = IBGP_V2;
-    std::string filenameIbgp, filenameIgp, filenameEbgp;
+    bool     ospfPtp       = true;
+    std::string filenameIbgp, filenameIgp, filenameEbgp, filenameIbgp2Stats;
 
     CommandLine cmd;
     cmd.AddValue ( "bgpdStartTime",  HELP_BGPD_START_TIME,  bgpdStartTime );
@@ -1183,6 +1275,8 @@ int main ( int argc, char *argv[] ) {
     cmd.AddValue ( "ibgp",           HELP_IBGP,            filenameIbgp );
     cmd.AddValue ( "ibgpMode",       HELP_IBGP_MODE,       ibgpMode );
     cmd.AddValue ( "ebgp",           HELP_EBGP,            filenameEbgp );
+    cmd.AddValue ( "ospfPtp",        HELP_OSPF_PTP,        ospfPtp );
+    cmd.AddValue ( "ibgp2Stats",     HELP_IBGP2_STATS,     filenameIbgp2Stats );
     cmd.Parse ( argc, argv );
 
     if ( verbose ) {
@@ -1208,6 +1302,7 @@ int main ( int argc, char *argv[] ) {
     // Count the number of routers listed in the input IGP topology.
     NodeContainer nodes1;
     IgpLinks igpLinks;
+    IgpLans igpLans;
     {
         std::ifstream ifsIgp ( filenameIgp );
         if ( !ifsIgp ) {
@@ -1216,7 +1311,7 @@ int main ( int argc, char *argv[] ) {
         }
 
         std::cout << "Reading IGP topology [" << filenameIgp << ']' << std::endl;
-        nodes1 = ParseIgpFile ( ifsIgp, igpLinks );
+        nodes1 = ParseIgpFile ( ifsIgp, igpLinks, igpLans );
         ifsIgp.close();
     }
 
@@ -1260,11 +1355,19 @@ int main ( int argc, char *argv[] ) {
     ptp.SetDeviceAttribute ( "DataRate", StringValue ( "5Mbps" ) );
     ptp.SetChannelAttribute ( "Delay", StringValue ( "2ms" ) );
 
+    CsmaHelper csma;
+    csma.SetChannelAttribute ( "DataRate", StringValue ( "100Mbps" ) );
+    csma.SetChannelAttribute ( "Delay", StringValue ( "2ms" ) );
+
     // Build IGP topology intern to AS1
     MapLinkIps mapLinkIps;
     {
         Ipv4AddressHelper ipv4AddressHelper = MakeIpv4AddressHelper ( as1IgpPrefix );
-        BuildOspfTopology ( ipv4AddressHelper, ptp, igpLinks, mapLinkIps );
+        BuildOspfTopology (
+            ipv4AddressHelper, ptp, igpLinks, mapLinkIps,
+            ospfPtp ? OSPF_NETWORK_POINT_TO_POINT : OSPF_NETWORK_BROADCAST,
+            csma, igpLans
+        );
     }
 
     FixMtu ( nodes );
@@ -1422,6 +1525,11 @@ int main ( int argc, char *argv[] ) {
     Simulator::Stop ( Seconds ( stopTime ) );
     Simulator::Run();
 
+    if ( ibgpMode == IBGP_V2 && filenameIbgp2Stats.size() ) {
+        std::ofstream ofsStats ( filenameIbgp2Stats );
+        ibgp2dHelper.DumpStatsCsv ( ofsStats );
+    }
+
     /*
     if ( ibgpMode == IBGP_V2 ) {
         // At the end of the simulation, draw the IGP graph of each routers
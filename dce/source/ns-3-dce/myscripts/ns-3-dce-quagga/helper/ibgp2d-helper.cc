@@ -119,9 +119,14 @@ std::ostream & Ibgp2dHelper::WriteIgpGraphvizImpl(
 ) const {
     NS_LOG_FUNCTION ( this );
     Ptr<Ibgp2d> ibgp2d = node.GetApplication(indexApplication)->GetObject<Ibgp2d>();
-    const OspfGraphHelper * ospfGraphHelper = ibgp2d->GetOspfGraphHelper();
-    if (!ospfGraphHelper) return out;
-    ospfGraphHelper->WriteGraphviz (out, drawNetworks);
+
+    // One graph per OSPF area the node belongs to.
+    std::vector<Ipv4Address> areaIds;
+    ibgp2d->GetAreaIds (areaIds);
+    for (const Ipv4Address & areaId : areaIds) {
+        const OspfGraphHelper * ospfGraphHelper = ibgp2d->GetOspfGraphHelper (areaId);
+        ospfGraphHelper->WriteGraphviz (out, drawNetworks);
+    }
 
     return out;
 }
@@ -150,4 +155,14 @@ std::ostream & Ibgp2dHelper::DumpIgpGraphviz(
     return out;
 }
 
+std::ostream & Ibgp2dHelper::DumpStatsCsv (std::ostream & out) const {
+    NS_LOG_FUNCTION ( this );
+    Ibgp2dStats::WriteCsvHeader (out);
+    for (const auto & p : this->mapNodeApplication) {
+        Ptr<Ibgp2d> ibgp2d = p.first->GetApplication(p.second)->GetObject<Ibgp2d>();
+        ibgp2d->GetStats().WriteCsv (out, ibgp2d->GetRouterId());
+    }
+    return out;
+}
+
 } //namespace ns3
@@ -146,6 +146,15 @@ public:
         bool drawNetworks = false
     ) const;
 
+    /**
+     * @brief Dump in CSV the counters and histograms of the managed Nodes
+     *   (see Ibgp2dStats::WriteCsv).
+     * @param out The output stream.
+     * @returns The output stream.
+     */
+
+    std::ostream & DumpStatsCsv (std::ostream & out) const;
+
 };
 
 } // namespace ns3
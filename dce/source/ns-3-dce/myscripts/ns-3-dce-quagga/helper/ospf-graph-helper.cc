@@ -31,6 +31,7 @@
 #include "ns3/log.h"                        // ns3::NS_LOG
 #include "ns3/ospf-graph.h"                 // ns3::OspfGraph
 #include "ns3/ospf-packet.h"                // ns3::LsaType
+#include "ns3/simulator.h"                  // ns3::Simulator
 
 namespace ns3
 {
@@ -39,7 +40,9 @@ NS_LOG_COMPONENT_DEFINE ("OspfGraphHelper");
 
 
 OspfGraphHelper::OspfGraphHelper () :
-    m_gbOspf (m_gospf)
+    m_gbOspf (m_gospf),
+    m_version (0),
+    m_numLsasChanged (0)
 {
     NS_LOG_FUNCTION (this);
 }
@@ -56,13 +59,8 @@ std::ostream & OspfGraphHelper::WriteGraphviz (
     std::cout << "Router ID: " << this->m_routerId << std::endl; // DEBUG
     out << "digraph ospf_graph {" << std::endl;
 
-    // Print vertices corresponding to networks
+    // Print vertices corresponding to external networks
     if (drawNetworks) {
-        for (const auto & network : this->m_mapOspfNetworks) {
-            const uint32_t & networkInt = network.first.Get();
-            out << "\t" << networkInt << " [label=\"" << network.first << "\"]" << std::endl;
-        }
-
         for (const auto & p : this->m_mapExternalNetworks) {
             const std::set<nid_t> & networks = p.second;
             for (const auto & network : networks) {
@@ -70,12 +68,23 @@ std::ostream & OspfGraphHelper::WriteGraphviz (
                 out << "\t" << networkInt << " [label=\"" << network << "\"]" << std::endl;
             }
         }
+
+        for (const auto & p : this->m_mapNetworkSummaries) {
+            for (const auto & network : p.second) {
+                const uint32_t & networkInt = network.first.Get();
+                out << "\t" << networkInt << " [label=\"" << network.second << "\", style=dashed]" << std::endl;
+            }
+        }
     }
 
-    // Print vertices corresponding to routers
+    // Print vertices corresponding to routers (and networks)
     BOOST_FOREACH (const vd_t & vd, boost::vertices(m_gospf)) {
         const vb_t & vb = m_gospf[vd];
-        out << "\t" << vd << " [label=\"" << vb.GetRouterId() << "\"]" << std::endl;
+        if (!vb.IsNetwork()) {
+            out << "\t" << vd << " [label=\"" << vb.GetRouterId() << "\"]" << std::endl;
+        } else if (drawNetworks) {
+            out << "\t" << vd << " [label=\"" << vb.GetRouterId() << "\", shape=box]" << std::endl;
+        }
     }
 
     // Print OSPF arcs (either router->router, either router->network depending on drawNetworks)
@@ -84,16 +93,32 @@ std::ostream & OspfGraphHelper::WriteGraphviz (
         const vd_t
         & vd_u = boost::source(ed, m_gospf),
           & vd_v = boost::target(ed, m_gospf);
+        const ospf::metric_t metric = eb.GetDistance();
 
-        for (const auto & d : eb.GetDistances()) {
-            const uint32_t & networkAddress = d.first.Get ();
-            const ospf::metric_t & metric = d.second;
-            if (drawNetworks) {
-                out << "\t" << vd_u << " -> " << networkAddress << " [label=\"" << metric << "\"]" << std::endl
-                    << "\t" << networkAddress << " -> " << vd_v << " [label=\"" << metric << "\"]" << std::endl;
-            } else {
+        if (drawNetworks || !m_gospf[vd_v].IsNetwork()) {
+            if (drawNetworks || !m_gospf[vd_u].IsNetwork()) {
                 out << "\t" << vd_u << " -> " << vd_v << " [label=\"" << metric << "\"]" << std::endl;
             }
+        } else {
+            // Replace the network by an arc toward each of its other routers.
+            BOOST_FOREACH(const ed_t & ed_vw, boost::out_edges(vd_v, m_gospf)) {
+                const vd_t & vd_w = boost::target(ed_vw, m_gospf);
+                if (vd_w != vd_u) {
+                    out << "\t" << vd_u << " -> " << vd_w << " [label=\"" << metric << "\"]" << std::endl;
+                }
+            }
+        }
+    }
+
+    // Print the networks of the other areas, announced by the ABRs.
+    if (drawNetworks) {
+        for (const auto & p : this->m_mapNetworkSummaries) {
+            std::pair<vd_t, bool> abr = this->GetVertex (p.first);
+            if (!abr.second) continue;
+
+            for (const auto & network : p.second) {
+                out << "\t" << abr.first << " -> " << network.first.Get() << " [style=dashed]" << std::endl;
+            }
         }
     }
     out << "}" << std::endl;
@@ -101,131 +126,452 @@ std::ostream & OspfGraphHelper::WriteGraphviz (
     return out;
 }
 
-bool OspfGraphHelper::HandleLsa (std::vector<OspfLsa *> & lsas) {
+ospf::OspfChangeSet OspfGraphHelper::HandleLsa (const std::vector<ospf::OspfLsaView> & lsas) {
     NS_LOG_FUNCTION (this);
-    bool changed = false;
+    this->m_changes.Clear();
+
+    // Withdraw the LSAs which have not been refreshed.
+    Time now = Simulator::Now();
+    std::vector<ospf::OspfLsdb::Key> keysExpired;
+    this->m_lsdb.Expire (now, keysExpired);
+    for (const ospf::OspfLsdb::Key & key : keysExpired) {
+        NS_LOG_LOGIC ("\tLSA aged out (advertising router: " << key.advertisingRouter << ")");
+        this->FlushLsa (key);
+    }
 
-    for (OspfLsa * lsa : lsas) {
-        switch (lsa->GetLsaType()) {
+    for (const ospf::OspfLsaView & lsa : lsas) {
+        std::size_t numAlterations = this->m_changes.GetNumAlterations();
+
+        // Copies flooded on several interfaces, retransmissions and
+        // refreshes are filtered by the LSDB.
+        switch (this->m_lsdb.Install (lsa, now)) {
+            case ospf::OspfLsdb::LSA_DISCARDED:
+            case ospf::OspfLsdb::LSA_REFRESHED:
+                continue;
+            case ospf::OspfLsdb::LSA_FLUSHED:
+                this->FlushLsa (ospf::OspfLsdb::Key (lsa));
+                if (this->m_changes.GetNumAlterations() != numAlterations) ++this->m_numLsasChanged;
+                continue;
+            case ospf::OspfLsdb::LSA_CHANGED:
+                break;
+        }
+
+        switch (lsa.GetLsaType()) {
             case OSPF_LSA_TYPE_ROUTER:
-                changed |= this->HandleLsr (*(dynamic_cast<OspfRouterLsa *> (lsa)));
+                this->HandleLsr (ospf::OspfRouterLsaView (lsa));
                 break;
             case OSPF_LSA_TYPE_NETWORK:
-                changed |= this->HandleLsn (*(dynamic_cast<OspfNetworkLsa *> (lsa)));
+                this->HandleLsn (ospf::OspfNetworkLsaView (lsa));
+                break;
+            case OSPF_LSA_TYPE_SUMMARY_NETWORK:
+            case OSPF_LSA_TYPE_SUMMARY_ASBR:
+                this->HandleLss (ospf::OspfSummaryLsaView (lsa));
                 break;
             case OSPF_LSA_TYPE_EXTERNAL:
-                changed |= this->HandleLse (*(dynamic_cast<OspfExternalLsa *> (lsa)));
+                this->HandleLse (ospf::OspfExternalLsaView (lsa));
                 break;
         }
+
+        if (this->m_changes.GetNumAlterations() != numAlterations) ++this->m_numLsasChanged;
+    }
+
+    if (!this->m_changes.IsEmpty()) {
+        ++this->m_version;
+        NS_LOG_LOGIC ("\t" << this->m_changes);
+    }
+
+    return this->m_changes;
+}
+
+void OspfGraphHelper::FlushLsa (const ospf::OspfLsdb::Key & key) {
+    NS_LOG_FUNCTION (this);
+
+    switch (key.type) {
+        case OSPF_LSA_TYPE_ROUTER:
+            // The router is not connected to any network anymore.
+            this->RemoveRouter (key.advertisingRouter);
+            break;
+        case OSPF_LSA_TYPE_NETWORK:
+            // The adjacencies are only deduced from the Router LSAs, which
+            // withdraw the network on their own. The prefix of the network
+            // is kept as it may still be needed by GetTransitNetworks.
+            break;
+        case OSPF_LSA_TYPE_SUMMARY_NETWORK:
+            this->RemoveNetworkSummary (key.advertisingRouter, key.linkStateId);
+            break;
+        case OSPF_LSA_TYPE_SUMMARY_ASBR:
+            this->RemoveAsbrSummary (key.advertisingRouter, key.linkStateId);
+            break;
+        case OSPF_LSA_TYPE_EXTERNAL:
+            this->RemoveExternalNetwork (key.advertisingRouter, key.linkStateId);
+            break;
+    }
+}
+
+bool OspfGraphHelper::RemoveRouter (const OspfGraphHelper::rid_t & rid_u) {
+    NS_LOG_FUNCTION (this << rid_u);
+    bool changed = false;
+
+    // RemoveAdjacency may erase entries of m_mapOspfNetworks, so the
+    // networks are collected first.
+    this->m_nids.clear();
+    for (auto & elt : this->m_mapOspfNetworks) {
+        if (elt.second.find (rid_u) != elt.second.end()) {
+            this->m_nids.push_back (elt.first);
+        }
+    }
+
+    for (auto & nid : this->m_nids) {
+        NS_LOG_LOGIC ("\t\tRemove the network " << nid);
+        changed |= this->RemoveAdjacency (rid_u, nid);
     }
 
     return changed;
 }
 
-bool OspfGraphHelper::HandleLsr (const OspfRouterLsa & lsr)
+void OspfGraphHelper::GetLinks (
+    const ospf::OspfRouterLsaView & lsr,
+    std::vector<OspfGraphHelper::Link> & links
+) {
+    NS_LOG_FUNCTION (this);
+
+    // We consider transit networks (type: 2) and point-to-point links
+    // (type: 1), see (RFC 2328, A.4.2, p207). Note that some network may be
+    // stub and once BGPd started, become transit. In our case, transit
+    // networks are sufficient.
+
+    for (ospf::OspfRouterLsaView::LinkIterator it (lsr.GetLinks()); !it.IsEnd(); it.Next()) {
+        Link link;
+        link.nid = it.GetLinkId();
+        link.ifAddress = it.GetLinkData();
+        link.metric = it.GetMetric();
+
+        switch (it.GetType()) {
+            case OSPF_LSR_TYPE_TRANSIT:
+                // The link-id is the IP of the DR.
+                break;
+            case OSPF_LSR_TYPE_PTP:
+            {
+                // A point-to-point link has no DR (and no Network LSA): it is
+                // identified by its prefix, found in the stub link announced
+                // along with it. Both ends announce the same prefix, so the
+                // link is then handled like a transit network connecting two
+                // routers. The unnumbered links have no prefix and are ignored.
+                Ipv4Mask mask;
+                if (!lsr.GetStubNetwork (link.ifAddress, link.nid, mask)) {
+                    NS_LOG_LOGIC ("\t\tUnnumbered point-to-point link to " << it.GetLinkId() << " ignored");
+                    continue;
+                }
+
+                Ipv4Prefix prefix (link.nid, mask);
+                MapNetwork::const_iterator fit (this->m_mapNetworks.find (link.nid));
+                if (fit == this->m_mapNetworks.end() || fit->second != prefix) {
+                    this->m_mapNetworks[link.nid] = prefix;
+                    this->m_changes.ChangeNetworks();
+                }
+                break;
+            }
+            default:
+                continue;
+        }
+
+        links.push_back (link);
+    }
+}
+
+bool OspfGraphHelper::HandleLsr (const ospf::OspfRouterLsaView & lsr)
 {
-    const Ipv4Address & rid_u = lsr.GetAdvertisingRouter();
+    const Ipv4Address rid_u = lsr.GetAdvertisingRouter();
     NS_LOG_FUNCTION (this << lsr);
+    bool changed = false;
 
+    this->m_links.clear();
+    this->GetLinks (lsr, this->m_links);
+
+    // If the router annoncing (lsr->rid) is in a network, but the network
+    // is not announced in the LSR, we must remove the router from it.
+    // RemoveAdjacency may erase entries of m_mapOspfNetworks, so the
+    // networks are collected first.
+
+    this->m_nids.clear();
     for (auto & elt : this->m_mapOspfNetworks) {
         const ospf::network_id_t & nid = elt.first;
         const std::set<ospf::router_id_t> & rids = elt.second;
 
-        // If the router annoncing (lsr->rid) is in the network, but the network
-        // is not announced in the LSR, we must remove the router from it
+        if (rids.find(rid_u) == rids.end()) continue;
 
-        if (rids.find(rid_u) != rids.end() && lsr.networks.find (nid) == lsr.networks.end()) {
-            NS_LOG_LOGIC ("\t\tRemove the network " << nid);
-            RemoveAdjacency (rid_u, nid);
+        bool isAnnounced = false;
+        for (const Link & link : this->m_links) {
+            if (link.nid == nid) {
+                isAnnounced = true;
+                break;
+            }
         }
-    }
 
-    for (auto & elt : lsr.networks) {
-        const ospf::network_id_t & nid = elt.first;
-        const ospf::metric_t & metric = elt.second; // metric from u to nid
+        if (!isAnnounced) {
+            this->m_nids.push_back (nid);
+        }
+    }
 
-        std::map<ospf::network_id_t, Ipv4Address>::const_iterator it_if = lsr.ifs.find(nid);
+    for (auto & nid : this->m_nids) {
+        NS_LOG_LOGIC ("\t\tRemove the network " << nid);
+        changed |= RemoveAdjacency (rid_u, nid);
+    }
 
-        Ipv4Address if_u = (it_if != lsr.ifs.end()) ?
-            it_if->second :
-            Ipv4Address ("69.69.69.69");
+    for (const Link & link : this->m_links) {
+        NS_LOG_DEBUG ("\t\t" << link.nid << ": " << link.metric);
+        NS_LOG_DEBUG ("\t\tinterface: " << link.ifAddress);
 
-        NS_LOG_DEBUG ("\t\t" << nid << ": " << metric);
-        NS_LOG_DEBUG ("\t\tinterface: " << if_u);
+        changed |= this->AddAdjacency (rid_u, link.nid, link.ifAddress, link.metric);
+    }
 
-        // Search (network, router) pair in this->ospfNetworks
-        // TODO to improve
-////////////////// << DUPLICATED AddOspfArc(rid, nid, metric, false)
-        for (auto & rid_v : this->m_mapOspfNetworks[nid]) {
-            if (rid_v == rid_u) {
-                continue;
-            }
+    return changed;
+}
 
-            // For each router in the network, we add an edge
-            this->AddAdjacency (rid_u, rid_v, nid, if_u, metric);
-            OspfGraphHelper::OspfArc arc = std::make_pair(rid_v, nid);
-            this->AddAdjacency (rid_v, rid_u, nid, this->m_mapInterfaces[arc], this->m_mapMetrics[arc]);
+bool OspfGraphHelper::HandleLsn(const ospf::OspfNetworkLsaView & lsn)
+{
+    NS_LOG_FUNCTION (this);
 
-        }
-////////////////// >> DUPLICATED
+    const Ipv4Address nid  = lsn.GetLinkStateId();
+    const Ipv4Mask    mask = lsn.GetNetworkMask();
+    Ipv4Prefix prefix (nid, mask);
 
-        // Save the information related to this network
-        this->m_mapOspfNetworks[nid].insert (rid_u);
-        this->m_mapMetrics[std::make_pair(rid_u, nid)] = metric;
-        this->m_mapInterfaces[std::make_pair(rid_u, nid)] = if_u;
+    MapNetwork::iterator fit (this->m_mapNetworks.find (nid));
+    if (fit != this->m_mapNetworks.end() && fit->second == prefix) {
+        return false;
     }
 
+    this->m_mapNetworks[nid] = prefix;
+    this->m_changes.ChangeNetworks();
     return true;
 }
 
-bool OspfGraphHelper::HandleLsn(const OspfNetworkLsa& lsn)
+bool OspfGraphHelper::HandleLse (const ospf::OspfExternalLsaView & lse)
 {
-    NS_LOG_FUNCTION (this);
+    NS_LOG_FUNCTION (this << lse);
+
+    const Ipv4Address        ridAsbr = lse.GetAdvertisingRouter();
+    const ospf::network_id_t nid     = lse.GetLinkStateId();
+    const ospf::metric_t     metric  = lse.GetMetric();
+    const Ipv4Mask           mask    = lse.GetNetworkMask();
+
+    Ipv4Prefix prefix (nid, mask);
+    OspfArc arc = std::make_pair (ridAsbr, nid);
 
-    const Ipv4Address & nid  = lsn.GetLinkStateId();
-    const Ipv4Mask    & mask = lsn.GetNetworkMask();
-    this->m_mapNetworks[nid] = Ipv4Prefix(nid, mask);
+    std::set<nid_t> & nids = this->m_mapExternalNetworks[ridAsbr];
+    MapNetwork::const_iterator fitNetwork (this->m_mapNetworks.find (nid));
+    std::map<OspfArc, OspfMetric>::const_iterator fitMetric (this->m_mapMetrics.find (arc));
+
+    bool changed = nids.find (nid) == nids.end()
+        || fitNetwork == this->m_mapNetworks.end() || fitNetwork->second != prefix
+        || fitMetric  == this->m_mapMetrics.end()  || fitMetric->second  != metric;
+
+    if (changed) {
+        this->m_mapNetworks[nid] = prefix;
+        nids.insert (nid);
+        this->m_mapMetrics[arc] = metric;
+        this->m_changes.ChangeExternals (ridAsbr);
+    }
+
+    return changed;
+}
+
+bool OspfGraphHelper::RemoveExternalNetwork (
+    const OspfGraphHelper::rid_t & rid_n,
+    const OspfGraphHelper::nid_t & nid
+) {
+    NS_LOG_FUNCTION (this << rid_n << nid);
+
+    MapExternalNetwork::iterator fit (this->m_mapExternalNetworks.find (rid_n));
+    if (fit == this->m_mapExternalNetworks.end() || !fit->second.erase (nid)) {
+        return false;
+    }
+
+    if (fit->second.empty()) {
+        this->m_mapExternalNetworks.erase (fit);
+    }
+
+    this->m_mapMetrics.erase (std::make_pair (rid_n, nid));
+    this->m_changes.ChangeExternals (rid_n);
     return true;
 }
 
-bool OspfGraphHelper::HandleLse (const OspfExternalLsa & lse)
+bool OspfGraphHelper::HandleLss (const ospf::OspfSummaryLsaView & lss)
 {
-    NS_LOG_FUNCTION (this << lse);
+    NS_LOG_FUNCTION (this << lss);
+
+    const Ipv4Address        rid_abr = lss.GetAdvertisingRouter();
+    const Ipv4Address        lsid    = lss.GetLinkStateId();
+    const ospf::metric_t     metric  = lss.GetMetric();
+
+    if (lss.GetLsaType() == OSPF_LSA_TYPE_SUMMARY_NETWORK) {
+        if (metric == OSPF_LS_INFINITY) {
+            return this->RemoveNetworkSummary (rid_abr, lsid);
+        }
+
+        // The inter-area networks do not alter the iBGP2 redistribution,
+        // so they are not reported in the change set.
+        Ipv4Prefix prefix (lsid, lss.GetNetworkMask());
+        MapNetwork & networks = this->m_mapNetworkSummaries[rid_abr];
+        MapNetwork::const_iterator fit (networks.find (lsid));
+        if (fit != networks.end() && fit->second == prefix) {
+            return false;
+        }
+
+        networks[lsid] = prefix;
+        return true;
+    }
+
+    // The ASBR is not reachable anymore through this ABR.
+    if (metric == OSPF_LS_INFINITY || rid_abr == lsid) {
+        return this->RemoveAsbrSummary (rid_abr, lsid);
+    }
 
-    const Ipv4Address        & ridAsbr = lse.GetAdvertisingRouter();
-    const ospf::network_id_t & nid     = lse.GetLinkStateId();
-    const ospf::metric_t     & metric  = lse.GetMetric();
-    const Ipv4Mask           & mask    = lse.GetNetworkMask();
+    // The ASBR is attached to the ABR through an arc whose network
+    // identifier is the router-id of the ASBR. This arc is repaired like
+    // any other arc by the incremental SPF.
+    this->m_mapAsbrSummaries[rid_abr].insert (lsid);
+    return this->AddAdjacency (rid_abr, lsid, lsid, Ipv4Address::GetAny(), metric);
+}
+
+bool OspfGraphHelper::RemoveAsbrSummary (
+    const OspfGraphHelper::rid_t & rid_abr,
+    const OspfGraphHelper::rid_t & rid_asbr
+) {
+    NS_LOG_FUNCTION (this << rid_abr << rid_asbr);
+
+    MapAsbrSummary::iterator fit (this->m_mapAsbrSummaries.find (rid_abr));
+    if (fit == this->m_mapAsbrSummaries.end() || !fit->second.erase (rid_asbr)) {
+        return false;
+    }
+
+    if (fit->second.empty()) {
+        this->m_mapAsbrSummaries.erase (fit);
+    }
+
+    return this->RemoveAdjacency (rid_abr, rid_asbr, rid_asbr);
+}
+
+bool OspfGraphHelper::RemoveNetworkSummary (
+    const OspfGraphHelper::rid_t & rid_abr,
+    const OspfGraphHelper::nid_t & nid
+) {
+    NS_LOG_FUNCTION (this << rid_abr << nid);
 
-    this->m_mapNetworks[nid] = Ipv4Prefix(nid, mask);
-    this->m_mapExternalNetworks[ridAsbr].insert(nid);
-    this->m_mapMetrics[std::make_pair (ridAsbr, nid)] = metric;
+    MapNetworkSummary::iterator fit (this->m_mapNetworkSummaries.find (rid_abr));
+    if (fit == this->m_mapNetworkSummaries.end() || !fit->second.erase (nid)) {
+        return false;
+    }
+
+    if (fit->second.empty()) {
+        this->m_mapNetworkSummaries.erase (fit);
+    }
 
     return true;
 }
 
+bool OspfGraphHelper::HasAsbrSummary (
+    const OspfGraphHelper::rid_t & rid_abr,
+    const OspfGraphHelper::rid_t & rid_asbr
+) const {
+    MapAsbrSummary::const_iterator fit (this->m_mapAsbrSummaries.find (rid_abr));
+    return fit != this->m_mapAsbrSummaries.end()
+        && fit->second.find (rid_asbr) != fit->second.end();
+}
+
 const ospf::OspfGraph & OspfGraphHelper::GetGraph () const {
     NS_LOG_FUNCTION (this);
     return this->m_gospf;
 }
 
+uint32_t OspfGraphHelper::GetVersion () const {
+    NS_LOG_FUNCTION (this);
+    return this->m_version;
+}
+
+uint64_t OspfGraphHelper::GetNumLsasChanged () const {
+    NS_LOG_FUNCTION (this);
+    return this->m_numLsasChanged;
+}
+
 std::pair<OspfGraphHelper::vd_t, bool> OspfGraphHelper::GetVertex (const OspfGraphHelper::rid_t & rid) const {
     NS_LOG_FUNCTION (this);
     return m_gbOspf.get_vertex (rid);
 }
 
+std::pair<OspfGraphHelper::vd_t, bool> OspfGraphHelper::GetNetworkVertex (const OspfGraphHelper::nid_t & nid) const {
+    NS_LOG_FUNCTION (this);
+
+    std::map<nid_t, vd_t>::const_iterator fit (this->m_mapNetworkVertices.find (nid));
+    if (fit == this->m_mapNetworkVertices.end()) {
+        return std::make_pair (vd_t(), false);
+    }
+
+    return std::make_pair (fit->second, true);
+}
+
+OspfGraphHelper::vd_t OspfGraphHelper::AddNetworkVertex (const OspfGraphHelper::nid_t & nid) {
+    NS_LOG_FUNCTION (this << nid);
+
+    // The network vertices are not stored in m_gbOspf, whose dictionary is
+    // keyed by router-ids: the DR and its network share the same address.
+    std::map<nid_t, vd_t>::const_iterator fit (this->m_mapNetworkVertices.find (nid));
+    if (fit != this->m_mapNetworkVertices.end()) {
+        return fit->second;
+    }
+
+    vd_t vd = boost::add_vertex (vb_t (nid, true), this->m_gospf);
+    this->m_mapNetworkVertices[nid] = vd;
+    return vd;
+}
+
+void OspfGraphHelper::GetSharedNetworks (
+    const OspfGraphHelper::rid_t & rid_u,
+    const OspfGraphHelper::rid_t & rid_v,
+    std::vector<OspfGraphHelper::nid_t> & nids
+) const {
+    // The networks of u are found in m_mapMetrics, sorted by (router-id,
+    // network). It also stores the external networks of the ASBRs, which
+    // do not belong to m_mapOspfNetworks.
+    std::map<OspfArc, OspfMetric>::const_iterator
+        it  (this->m_mapMetrics.lower_bound (std::make_pair (rid_u, Ipv4Address::GetAny()))),
+        end (this->m_mapMetrics.end());
+
+    for (; it != end && it->first.first == rid_u; ++it) {
+        const nid_t & nid = it->first.second;
+        MapOspfNetwork::const_iterator fit (this->m_mapOspfNetworks.find (nid));
+        if (fit == this->m_mapOspfNetworks.end()) continue;
+
+        const std::set<rid_t> & rids = fit->second;
+        if (rids.find (rid_u) != rids.end() && rids.find (rid_v) != rids.end()) {
+            nids.push_back (nid);
+        }
+    }
+}
+
 const Ipv4Address & OspfGraphHelper::GetInterface(
     const OspfGraphHelper::rid_t & rid_u,
     const OspfGraphHelper::rid_t & rid_v
 ) const {
     NS_LOG_FUNCTION (this);
 
-    ed_t ed;
-    bool ok;
-    boost::tie (ed, ok) = this->m_gbOspf.get_edge (rid_u, rid_v);
-    NS_ASSERT(ok);
+    std::vector<nid_t> nids;
+    this->GetSharedNetworks (rid_u, rid_v, nids);
+    NS_ASSERT(!nids.empty());
+
+    // Keep the network having the lowest metric from u.
+    const Ipv4Address * ifAddress = NULL;
+    OspfMetric metricBest = 0;
+    for (const nid_t & nid : nids) {
+        OspfArc arc (rid_u, nid);
+        const OspfMetric & metric = this->m_mapMetrics.find (arc)->second;
+        if (!ifAddress || metric < metricBest) {
+            ifAddress = &this->m_mapInterfaces.find (arc)->second;
+            metricBest = metric;
+        }
+    }
 
-    return this->m_gospf[ed].GetInterface ();
+    return *ifAddress;
 }
 
 bool OspfGraphHelper::GetNetwork(const nid_t & nid, Ipv4Prefix & network) const {
@@ -241,16 +587,13 @@ bool OspfGraphHelper::GetTransitNetworks(
     const OspfGraphHelper::rid_t& rid_v,
     std::set< Ipv4Prefix >& transitNetworks
 ) const {
-    // Find the edge from u to v
-    bool found;
-    ed_t e_uv;
-    boost::tie(e_uv, found) = this->m_gbOspf.get_edge(rid_u, rid_v);
-    if (!found) return false;
+    // Find the networks shared by u and v
+    std::vector<nid_t> nids;
+    this->GetSharedNetworks (rid_u, rid_v, nids);
+    if (nids.empty()) return false;
 
     // For each of the corresponding network identifier, retrieve the corresponding prefix
-    const ospf::OspfEdge::MapDistances & distances = this->m_gospf[e_uv].GetDistances();
-    for (auto & nm : distances) {
-        const nid_t & nid = nm.first;
+    for (const nid_t & nid : nids) {
         Ipv4Prefix prefix;
         bool found = this->GetNetwork(nid, prefix);
         NS_ASSERT(found);
@@ -282,6 +625,39 @@ bool OspfGraphHelper::GetExternalNetworks (
     return true;
 }
 
+void OspfGraphHelper::GetAsbrs (std::vector<OspfGraphHelper::rid_t> & asbrs) const {
+    NS_LOG_FUNCTION (this);
+
+    for (auto & elt : this->m_mapExternalNetworks) {
+        if (!elt.second.empty()) {
+            asbrs.push_back (elt.first);
+        }
+    }
+}
+
+bool OspfGraphHelper::AddAdjacency (
+    const OspfGraphHelper::rid_t      & rid_u,
+    const OspfGraphHelper::nid_t      & nid,
+    const Ipv4Address                 & if_u,
+    const OspfGraphHelper::OspfMetric & m_un
+) {
+    NS_LOG_FUNCTION (this);
+
+    vd_t vd_u = this->m_gbOspf.add_vertex (rid_u, vb_t (rid_u));
+    vd_t vd_n = this->AddNetworkVertex (nid);
+
+    // The arcs from a network to its routers have a null metric (RFC 2328, 16.1).
+    bool changed = this->AddArc (vd_u, vd_n, nid, if_u, m_un);
+    changed |= this->AddArc (vd_n, vd_u, nid, Ipv4Address::GetAny(), 0);
+
+    // Save the information related to this network
+    this->m_mapOspfNetworks[nid].insert (rid_u);
+    this->m_mapMetrics[std::make_pair(rid_u, nid)] = m_un;
+    this->m_mapInterfaces[std::make_pair(rid_u, nid)] = if_u;
+
+    return changed;
+}
+
 bool OspfGraphHelper::AddAdjacency (
     const OspfGraphHelper::rid_t      & rid_u,
     const OspfGraphHelper::rid_t      & rid_v,
@@ -291,19 +667,50 @@ bool OspfGraphHelper::AddAdjacency (
 ) {
     NS_LOG_FUNCTION (this);
 
+    vd_t vd_u = this->m_gbOspf.add_vertex (rid_u, vb_t (rid_u));
+    vd_t vd_v = this->m_gbOspf.add_vertex (rid_v, vb_t (rid_v));
+    return this->AddArc (vd_u, vd_v, nid, if_u, m_uv);
+}
+
+bool OspfGraphHelper::AddArc (
+    OspfGraphHelper::vd_t               vd_u,
+    OspfGraphHelper::vd_t               vd_v,
+    const OspfGraphHelper::nid_t      & nid,
+    const Ipv4Address                 & if_u,
+    const OspfGraphHelper::OspfMetric & m_uv
+) {
+    NS_LOG_FUNCTION (this);
+
     ed_t ed;
     bool ok;
-    boost::tie (ed, ok) = this->m_gbOspf.get_edge (rid_u, rid_v);
+    boost::tie (ed, ok) = boost::edge (vd_u, vd_v, this->m_gospf);
 
     if (ok) {
         // The arc already exists, we just add/update the new network
-        this->m_gospf[ed].SetMetric(nid, m_uv);
-        this->m_gospf[ed].SetInterface(nid, if_u);
+        eb_t & eb = this->m_gospf[ed];
+        const eb_t::MapDistances & distances = eb.GetDistances();
+        const eb_t::MapInterfaces & interfaces = eb.GetInterfaces();
+        eb_t::MapDistances::const_iterator fitDistance (distances.find (nid));
+        eb_t::MapInterfaces::const_iterator fitInterface (interfaces.find (nid));
+
+        if (fitDistance  != distances.end()  && fitDistance->second  == m_uv
+        &&  fitInterface != interfaces.end() && fitInterface->second == if_u) {
+            return false;
+        }
+
+        ospf::metric_t distancePrev = eb.GetDistance();
+        eb.SetMetric(nid, m_uv);
+        eb.SetInterface(nid, if_u);
+
+        if (eb.GetDistance() != distancePrev) {
+            this->m_changes.ChangeMetric (vd_u, vd_v);
+        }
+        this->m_changes.ChangeNetworks();
     } else {
         // The arc doesn't yet exist, we create it.
-        this->m_gbOspf.add_vertex (rid_u, vb_t(rid_u));
-        this->m_gbOspf.add_vertex (rid_v, vb_t(rid_v));
-        this->m_gbOspf.add_edge (rid_u, rid_v, eb_t (nid, if_u, m_uv));
+        boost::add_edge (vd_u, vd_v, eb_t (nid, if_u, m_uv), this->m_gospf);
+        this->m_changes.AddArc (vd_u, vd_v);
+        this->m_changes.ChangeNetworks();
     }
 
     return true;
@@ -315,24 +722,26 @@ bool OspfGraphHelper::RemoveAdjacency (
 ) {
     NS_LOG_FUNCTION (this);
 
-    this->m_mapOspfNetworks[nid].erase (rid_u);
+    MapOspfNetwork::iterator fit (this->m_mapOspfNetworks.find (nid));
+    if (fit == this->m_mapOspfNetworks.end() || !fit->second.erase (rid_u)) {
+        return false;
+    }
 
-    if (this->m_mapOspfNetworks[nid].empty ()) {
-        this->m_mapOspfNetworks.erase (nid);
-    } else {
-        for (auto & rid_v : this->m_mapOspfNetworks[nid]) {
-            this->RemoveAdjacency (rid_u, rid_v, nid);
-            this->RemoveAdjacency (rid_v, rid_u, nid);
-
-            // Removing a vertex invalidates our vertex_descriptors and will break
-            // graph_builder mapping, so even if the out-degree of u (resp v)
-            // is now equal to 0, we cannot remove the corresponding vertex from
-            // the boost graph.
-            // http://www.boost.org/doc/libs/1_38_0/libs/graph/doc/adjacency_list.html
-        }
+    if (fit->second.empty ()) {
+        this->m_mapOspfNetworks.erase (fit);
     }
 
-    return true;
+    // Removing a vertex invalidates our vertex_descriptors and will break
+    // graph_builder mapping, so even if the network has no more router,
+    // we cannot remove the corresponding vertex from the boost graph.
+    // http://www.boost.org/doc/libs/1_38_0/libs/graph/doc/adjacency_list.html
+    std::pair<vd_t, bool> u = this->GetVertex (rid_u);
+    std::pair<vd_t, bool> n = this->GetNetworkVertex (nid);
+    NS_ASSERT (u.second && n.second);
+
+    bool changed = this->RemoveArc (u.first, n.first, nid);
+    changed |= this->RemoveArc (n.first, u.first, nid);
+    return changed;
 }
 
 bool OspfGraphHelper::RemoveAdjacency (
@@ -342,19 +751,47 @@ bool OspfGraphHelper::RemoveAdjacency (
 ) {
     NS_LOG_FUNCTION (this);
 
+    std::pair<vd_t, bool> u = this->GetVertex (rid_u);
+    std::pair<vd_t, bool> v = this->GetVertex (rid_v);
+    if (!u.second || !v.second) {
+        return false;
+    }
+
+    return this->RemoveArc (u.first, v.first, nid);
+}
+
+bool OspfGraphHelper::RemoveArc (
+    OspfGraphHelper::vd_t          vd_u,
+    OspfGraphHelper::vd_t          vd_v,
+    const OspfGraphHelper::nid_t & nid
+) {
+    NS_LOG_FUNCTION (this);
+
     ed_t ed;
     bool ok;
-    boost::tie (ed, ok) = this->m_gbOspf.get_edge (rid_u, rid_v);
+    boost::tie (ed, ok) = boost::edge (vd_u, vd_v, this->m_gospf);
 
-    if (ok) {
-        NS_LOG_LOGIC ("\t\t\t\tRemove " << nid << " on " << rid_u << " -> " << rid_v);
-        this->m_gospf[ed].DeleteNetwork(nid);
+    if (!ok) {
+        return false;
+    }
 
-        // The both routers don't share networks anymore, we remove the arc.
-        if (this->m_gospf[ed].GetNumNetworks() == 0) {
-            NS_LOG_LOGIC ("\t\t\t\tRemove " << rid_u << " -> " << rid_v);
-            this->m_gbOspf.remove_edge (rid_u, rid_v);
-        }
+    eb_t & eb = this->m_gospf[ed];
+    if (eb.GetDistances().find (nid) == eb.GetDistances().end()) {
+        return false;
+    }
+
+    NS_LOG_LOGIC ("\t\t\t\tRemove " << nid << " on " << m_gospf[vd_u] << " -> " << m_gospf[vd_v]);
+    ospf::metric_t distancePrev = eb.GetDistance();
+    eb.DeleteNetwork(nid);
+    this->m_changes.ChangeNetworks();
+
+    // The both vertices don't share networks anymore, we remove the arc.
+    if (eb.GetNumNetworks() == 0) {
+        NS_LOG_LOGIC ("\t\t\t\tRemove " << m_gospf[vd_u] << " -> " << m_gospf[vd_v]);
+        boost::remove_edge (vd_u, vd_v, this->m_gospf);
+        this->m_changes.RemoveArc (vd_u, vd_v);
+    } else if (eb.GetDistance() != distancePrev) {
+        this->m_changes.ChangeMetric (vd_u, vd_v);
     }
 
     return true;
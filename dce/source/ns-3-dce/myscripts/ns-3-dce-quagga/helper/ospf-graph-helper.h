@@ -31,7 +31,10 @@
 #include "ns3/object.h"         // ns3::Object
 
 #include "../model/ospf-graph/graph-builder.h"  // ns3::ospf::OspfGraphBuilder
+#include "../model/ospf-graph/ospf-change-set.h" // ns3::ospf::OspfChangeSet
 #include "../model/ospf-graph/ospf-graph.h"     // ns3::ospf::OspfGraph
+#include "../model/ospf-graph/ospf-lsa-view.h"  // ns3::ospf::Ospf*LsaView
+#include "../model/ospf-graph/ospf-lsdb.h"      // ns3::ospf::OspfLsdb
 #include "../model/ospf-graph/graph-builder.h"  // ns3::ospf::OspfGraph
 
 namespace ns3
@@ -39,6 +42,23 @@ namespace ns3
 
 /**
  * @brief Help to manage an OspfGraph.
+ *
+ * The OspfGraph describes a single OSPF area: the Router and Network LSAs
+ * are scoped to their area, so the LSAs sniffed in distinct areas must be
+ * handled by distinct OspfGraphHelper instances. The routers of the other
+ * areas only appear through the Summary LSAs originated by the area
+ * border routers (ABRs):
+ * - an ASBR Summary LSA is modeled by an arc from the ABR to the ASBR,
+ *   weighted by the metric announced by the ABR. The shortest paths toward
+ *   an ASBR of another area thus cross the closest ABR, like the OSPF
+ *   inter-area routes (RFC 2328, 16.2).
+ * - a Network Summary LSA is only recorded (see WriteGraphviz), since the
+ *   BGP nexthops are assumed to belong to external networks.
+ *
+ * Inside the area, each transit network (and each numbered point-to-point
+ * link) is a vertex of the OspfGraph, connected to each of its routers
+ * like in the SPF of RFC 2328 (16.1): a LAN connecting k routers costs 2k
+ * arcs instead of the k(k - 1) arcs of a full mesh.
  */
 
 class OspfGraphHelper :
@@ -63,15 +83,28 @@ public:
     typedef std::pair<rid_t, nid_t>             OspfArc;        /**< Metrics are assigned from a node to a connected network (arc). */
     typedef ospf::metric_t                      OspfMetric;     /**< Metric assigned to an OspfArc. */
 
-    typedef std::map<nid_t, std::set<rid_t> >   MapOspfNetwork; // TODO TO REMOVE
+    typedef std::map<nid_t, std::set<rid_t> >   MapOspfNetwork;
     typedef std::map<nid_t, Ipv4Prefix>         MapNetwork;
     typedef std::map<rid_t, std::set<nid_t> >   MapExternalNetwork;
+    typedef std::map<rid_t, std::set<rid_t> >   MapAsbrSummary;     /**< Maps each ABR with the ASBRs it announces. */
+    typedef std::map<rid_t, MapNetwork>         MapNetworkSummary;  /**< Maps each ABR with the inter-area networks it announces. */
 
 private:
 
+    /**
+     * @brief Network announced in a Router LSA.
+     */
+
+    struct Link {
+        nid_t                           nid;        /**< The IP of the DR (transit network) or the prefix of the link (point-to-point link). */
+        Ipv4Address                     ifAddress;  /**< The interface of the advertising router connected to this network. */
+        OspfMetric                      metric;     /**< The metric from the advertising router to this network. */
+    };
+
     ospf::router_id_t                   m_routerId; //!< OSPF router ID // TODO to remove DEBUG
 
-    MapOspfNetwork                      m_mapOspfNetworks;      /**< List of networks that are ospf links and the routers that are part of them. */ // TODO to remove
+    MapOspfNetwork                      m_mapOspfNetworks;      /**< List of networks that are ospf links and the routers that are part of them. */
+    std::map<nid_t, vd_t>               m_mapNetworkVertices;   /**< Vertex of each network in m_gospf (m_gbOspf only maps the routers). */
 
     std::map<OspfArc, OspfMetric>       m_mapMetrics;           /**< List of metrics for each OspfArc. */
     std::map<OspfArc, Ipv4Address>      m_mapInterfaces;        /**< List of interface addresses for OspfArc. */
@@ -85,6 +118,78 @@ private:
 
     // Deduced from LSA external networks messages
     MapExternalNetwork                  m_mapExternalNetworks;  /**< List of external networks and the router-id of the corresponding ASBR. */
+
+    // Deduced from LSA summary messages
+    MapAsbrSummary                      m_mapAsbrSummaries;     /**< ASBRs of the other areas, reached through an arc from the ABR. */
+    MapNetworkSummary                   m_mapNetworkSummaries;  /**< Networks of the other areas. */
+
+    uint32_t                            m_version;              /**< Incremented each time HandleLsa alters the OSPF graph. */
+    uint64_t                            m_numLsasChanged;       /**< Number of LSAs received which have altered the OSPF graph. */
+    ospf::OspfChangeSet                 m_changes;              /**< Changes recorded while handling a batch of LSAs. */
+    ospf::OspfLsdb                      m_lsdb;                 /**< Most recent instance of each LSA received. */
+    std::vector<nid_t>                  m_nids;                 /**< Scratch vector reused while handling the LSAs. */
+    std::vector<Link>                   m_links;                /**< Scratch vector reused while handling the Router LSAs. */
+
+    /**
+     * @brief Retrieve the networks announced in a Router LSA: the transit
+     *   networks, and the numbered point-to-point links whose prefix is
+     *   then recorded.
+     * @param lsr The Router LSA.
+     * @param links The vector where the networks are appended.
+     */
+
+    void GetLinks (const ospf::OspfRouterLsaView & lsr, std::vector<Link> & links);
+
+    /**
+     * @brief Retrieve the vertex of a network, and add it if needed.
+     * @param nid The network identifier.
+     * @return The vertex descriptor of the network.
+     */
+
+    vd_t AddNetworkVertex (const nid_t & nid);
+
+    /**
+     * @brief Add the arc (u, v) if it does not exist, and add the network n
+     *   with the metric m to the edge. The alteration is recorded in the
+     *   change set returned by HandleLsa.
+     * @param u The source of the arc.
+     * @param v The target of the arc.
+     * @param n The network related to this arc.
+     * @param i The IPv4 address of the interface of u connected to the network.
+     * @param m The metric related to this arc.
+     * @return true is the graph was modified, else false
+     */
+
+    bool AddArc (vd_t u, vd_t v, const nid_t & n, const Ipv4Address & i, const ospf::metric_t & m);
+
+    /**
+     * @brief Remove the network n from the edge (u, v), and if there is no
+     *   more network on the edge remove it.
+     * @param u The source of the arc.
+     * @param v The target of the arc.
+     * @param n The network.
+     * @return true is the graph was modified, else false
+     */
+
+    bool RemoveArc (vd_t u, vd_t v, const nid_t & n);
+
+    /**
+     * @brief Retrieve the networks shared by two routers.
+     * @param rid_u The router-id of a router.
+     * @param rid_v The router-id of another router.
+     * @param nids The vector where the network identifiers are appended.
+     */
+
+    void GetSharedNetworks (const rid_t & rid_u, const rid_t & rid_v, std::vector<nid_t> & nids) const;
+
+    /**
+     * @brief Withdraw the content of an LSA removed from the LSDB (flushed
+     *   or not refreshed by its advertising router).
+     * @param key The key of the LSA.
+     */
+
+    void FlushLsa (const ospf::OspfLsdb::Key & key);
+
 public:
 
     /**
@@ -100,8 +205,26 @@ public:
     ~OspfGraphHelper ();
 
     /**
-     * @brief Add the arc (u,v) if it doesn not exist, and add the network n with the
-     *   metric m to the edge.
+     * @brief Connect a router to a network: add the arcs (u, n) and (n, u)
+     *   if they do not exist, and set the metric of (u, n).
+     * @param u The router ID of the router.
+     * @param n The network.
+     * @param i The IPv4 address of the interface of u connected to the network.
+     * @param m The metric from u to the network.
+     * @return true is the graph was modified, else false
+     */
+
+    bool AddAdjacency (
+        const rid_t          & u,
+        const nid_t          & n,
+        const Ipv4Address    & i,
+        const ospf::metric_t & m
+    );
+
+    /**
+     * @brief Add the arc (u,v) between two routers if it doesn not exist,
+     *   and add the network n with the metric m to the edge. The alteration
+     *   is recorded in the change set returned by HandleLsa.
      * @param u The router ID of the source of the arc.
      * @param v The router ID of the target of the arc.
      * @param n The network related to this arc.
@@ -119,7 +242,7 @@ public:
     );
 
     /**
-     * @brief Remove a router from a network, and if necessary remove some edges.
+     * @brief Remove a router from a network, and remove the arcs connecting them.
      * @param u The router to remove
      * @param n The network
      * @return true is the graph was modified, else false
@@ -131,8 +254,8 @@ public:
     );
 
     /**
-     * @brief Remove a the network n from the edge (u,v), and if there is no more network
-     * on the edge remove it.
+     * @brief Remove a the network n from the edge (u,v) between two routers,
+     * and if there is no more network on the edge remove it.
      * @param u The source
      * @param v The destination
      * @param n The network
@@ -155,39 +278,97 @@ public:
 
     /**
      * @brief Handle a list of OSPF LSA, and consequently add or remove
-     *   (if needed) edge and / or vertex.
-     * @param lsas the list of OSPF Router LSA
-     * @return true is the graph has been altered.
+     *   (if needed) edge and / or vertex. The LSAs are first checked
+     *   against the LSDB: only the new instances whose content differs
+     *   are processed, and the LSAs flushed or aged out are withdrawn.
+     * @param lsas the list of OSPF Router LSA (possibly empty, which
+     *   only ages the LSDB).
+     * @return The changes caused by these LSAs (empty if the graph has not
+     *   been altered).
      */
 
-    bool HandleLsa (std::vector<OspfLsa *> & lsas);
+    ospf::OspfChangeSet HandleLsa (const std::vector<ospf::OspfLsaView> & lsas);
 
     /**
      * @brief Handle an OSPF Router LSA, and consequently add or remove
      *   (if needed) edge and / or vertex.
-     * @param lsr The OspfRouterLsa.
+     * @param lsr The OspfRouterLsaView.
      * @return true is the graph has been altered.
      */
 
-    bool HandleLsr (const OspfRouterLsa & lsr);
+    bool HandleLsr (const ospf::OspfRouterLsaView & lsr);
 
     /**
      * @brief Handle an OSPF Network LSA, and consequently updates the OSPF
      *   graph.
-     * @param lsr The OspfNetworkLsa.
+     * @param lsn The OspfNetworkLsaView.
      * @return true is the graph has been altered.
      */
 
-    bool HandleLsn (const OspfNetworkLsa & lsn);
+    bool HandleLsn (const ospf::OspfNetworkLsaView & lsn);
 
     /**
      * @brief Handle an OSPF External LSA, and consequently updates the OSPF
      *   graph.
-     * @param lse The OspfExternalLsa.
+     * @param lse The OspfExternalLsaView.
      * @return true iif is the graph has been altered.
      */
 
-    bool HandleLse (const OspfExternalLsa & lse);
+    bool HandleLse (const ospf::OspfExternalLsaView & lse);
+
+    /**
+     * @brief Handle an OSPF Summary LSA (Network or ASBR), and consequently
+     *   updates the OSPF graph.
+     * @param lss The OspfSummaryLsaView.
+     * @return true iif is the graph has been altered.
+     */
+
+    bool HandleLss (const ospf::OspfSummaryLsaView & lss);
+
+    /**
+     * @brief Remove a router from all the networks it is connected to.
+     * @param rid_u The router-id of the router.
+     * @return true iif the graph has been altered.
+     */
+
+    bool RemoveRouter (const rid_t & rid_u);
+
+    /**
+     * @brief Remove an external network announced by an ASBR.
+     * @param rid_n The router-id of the ASBR.
+     * @param nid The network identifier of the external network.
+     * @return true iif the external network was known.
+     */
+
+    bool RemoveExternalNetwork (const rid_t & rid_n, const nid_t & nid);
+
+    /**
+     * @brief Remove an ASBR of another area announced by an ABR.
+     * @param rid_abr The router-id of the ABR.
+     * @param rid_asbr The router-id of the ASBR.
+     * @return true iif the graph has been altered.
+     */
+
+    bool RemoveAsbrSummary (const rid_t & rid_abr, const rid_t & rid_asbr);
+
+    /**
+     * @brief Remove a network of another area announced by an ABR.
+     * @param rid_abr The router-id of the ABR.
+     * @param nid The network identifier.
+     * @return true iif the network was known.
+     */
+
+    bool RemoveNetworkSummary (const rid_t & rid_abr, const nid_t & nid);
+
+    /**
+     * @brief Test whether an arc of the OSPF graph models an ASBR Summary
+     *   LSA, in which case it does not correspond to an IGP adjacency.
+     * @param rid_abr The router-id of the source of the arc.
+     * @param rid_asbr The router-id of the target of the arc.
+     * @return true iif rid_abr announces rid_asbr in an ASBR Summary LSA.
+     */
+
+    bool HasAsbrSummary (const rid_t & rid_abr, const rid_t & rid_asbr) const;
 
     /**
      * @brief Accessor to the OSPF graph managed by this Ibgp2d instance.
@@ -196,6 +377,25 @@ public:
 
     const ospf::OspfGraph & GetGraph () const;
 
+    /**
+     * @brief Retrieve the version of the OSPF graph. The version is
+     *   incremented each time HandleLsa reports a change, so a structure
+     *   deduced from the graph (e.g. an ospf::OspfCsrGraph) only needs to be
+     *   rebuilt if its version differs from this one.
+     * @return The current version.
+     */
+
+    uint32_t GetVersion () const;
+
+    /**
+     * @brief Retrieve the number of LSAs passed to HandleLsa which have
+     *   altered the OSPF graph (the copies, refreshes and LSAs with an
+     *   unchanged content are not counted).
+     * @return The number of LSAs.
+     */
+
+    uint64_t GetNumLsasChanged () const;
+
     /**
      * @brief Get a vertex according to its router-id.
      * @param routerId The vertex's router-id.
@@ -206,9 +406,20 @@ public:
     std::pair<vd_t, bool> GetVertex (const rid_t & routerId) const;
 
     /**
-     * @brief Get the IPv4 address of the interface of u connected to v.
+     * @brief Get a network vertex according to its network identifier.
+     * @param nid The network identifier.
+     * @return A pair made of the vertex and a boolean which is true if the
+     *   vertex was found, false else.
+     */
+
+    std::pair<vd_t, bool> GetNetworkVertex (const nid_t & nid) const;
+
+    /**
+     * @brief Get the IPv4 address of the interface of u connected to v. If
+     *   they share several networks, the one having the lowest metric
+     *   from u is considered.
      * @param u The router from which we want the interface.
-     * @param v The destination router of the (u, v) link.
+     * @param v A router sharing a network with u.
      * @return The corresponding Ipv4Address.
      */
 
@@ -236,6 +447,15 @@ public:
         std::set<Ipv4Prefix> & networks
     ) const;
 
+    /**
+     * @brief Retrieve the OSPF routers connected to at least one external
+     *    network (ASBRs).
+     * @param asbrs A vector where the router-ids of the ASBRs will be
+     *    appended (sorted by router-id).
+     */
+
+    void GetAsbrs (std::vector<rid_t> & asbrs) const;
+
     /**
      * @brief Retrieve the prefixes corresponding to the transit networks shared
      *   by to neighboring routers (this is basically the prefixes corresponding
@@ -258,9 +478,9 @@ public:
      * @param out The output stream.
      * @param drawNetworks Pass true to draw the network vertices, false
      *   otherwise.
-     *    If true: all the vertices are routers, all the arcs are router->router
-     *    If false: vertices may be either routers or either networks, all the
-     *       arcs are router->network.
+     *    If false: all the vertices are routers, all the arcs are router->router
+     *    If true: vertices may be either routers or either networks, the
+     *       arcs are router->network or network->router.
      * @returns The updated output stream.
      */
 
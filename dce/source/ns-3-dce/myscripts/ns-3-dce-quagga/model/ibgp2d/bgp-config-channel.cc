@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Alexandre Morignot, Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *    Alexandre Morignot <alexandre.morignot@orange.fr>
+ *    Marc-Olivier Buob <marcolivier.buob@orange.fr>
+ */
+#include "bgp-config-channel.h"
+
+#define LOCALHOST   "127.0.0.1"
+
+#include <fstream>                          // std::ofstream
+#include <sstream>                          // std::istringstream
+
+#include "ns3/assert.h"                     // NS_ASSERT
+#include "ns3/ipv4-address.h"               // ns3::Ipv4Address
+#include "ns3/log.h"                        // NS_LOG_*
+#include "ns3/nstime.h"                     // ns3::Seconds
+#include "ns3/simulator.h"                  // ns3::Simulator
+
+#include "../quagga/bgpd/bgp-config.h"      // ns3::BgpConfig
+#include "../quagga/common/quagga-fs.h"     // ns3::QuaggaFs
+
+NS_LOG_COMPONENT_DEFINE ("BgpConfigChannel");
+
+namespace ns3 {
+
+//----------------------------------------------------------------------------
+// BgpConfigChannel
+//----------------------------------------------------------------------------
+
+BgpConfigChannel::~BgpConfigChannel() {}
+
+void BgpConfigChannel::SetCommandCallback (CommandCallback callback) {
+    this->m_commandCallback = callback;
+}
+
+void BgpConfigChannel::NotifyCommand (const VtyCommand & command) const {
+    if (!this->m_commandCallback.IsNull()) {
+        this->m_commandCallback (command);
+    }
+}
+
+void BgpConfigChannel::NotifyCommands (const std::string & commands, bool isError) const {
+    if (this->m_commandCallback.IsNull()) return;
+
+    VtyCommand command;
+    command.sent = command.completed = Simulator::Now();
+    command.isError = isError;
+
+    std::istringstream iss (commands);
+    while (std::getline (iss, command.line)) {
+        this->m_commandCallback (command);
+    }
+}
+
+//----------------------------------------------------------------------------
+// VtyBgpConfigChannel
+//----------------------------------------------------------------------------
+
+VtyBgpConfigChannel::VtyBgpConfigChannel (const Time & keepAlive) :
+    m_telnet (0),
+    m_pipeline (0),
+    m_keepAlive (keepAlive)
+{
+    NS_LOG_FUNCTION (this);
+}
+
+std::size_t VtyBgpConfigChannel::GetNumPending () const {
+    return this->m_pipeline ? this->m_pipeline->GetNumPending() : 0;
+}
+
+void VtyBgpConfigChannel::Send (const std::string & commands) {
+    NS_ASSERT (this->m_telnet);
+
+    // One line per command, so that each prompt acknowledges one of them.
+    std::istringstream iss (commands);
+    for (std::string line; std::getline (iss, line);) {
+        this->m_pipeline->Push (line);
+        this->m_telnet->AppendCommand (line + '\n');
+    }
+
+    this->ScheduleKeepAlive();
+}
+
+void VtyBgpConfigChannel::KeepAlive () {
+    NS_LOG_FUNCTION (this);
+
+    if (this->m_pipeline->GetNumPending()) {
+        // bgpd is busy, the session is not idle.
+        this->ScheduleKeepAlive();
+    } else {
+        this->Send ("\n");
+    }
+}
+
+void VtyBgpConfigChannel::ScheduleKeepAlive () {
+    this->m_keepAliveEvent.Cancel();
+
+    if (this->m_keepAlive.IsStrictlyPositive()) {
+        this->m_keepAliveEvent = Simulator::Schedule (this->m_keepAlive, &VtyBgpConfigChannel::KeepAlive, this);
+    }
+}
+
+VtyBgpConfigChannel::~VtyBgpConfigChannel() {
+    NS_LOG_FUNCTION (this);
+    this->Close();
+}
+
+void VtyBgpConfigChannel::Open (Ptr<Node> node) {
+    NS_LOG_FUNCTION (this << node);
+    if (this->m_telnet) return;
+
+    Ptr<BgpConfig> bgpConfig = node->GetObject<BgpConfig>();
+    NS_ASSERT (bgpConfig);
+    this->m_pipeline = new VtyPipeline (bgpConfig->GetHostname() + "_ibgpv2_bgp.txt");
+    this->m_pipeline->SetCompletionCallback (MakeCallback (&VtyBgpConfigChannel::NotifyCommand, this));
+    this->m_telnet = new Telnet (
+        node,
+        Ipv4Address (LOCALHOST),
+        bgpConfig->GetVtyPort(),
+        MakeCallback (&VtyPipeline::HandleData, this->m_pipeline),
+        Seconds (0)
+    );
+
+    // Connection (mode normal)
+    const std::string & password = bgpConfig->GetPassword();
+
+    if (password.size()) {
+        this->Send (password);
+    }
+
+    // bgpd>
+
+    const std::string & passwordEnable = bgpConfig->GetPasswordEnable();
+    this->Send ("enable");
+
+    if (passwordEnable.size()) {
+        this->Send (passwordEnable);
+    }
+
+    // bgpd#
+
+    this->Send ("configure terminal");
+
+    // bgpd(config)#
+}
+
+void VtyBgpConfigChannel::Close () {
+    NS_LOG_FUNCTION (this);
+
+    this->m_keepAliveEvent.Cancel();
+
+    if (this->m_telnet) {
+        this->m_telnet->Close();
+        delete this->m_telnet;
+        this->m_telnet = 0;
+    }
+
+    if (this->m_pipeline) {
+        this->m_pipeline->Close();
+        delete this->m_pipeline;
+        this->m_pipeline = 0;
+    }
+}
+
+void VtyBgpConfigChannel::Configure (const std::string & commands) {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT (this->m_telnet);
+
+    // bgpd(config)#
+    this->Send (commands);
+}
+
+void VtyBgpConfigChannel::Execute (const std::string & commands) {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT (this->m_telnet);
+
+    // bgpd(config)#
+    // "end" leaves any configuration node with a single prompt.
+    this->Send ("end");
+
+    // bgpd#
+    this->Send (commands);
+    this->Send ("configure terminal");
+
+    // bgpd(config)#
+}
+
+//----------------------------------------------------------------------------
+// ReloadBgpConfigChannel
+//----------------------------------------------------------------------------
+
+ReloadBgpConfigChannel::ReloadBgpConfigChannel (ReloadCallback reload) :
+    m_reload (reload),
+    m_numReloads (0)
+{
+    NS_LOG_FUNCTION (this);
+}
+
+const std::string & ReloadBgpConfigChannel::GetFragment () const {
+    return this->m_fragment;
+}
+
+std::size_t ReloadBgpConfigChannel::GetNumReloads () const {
+    return this->m_numReloads;
+}
+
+void ReloadBgpConfigChannel::Open (Ptr<Node> node) {
+    NS_LOG_FUNCTION (this << node);
+    this->m_node = node;
+    this->m_fragment.clear();
+    this->m_numReloads = 0;
+}
+
+void ReloadBgpConfigChannel::Close () {
+    NS_LOG_FUNCTION (this);
+    this->m_node = 0;
+}
+
+void ReloadBgpConfigChannel::Configure (const std::string & commands) {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT (this->m_node);
+
+    Ptr<BgpConfig> bgpConfig = this->m_node->GetObject<BgpConfig>();
+    NS_ASSERT (bgpConfig);
+    this->m_fragment += commands;
+
+    // The fragment is replayed after the static configuration.
+    const std::string realFilename = QuaggaFs::GetRootDirectory (this->m_node) + bgpConfig->GetConfigFilename();
+    std::ofstream conf (realFilename);
+
+    if (!conf) {
+        NS_LOG_WARN ("Can't write [" << realFilename << "]");
+        this->NotifyCommands (commands, true);
+        return;
+    }
+
+    bgpConfig->Print (conf);
+    conf << this->m_fragment;
+    conf.close();
+
+    ++this->m_numReloads;
+    if (!this->m_reload.IsNull()) {
+        this->m_reload (this->m_node);
+    }
+
+    this->NotifyCommands (commands, false);
+}
+
+void ReloadBgpConfigChannel::Execute (const std::string & commands) {
+    NS_LOG_FUNCTION (this);
+    NS_LOG_LOGIC ("Dropped (the reload resets the sessions): " << commands);
+}
+
+//----------------------------------------------------------------------------
+// MemoryBgpConfigChannel
+//----------------------------------------------------------------------------
+
+MemoryBgpConfigChannel::MemoryBgpConfigChannel () :
+    m_isOpen (false)
+{
+    NS_LOG_FUNCTION (this);
+}
+
+const std::vector<std::string> & MemoryBgpConfigChannel::GetConfigured () const {
+    return this->m_configured;
+}
+
+const std::vector<std::string> & MemoryBgpConfigChannel::GetExecuted () const {
+    return this->m_executed;
+}
+
+bool MemoryBgpConfigChannel::IsOpen () const {
+    return this->m_isOpen;
+}
+
+void MemoryBgpConfigChannel::Clear () {
+    NS_LOG_FUNCTION (this);
+    this->m_configured.clear();
+    this->m_executed.clear();
+}
+
+void MemoryBgpConfigChannel::Open (Ptr<Node> node) {
+    NS_LOG_FUNCTION (this << node);
+    this->m_isOpen = true;
+}
+
+void MemoryBgpConfigChannel::Close () {
+    NS_LOG_FUNCTION (this);
+    this->m_isOpen = false;
+}
+
+void MemoryBgpConfigChannel::Configure (const std::string & commands) {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT (this->m_isOpen);
+    this->m_configured.push_back (commands);
+    this->NotifyCommands (commands, false);
+}
+
+void MemoryBgpConfigChannel::Execute (const std::string & commands) {
+    NS_LOG_FUNCTION (this);
+    NS_ASSERT (this->m_isOpen);
+    this->m_executed.push_back (commands);
+    this->NotifyCommands (commands, false);
+}
+
+} // namespace ns3
@@ -0,0 +1,303 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Alexandre Morignot, Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *    Alexandre Morignot <alexandre.morignot@orange.fr>
+ *    Marc-Olivier Buob <marcolivier.buob@orange.fr>
+ */
+#ifndef BGP_CONFIG_CHANNEL_H
+#define BGP_CONFIG_CHANNEL_H
+
+#include <cstddef>                          // std::size_t
+#include <string>                           // std::string
+#include <vector>                           // std::vector
+
+#include "ns3/callback.h"                   // ns3::Callback
+#include "ns3/event-id.h"                   // ns3::EventId
+#include "ns3/node.h"                       // ns3::Node
+#include "ns3/nstime.h"                     // ns3::Time
+#include "ns3/ptr.h"                        // ns3::Ptr
+
+#include "../telnet-wrapper.h"              // ns3::Telnet
+#include "../vty-pipeline.h"                // ns3::VtyCommand, ns3::VtyPipeline
+
+namespace ns3 {
+
+/**
+ * @class BgpConfigChannel
+ * @brief Channel through which Ibgp2d configures the bgpd running on its
+ *   Node.
+ *
+ * The commands are written as in the bgpd VTY: Configure() receives
+ * commands issued in "configure terminal" mode, and Execute() the
+ * commands issued in enable mode (e.g. "clear ip bgp"). Each
+ * implementation decides how they reach bgpd, and reports each command
+ * once bgpd has acknowledged it.
+ */
+
+class BgpConfigChannel
+{
+public:
+    typedef VtyPipeline::CompletionCallback CommandCallback;
+
+private:
+    CommandCallback m_commandCallback;  /**< Called back for each acknowledged command. */
+
+protected:
+
+    /**
+     * @brief Report a command acknowledged by bgpd.
+     * @param command The command.
+     */
+
+    void NotifyCommand(const VtyCommand & command) const;
+
+    /**
+     * @brief Report each line of a batch as a command acknowledged at once
+     *   (for the channels not relying on the bgpd prompts).
+     * @param commands The commands (one per line).
+     * @param isError Pass true if the batch could not be applied.
+     */
+
+    void NotifyCommands(const std::string & commands, bool isError) const;
+
+public:
+
+    /**
+     * @brief Destructor.
+     */
+
+    virtual ~BgpConfigChannel();
+
+    /**
+     * @brief Set the function called back when bgpd acknowledges a command.
+     * @param callback The callback.
+     */
+
+    void SetCommandCallback(CommandCallback callback);
+
+    /**
+     * @brief Open the channel. Called before the first command.
+     * @param node The Node running bgpd.
+     */
+
+    virtual void Open(Ptr<Node> node) = 0;
+
+    /**
+     * @brief Close the channel.
+     */
+
+    virtual void Close() = 0;
+
+    /**
+     * @brief Send commands to bgpd in "configure terminal" mode.
+     * @param commands The commands (one per line). They start and end in
+     *   the bgpd(config)# mode.
+     */
+
+    virtual void Configure(const std::string & commands) = 0;
+
+    /**
+     * @brief Send commands to bgpd in enable mode.
+     * @param commands The commands (one per line).
+     */
+
+    virtual void Execute(const std::string & commands) = 0;
+};
+
+/**
+ * @class VtyBgpConfigChannel
+ * @brief Send the commands through a telnet session to the bgpd VTY
+ *   (default channel). The session stays in "configure terminal" mode
+ *   between two calls.
+ *
+ * Each command is acknowledged by the next prompt of the VTY (see
+ * VtyPipeline). When the session stays idle, an empty line is sent
+ * periodically so that bgpd does not close it (exec-timeout).
+ */
+
+class VtyBgpConfigChannel :
+    public BgpConfigChannel
+{
+private:
+    Telnet *        m_telnet;           /**< Telnet connection to the bgpd VTY (NULL if closed). */
+    VtyPipeline *   m_pipeline;         /**< Matches the commands with the prompts (NULL if closed). */
+    Time            m_keepAlive;        /**< Idle time before sending a keepalive (0: never). */
+    EventId         m_keepAliveEvent;   /**< Next keepalive. */
+
+    /**
+     * @brief Send commands to the VTY and register them in the pipeline.
+     * @param commands The commands (one per line).
+     */
+
+    void Send(const std::string & commands);
+
+    /**
+     * @brief Send an empty line if no command is pending, and schedule the
+     *   next keepalive.
+     */
+
+    void KeepAlive();
+
+    /**
+     * @brief (Re)schedule the next keepalive.
+     */
+
+    void ScheduleKeepAlive();
+
+public:
+
+    /**
+     * @brief Constructor.
+     * @param keepAlive Idle time after which an empty line is sent to
+     *   bgpd. Pass Time(0) to disable the keepalives.
+     */
+
+    VtyBgpConfigChannel(const Time & keepAlive = Seconds(60));
+
+    /**
+     * @brief Retrieve the number of commands not yet acknowledged by bgpd.
+     * @return The number of pending commands.
+     */
+
+    std::size_t GetNumPending() const;
+
+    /**
+     * @brief Destructor.
+     */
+
+    virtual ~VtyBgpConfigChannel();
+
+    virtual void Open(Ptr<Node> node);
+    virtual void Close();
+    virtual void Configure(const std::string & commands);
+    virtual void Execute(const std::string & commands);
+};
+
+/**
+ * @class ReloadBgpConfigChannel
+ * @brief Rewrite the bgpd configuration file in the DCE filesystem of the
+ *   Node, and trigger its reload.
+ *
+ * The file is made of the configuration of bgpd (see BgpConfig) followed
+ * by the fragment accumulating every command received by Configure().
+ * Quagga reloads its configuration on SIGHUP, so the reload is delegated
+ * to a callback (e.g. sending this signal to the bgpd process). Since a
+ * reload resets the BGP sessions, the commands received by Execute() are
+ * dropped.
+ */
+
+class ReloadBgpConfigChannel :
+    public BgpConfigChannel
+{
+public:
+    typedef Callback<void, Ptr<Node> > ReloadCallback;
+
+private:
+    Ptr<Node>       m_node;         /**< The Node running bgpd (NULL if closed). */
+    std::string     m_fragment;     /**< Commands received by Configure(). */
+    ReloadCallback  m_reload;       /**< Triggers the reload of bgpd. */
+    std::size_t     m_numReloads;   /**< Number of reloads triggered. */
+
+public:
+
+    /**
+     * @brief Constructor.
+     * @param reload The callback triggering the reload of the bgpd
+     *   running on a Node. If null, bgpd reads the file at its next start.
+     */
+
+    ReloadBgpConfigChannel(ReloadCallback reload = MakeNullCallback<void, Ptr<Node> > ());
+
+    /**
+     * @brief Retrieve the fragment appended to the bgpd configuration.
+     * @return The commands received by Configure().
+     */
+
+    const std::string & GetFragment() const;
+
+    /**
+     * @brief Retrieve the number of reloads triggered.
+     * @return The number of calls to Configure() since Open().
+     */
+
+    std::size_t GetNumReloads() const;
+
+    virtual void Open(Ptr<Node> node);
+    virtual void Close();
+    virtual void Configure(const std::string & commands);
+    virtual void Execute(const std::string & commands);
+};
+
+/**
+ * @class MemoryBgpConfigChannel
+ * @brief Store the commands in memory instead of sending them to bgpd,
+ *   so that the behavior of Ibgp2d can be checked without running bgpd.
+ */
+
+class MemoryBgpConfigChannel :
+    public BgpConfigChannel
+{
+private:
+    std::vector<std::string>    m_configured;   /**< Commands received by Configure(), in order. */
+    std::vector<std::string>    m_executed;     /**< Commands received by Execute(), in order. */
+    bool                        m_isOpen;       /**< true iif the channel is open. */
+
+public:
+
+    /**
+     * @brief Constructor.
+     */
+
+    MemoryBgpConfigChannel();
+
+    /**
+     * @brief Retrieve the commands received by Configure().
+     * @return The commands, one per batch.
+     */
+
+    const std::vector<std::string> & GetConfigured() const;
+
+    /**
+     * @brief Retrieve the commands received by Execute().
+     * @return The commands, one per batch.
+     */
+
+    const std::vector<std::string> & GetExecuted() const;
+
+    /**
+     * @brief Test whether the channel is open.
+     * @return true iif Open() has been called and not followed by Close().
+     */
+
+    bool IsOpen() const;
+
+    /**
+     * @brief Forget the commands received so far.
+     */
+
+    void Clear();
+
+    virtual void Open(Ptr<Node> node);
+    virtual void Close();
+    virtual void Configure(const std::string & commands);
+    virtual void Execute(const std::string & commands);
+};
+
+} // namespace ns3
+
+#endif // BGP_CONFIG_CHANNEL_H
@@ -0,0 +1,165 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Alexandre Morignot, Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *    Alexandre Morignot <alexandre.morignot@orange.fr>
+ *    Marc-Olivier Buob <marcolivier.buob@orange.fr>
+ */
+
+#include "ibgp2d-batch.h"
+
+#include <algorithm>                        // std::sort, std::find
+
+#include "ns3/log.h"                        // NS_LOG_*
+#include "ns3/node.h"                       // ns3::Node
+#include "ns3/simulator.h"                  // ns3::Simulator
+
+NS_LOG_COMPONENT_DEFINE ("Ibgp2dBatch");
+
+namespace ns3 {
+
+/**
+ * @brief Compare two iBGP2 daemons according to the identifier of their Node.
+ * @param a An Ibgp2d instance.
+ * @param b Another Ibgp2d instance.
+ * @return true iif a must be processed before b.
+ */
+
+static bool CompareNodeId (const Ibgp2d * a, const Ibgp2d * b) {
+    return a->GetNode()->GetId() < b->GetNode()->GetId();
+}
+
+Ibgp2dBatch::Ibgp2dBatch() :
+    m_workerPool (NULL)
+{}
+
+Ibgp2dBatch::~Ibgp2dBatch() {
+    delete this->m_workerPool;
+}
+
+void Ibgp2dBatch::Enqueue (Ibgp2d * ibgp2d) {
+    NS_LOG_FUNCTION (this << ibgp2d);
+    this->m_pending.push_back (ibgp2d);
+
+    if (!this->m_event.IsRunning()) {
+        this->m_event = Simulator::ScheduleNow (&Ibgp2dBatch::Run, this);
+    }
+}
+
+void Ibgp2dBatch::Cancel (Ibgp2d * ibgp2d) {
+    NS_LOG_FUNCTION (this << ibgp2d);
+
+    std::vector<Ibgp2d *>::iterator fit (std::find (this->m_pending.begin(), this->m_pending.end(), ibgp2d));
+    if (fit != this->m_pending.end()) {
+        this->m_pending.erase (fit);
+    }
+}
+
+const Ibgp2d::NeighborSpf * Ibgp2dBatch::FindProducer (
+    const ospf::OspfGraphSignature & signature,
+    const Ipv4Address & rid_v
+) const {
+    for (const Producers & producers : this->m_producers) {
+        if (*producers.first == signature) {
+            MapProducers::const_iterator fit (producers.second.find (rid_v));
+            return (fit == producers.second.end()) ? NULL : fit->second;
+        }
+    }
+    return NULL;
+}
+
+void Ibgp2dBatch::AddProducer (
+    const ospf::OspfGraphSignature & signature,
+    const Ipv4Address & rid_v,
+    const Ibgp2d::NeighborSpf * neighbor
+) {
+    for (Producers & producers : this->m_producers) {
+        if (*producers.first == signature) {
+            producers.second.insert (std::make_pair (rid_v, neighbor));
+            return;
+        }
+    }
+
+    this->m_producers.push_back (Producers (&signature, MapProducers()));
+    this->m_producers.back().second.insert (std::make_pair (rid_v, neighbor));
+}
+
+void Ibgp2dBatch::Run () {
+    NS_LOG_FUNCTION (this);
+
+    std::vector<Ibgp2d *> pending;
+    pending.swap (this->m_pending);
+    std::sort (pending.begin(), pending.end(), CompareNodeId);
+
+    // 1) Prepare the computations, and list them.
+    std::vector<std::pair<Ibgp2d *, std::size_t> > tasks;
+    std::vector<Ibgp2d *> prepared;
+    uint32_t numThreads = 1;
+
+    for (Ibgp2d * ibgp2d : pending) {
+        ibgp2d->m_batchPending = false;
+        if (ibgp2d->m_numThreads > numThreads) numThreads = ibgp2d->m_numThreads;
+
+        if (ibgp2d->PrepareIbgp2Redistribution (this)) {
+            prepared.push_back (ibgp2d);
+            for (std::size_t i = 0; i < ibgp2d->m_neighbors.size(); ++i) {
+                tasks.push_back (std::make_pair (ibgp2d, i));
+            }
+        }
+    }
+
+    NS_LOG_LOGIC ("Batch: " << pending.size() << " daemons, " << tasks.size() << " neighbors");
+
+    // 2) Run them concurrently.
+    if (numThreads > 1 && (!this->m_workerPool || this->m_workerPool->GetNumThreads() < numThreads)) {
+        delete this->m_workerPool;
+        this->m_workerPool = new WorkerPool (numThreads);
+    }
+
+    WorkerPool::Task task = [&tasks] (std::size_t i) {
+        tasks[i].first->ComputeIbgp2Redistribution (tasks[i].second);
+    };
+
+    if (this->m_workerPool) {
+        this->m_workerPool->Run (tasks.size(), task);
+    } else {
+        for (std::size_t i = 0; i < tasks.size(); ++i) task (i);
+    }
+
+    // 3) Apply the results in the order of the nodes. A router may read
+    // the first hops computed by a router finished before it, so they are
+    // only released once the whole batch is finished.
+    for (Ibgp2d * ibgp2d : prepared) {
+        ibgp2d->FinishIbgp2Redistribution();
+    }
+    for (Ibgp2d * ibgp2d : prepared) {
+        ibgp2d->ReleaseIbgp2Redistribution();
+    }
+    this->m_producers.clear();
+
+    for (Ibgp2d * ibgp2d : pending) {
+        Simulator::ScheduleWithContext (
+            ibgp2d->GetNode()->GetId(),
+            Seconds (0),
+            &Ibgp2d::UpdateBgpd,
+            ibgp2d,
+            true
+        );
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,137 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Alexandre Morignot, Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *    Alexandre Morignot <alexandre.morignot@orange.fr>
+ *    Marc-Olivier Buob <marcolivier.buob@orange.fr>
+ */
+
+#ifndef IBGP2D_BATCH_H
+#define IBGP2D_BATCH_H
+
+#include <list>                             // std::list
+#include <map>                              // std::map
+#include <utility>                          // std::pair
+#include <vector>                           // std::vector
+
+#include "ns3/event-id.h"                   // ns3::EventId
+
+#include "ibgp2d.h"                         // ns3::Ibgp2d
+#include "../worker-pool.h"                 // ns3::WorkerPool
+
+namespace ns3 {
+
+/**
+ * @class Ibgp2dBatch
+ * @brief Process-wide batch of iBGP2 recomputations (see the "BatchMode"
+ *   attribute of Ibgp2d).
+ *
+ * When a LS-Update floods, many iBGP2 daemons handle an IGP change at the
+ * same simulated time. In batch mode, each of them only enqueues itself,
+ * and a single event scheduled at the current time (i.e. after the events
+ * already scheduled for this time) processes the whole batch:
+ *
+ * 1) the daemons prepare their computations, sequentially and sorted by
+ *    node identifier. A tree that another daemon of the batch computes over
+ *    the same LSDB content is not computed twice;
+ *
+ * 2) the computations (one per daemon and IGP neighbor) run concurrently
+ *    on a WorkerPool;
+ *
+ * 3) the daemons deduce their filters, sequentially and sorted by node
+ *    identifier, and the push in bgpd is scheduled in the context of each
+ *    node in the same order.
+ *
+ * The result (filters, bgpd commands and their order) does thus not depend
+ * on the number of threads, and runs remain reproducible.
+ */
+
+class Ibgp2dBatch
+{
+private:
+    typedef std::map<Ipv4Address, const Ibgp2d::NeighborSpf *> MapProducers;  /**< Maps a root v with the computation of its tree. */
+    typedef std::pair<const ospf::OspfGraphSignature *, MapProducers> Producers;
+
+    std::vector<Ibgp2d *>   m_pending;      /**< The daemons to process. */
+    EventId                 m_event;        /**< The event processing the batch. */
+    WorkerPool *            m_workerPool;   /**< Threads running the computations. */
+    std::list<Producers>    m_producers;    /**< The trees computed in the current batch, per LSDB content. */
+
+    /**
+     * @brief Process the pending daemons.
+     */
+
+    void Run();
+
+public:
+
+    /**
+     * @brief Constructor.
+     */
+
+    Ibgp2dBatch();
+
+    /**
+     * @brief Destructor.
+     */
+
+    ~Ibgp2dBatch();
+
+    /**
+     * @brief Add a daemon to the batch, and schedule the batch if needed.
+     * @param ibgp2d The daemon which must recompute its filters.
+     */
+
+    void Enqueue(Ibgp2d * ibgp2d);
+
+    /**
+     * @brief Remove a daemon from the batch.
+     * @param ibgp2d The daemon (e.g. which is stopped).
+     */
+
+    void Cancel(Ibgp2d * ibgp2d);
+
+    /**
+     * @brief Search whether a daemon of the batch computes a given tree.
+     * @param signature The signature of the LSDB content.
+     * @param rid_v The router-id of the root of the tree.
+     * @return The corresponding computation, NULL if not found.
+     */
+
+    const Ibgp2d::NeighborSpf * FindProducer(
+        const ospf::OspfGraphSignature & signature,
+        const Ipv4Address & rid_v
+    ) const;
+
+    /**
+     * @brief Register a tree computed by a daemon of the batch.
+     * @param signature The signature of the LSDB content. It must remain
+     *   valid until the end of the batch.
+     * @param rid_v The router-id of the root of the tree.
+     * @param neighbor The corresponding computation.
+     */
+
+    void AddProducer(
+        const ospf::OspfGraphSignature & signature,
+        const Ipv4Address & rid_v,
+        const Ibgp2d::NeighborSpf * neighbor
+    );
+};
+
+} // namespace ns3
+
+#endif // IBGP2D_BATCH_H
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Alexandre Morignot, Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *    Alexandre Morignot <alexandre.morignot@orange.fr>
+ *    Marc-Olivier Buob <marcolivier.buob@orange.fr>
+ */
+
+#include "ibgp2d-stats.h"
+
+#include "ns3/assert.h"                     // NS_ASSERT
+
+namespace ns3 {
+
+/**
+ * @brief Write the bins of an histogram in CSV.
+ * @param os The output stream.
+ * @param routerId The router-id of the Ibgp2d instance.
+ * @param metric The name of the histogram.
+ * @param histogram The histogram.
+ */
+
+static void WriteCsvHistogram (
+    std::ostream & os,
+    const Ipv4Address & routerId,
+    const char * metric,
+    const Ibgp2dHistogram & histogram
+) {
+    for (std::size_t i = 0; i < histogram.GetNumBins(); ++i) {
+        if (histogram.GetBinCount (i)) {
+            os << routerId << ',' << metric << ',' << histogram.GetBinStart (i) << ',' << histogram.GetBinCount (i) << std::endl;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// Ibgp2dHistogram
+//----------------------------------------------------------------------------
+
+Ibgp2dHistogram::Ibgp2dHistogram (double binWidth) {
+    this->SetBinWidth (binWidth);
+}
+
+void Ibgp2dHistogram::SetBinWidth (double binWidth) {
+    NS_ASSERT (binWidth > 0);
+    this->m_binWidth = binWidth;
+    this->Clear();
+}
+
+double Ibgp2dHistogram::GetBinWidth () const {
+    return this->m_binWidth;
+}
+
+void Ibgp2dHistogram::AddValue (double value) {
+    std::size_t i = value > 0 ? static_cast<std::size_t> (value / this->m_binWidth) : 0;
+    if (i >= this->m_bins.size()) {
+        this->m_bins.resize (i + 1, 0);
+    }
+
+    ++this->m_bins[i];
+    ++this->m_count;
+    this->m_sum += value;
+    if (this->m_count == 1 || value > this->m_max) {
+        this->m_max = value;
+    }
+}
+
+void Ibgp2dHistogram::Clear () {
+    this->m_bins.clear();
+    this->m_count = 0;
+    this->m_sum = 0;
+    this->m_max = 0;
+}
+
+std::size_t Ibgp2dHistogram::GetNumBins () const {
+    return this->m_bins.size();
+}
+
+double Ibgp2dHistogram::GetBinStart (std::size_t i) const {
+    return i * this->m_binWidth;
+}
+
+uint64_t Ibgp2dHistogram::GetBinCount (std::size_t i) const {
+    NS_ASSERT (i < this->m_bins.size());
+    return this->m_bins[i];
+}
+
+uint64_t Ibgp2dHistogram::GetCount () const {
+    return this->m_count;
+}
+
+double Ibgp2dHistogram::GetMean () const {
+    return this->m_count ? this->m_sum / this->m_count : 0;
+}
+
+double Ibgp2dHistogram::GetMax () const {
+    return this->m_max;
+}
+
+//----------------------------------------------------------------------------
+// Ibgp2dStats
+//----------------------------------------------------------------------------
+
+Ibgp2dStats::Ibgp2dStats () {
+    this->Clear();
+}
+
+void Ibgp2dStats::Clear () {
+    this->numLsas = 0;
+    this->numLsasChanged = 0;
+    this->numSpfRuns = 0;
+    this->numFilterEntriesAdded = 0;
+    this->numFilterEntriesRemoved = 0;
+    this->numBgpCommands = 0;
+    this->numBgpCommandsFailed = 0;
+    this->spfTime.Clear();
+    this->pushDelay.Clear();
+}
+
+std::ostream & Ibgp2dStats::WriteCsvHeader (std::ostream & os) {
+    os << "router_id,metric,bin_start,value" << std::endl;
+    return os;
+}
+
+std::ostream & Ibgp2dStats::WriteCsv (std::ostream & os, const Ipv4Address & routerId) const {
+    os << routerId << ",lsas,,"                   << this->numLsas                 << std::endl
+       << routerId << ",lsas_changed,,"           << this->numLsasChanged          << std::endl
+       << routerId << ",spf_runs,,"               << this->numSpfRuns              << std::endl
+       << routerId << ",filter_entries_added,,"   << this->numFilterEntriesAdded   << std::endl
+       << routerId << ",filter_entries_removed,," << this->numFilterEntriesRemoved << std::endl
+       << routerId << ",bgp_commands,,"           << this->numBgpCommands          << std::endl
+       << routerId << ",bgp_commands_failed,,"    << this->numBgpCommandsFailed    << std::endl;
+
+    WriteCsvHistogram (os, routerId, "spf_time",   this->spfTime);
+    WriteCsvHistogram (os, routerId, "push_delay", this->pushDelay);
+    return os;
+}
+
+} // namespace ns3
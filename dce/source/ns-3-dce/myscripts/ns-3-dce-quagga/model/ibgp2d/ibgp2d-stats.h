@@ -0,0 +1,181 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Alexandre Morignot, Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *    Alexandre Morignot <alexandre.morignot@orange.fr>
+ *    Marc-Olivier Buob <marcolivier.buob@orange.fr>
+ */
+
+#ifndef IBGP2D_STATS_H
+#define IBGP2D_STATS_H
+
+#include <cstddef>                          // std::size_t
+#include <cstdint>                          // uint64_t
+#include <ostream>                          // std::ostream
+#include <vector>                           // std::vector
+
+#include "ns3/ipv4-address.h"               // ns3::Ipv4Address
+
+namespace ns3 {
+
+/**
+ * @class Ibgp2dHistogram
+ * @brief Histogram made of bins of constant width starting at 0. The bins
+ *   are allocated as the values grow.
+ */
+
+class Ibgp2dHistogram
+{
+private:
+    double                  m_binWidth; /**< Width of each bin. */
+    std::vector<uint64_t>   m_bins;     /**< Number of values falling in each bin. */
+    uint64_t                m_count;    /**< Number of values. */
+    double                  m_sum;      /**< Sum of the values. */
+    double                  m_max;      /**< Greatest value. */
+
+public:
+
+    /**
+     * @brief Constructor.
+     * @param binWidth The width of each bin (strictly positive).
+     */
+
+    Ibgp2dHistogram(double binWidth = 1.0);
+
+    /**
+     * @brief Set the width of the bins. The values already added are
+     *   cleared.
+     * @param binWidth The width of each bin (strictly positive).
+     */
+
+    void SetBinWidth(double binWidth);
+
+    /**
+     * @brief Retrieve the width of the bins.
+     * @return The width of each bin.
+     */
+
+    double GetBinWidth() const;
+
+    /**
+     * @brief Add a value to this histogram.
+     * @param value The value (negative values are counted in the first bin).
+     */
+
+    void AddValue(double value);
+
+    /**
+     * @brief Clear the values added to this histogram.
+     */
+
+    void Clear();
+
+    /**
+     * @brief Retrieve the number of bins allocated.
+     * @return The number of bins (up to the one of the greatest value).
+     */
+
+    std::size_t GetNumBins() const;
+
+    /**
+     * @brief Retrieve the lower bound of a bin.
+     * @param i The index of the bin.
+     * @return The lower bound (the upper bound is excluded from the bin).
+     */
+
+    double GetBinStart(std::size_t i) const;
+
+    /**
+     * @brief Retrieve the number of values falling in a bin.
+     * @param i The index of the bin.
+     * @return The number of values.
+     */
+
+    uint64_t GetBinCount(std::size_t i) const;
+
+    /**
+     * @brief Retrieve the number of values added.
+     * @return The number of values.
+     */
+
+    uint64_t GetCount() const;
+
+    /**
+     * @brief Retrieve the mean of the values added.
+     * @return The mean (0 if no value has been added).
+     */
+
+    double GetMean() const;
+
+    /**
+     * @brief Retrieve the greatest value added.
+     * @return The greatest value (0 if no value has been added).
+     */
+
+    double GetMax() const;
+};
+
+/**
+ * @brief Counters and histograms maintained by an Ibgp2d instance, to size
+ *   the daemon according to the topology.
+ */
+
+struct Ibgp2dStats {
+    uint64_t        numLsas;                 /**< LSAs sniffed in the LS-Update packets. */
+    uint64_t        numLsasChanged;          /**< LSAs which have altered the IGP graph of an area. */
+    uint64_t        numSpfRuns;              /**< Recomputations of the shortest path trees. */
+    uint64_t        numFilterEntriesAdded;   /**< Prefix-list entries added in bgpd. */
+    uint64_t        numFilterEntriesRemoved; /**< Prefix-list entries removed from bgpd. */
+    uint64_t        numBgpCommands;          /**< Commands sent to bgpd. */
+    uint64_t        numBgpCommandsFailed;    /**< Commands rejected by bgpd. */
+    Ibgp2dHistogram spfTime;                 /**< Wall-clock time of the recomputations (in seconds). */
+    Ibgp2dHistogram pushDelay;               /**< Simulated time from the first LSA altering the IGP graph to the push in bgpd (in seconds). */
+
+    /**
+     * @brief Constructor (every counter is set to 0).
+     */
+
+    Ibgp2dStats();
+
+    /**
+     * @brief Reset the counters and the histograms.
+     */
+
+    void Clear();
+
+    /**
+     * @brief Write the header of the CSV written by WriteCsv().
+     * @param os The output stream.
+     * @return The output stream.
+     */
+
+    static std::ostream & WriteCsvHeader(std::ostream & os);
+
+    /**
+     * @brief Write these statistics in CSV, one line per counter and one
+     *   line per histogram bin (router_id,metric,bin_start,value).
+     * @param os The output stream.
+     * @param routerId The router-id of the Ibgp2d instance.
+     * @return The output stream.
+     */
+
+    std::ostream & WriteCsv(std::ostream & os, const Ipv4Address & routerId) const;
+};
+
+} // namespace ns3
+
+#endif
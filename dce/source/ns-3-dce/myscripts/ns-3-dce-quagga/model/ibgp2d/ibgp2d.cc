@@ -21,37 +21,40 @@
  */
 #include "ibgp2d.h"
 
-#define LOCALHOST       "127.0.0.1"
 #define DUMMY_ROUTER_ID "0.0.0.0"
 
-#define EOT             char(0x4)            // End of Transmission
 #define RE_IPV4      "(\\d{1,3}\\.\\d{1,3}\\.\\d{1,3}\\.\\d{1,3})"
 
-#include <cstdlib>                          // malloc
+#include <algorithm>                        // std::count, std::sort, std::unique
 #include <iostream>                         // std::cerr
 #include <regex>                            // std:regex
 #include <sstream>                          // std::ostringstream
 #include <string>                           // std::string
 #include <vector>                           // std::vector
 
-#include <boost/foreach.hpp>                // BOOST_FOREACH
-#include <boost/graph/adjacency_list.hpp>   // boost::target
-#include <boost/graph/dijkstra_shortest_paths.hpp>
-#include <boost/property_map/function_property_map.hpp>
+#include <boost/tuple/tuple.hpp>            // boost::tie
 
 #include "ns3/bgp-config.h"                 // ns3::BgpConfig
+#include "ns3/boolean.h"                    // ns3::BooleanValue
 #include "ns3/ipv4.h"                       // ns3::Ipv4
 #include "ns3/ipv4-address.h"               // ns3::Ipv4Address
 #include "ns3/log.h"                        // NS_LOG_*
 #include "ns3/loopback-net-device.h"        // LoopbackNetDevice
 #include "ns3/node.h"                       // ns3::Node
+#include "ns3/nstime.h"                     // ns3::TimeValue
+#include "ns3/prefix-list.h"                // ns3::PrefixListElement
 #include "ns3/object-factory.h"             // ns3::CreateObject
 #include "ns3/ptr.h"                        // ns3::Ptr
 #include "ns3/simulator.h"                  // ns3::Simulator
+#include "ns3/singleton.h"                  // ns3::Singleton
+#include "ns3/trace-source-accessor.h"      // ns3::MakeTraceSourceAccessor
 #include "ns3/type-id.h"                    // ns3::TypeId
+#include "ns3/uinteger.h"                   // ns3::UintegerValue
 
 #include "../quagga/bgpd/bgp-config.h"      // ns3::BgpConfig
-#include "../ospf-graph/ospf-packet.h"      // ns3::OspfLsa*
+#include "ibgp2d-batch.h"                   // ns3::Ibgp2dBatch
+#include "../ospf-graph/ospf-lsa-view.h"    // ns3::ospf::ParseOspfLsUpdate
+#include "../ospf-graph/ospf-packet.h"      // ns3::GetOspfPacketType
 
 // DEBUG
 // #include "../pcap-wrapper.h"                // PacketWritePcap
@@ -68,23 +71,20 @@ NS_OBJECT_ENSURE_REGISTERED (Ibgp2d);
 //---------------------------------------------------------------------------------
 
 /**
- * Ideally ns3::Packet should provide a GetBuffer method providing
- * a read-only access to the packet's buffer. Unfortunately, this
- * is not the case, so for now, we have to copy the carried bytes.
- * \param p A pointer to a ns3::Packet instance.
- * \returns The address of the Packet's buffer (copy), NULL if
- *    not enough memory.
+ * @brief Build the prefix-list entry permitting the nexthops of a prefix.
+ *   "match ip next-hop prefix-list" tests the nexthop as a /32, so the
+ *   entry must match the longer prefixes ("le 32"). bgpd rejects "le 32"
+ *   on a /32 and on "any", which already match every nexthop they cover.
+ * @param prefix The prefix of the nexthops.
+ * @param seq The sequence number of the entry.
+ * @return The corresponding entry.
  */
 
-static uint8_t * PacketGetBuffer (Ptr<const Packet> p) {
-    uint32_t packetSize = p->GetSize();
-    uint8_t * buffer;
-
-    if ( (buffer = (uint8_t *) malloc (packetSize))) {
-        p->CopyData (buffer, packetSize);
+static PrefixListElement MakeNexthopPrefixListElement (const Ipv4Prefix & prefix, uint32_t seq) {
+    if (prefix == Ipv4Prefix::Any() || prefix.GetPrefixLength() == 32) {
+        return PrefixListElement (PERMIT, prefix, seq);
     }
-
-    return buffer;
+    return PrefixListElement (PERMIT, prefix, LE, 32, seq);
 }
 
 //---------------------------------------------------------------------------------
@@ -92,23 +92,151 @@ static uint8_t * PacketGetBuffer (Ptr<const Packet> p) {
 //---------------------------------------------------------------------------------
 
 Ibgp2d::Ibgp2d() :
+    m_bgpConfigChannel (0),
+    m_isBgpdConnected (false),
+    m_vtyKeepAlive (Seconds (60)),
     m_routerId (DUMMY_ROUTER_ID),
-    m_telnetBgp (0),
+    m_sharedCache (true),
+    m_incrementalSpf (true),
+    m_numThreads (1),
+    m_workerPool (NULL),
+    m_batchMode (false),
+    m_batchPending (false),
+    m_communityTags (false),
+    m_isTagging (false),
+    m_spfInitialDelay (Seconds (0)),
+    m_spfHoldTime (Seconds (0)),
+    m_spfMaxHoldTime (Seconds (0)),
+    m_spfHold (Seconds (0)),
+    m_spfLastRun (Seconds (0)),
+    m_flushInterval (Seconds (0)),
+    m_lastFlush (Seconds (0)),
+    m_fibInstallDelay (Seconds (0)),
+    m_lastIgpChange (Seconds (0)),
+    m_hasNeighbors (false),
     m_lastFilterId (0),
-    m_bgpdWasRunning (false)
+    m_bgpdWasRunning (false),
+    m_spfTimeBinWidth (MicroSeconds (100)),
+    m_pushDelayBinWidth (MilliSeconds (100)),
+    m_hasPendingChange (false),
+    m_firstPendingChange (Seconds (0))
 {
     NS_LOG_FUNCTION (this);
-    this->m_ospfGraphHelper = CreateObject<OspfGraphHelper>();
 }
 
 Ibgp2d::~Ibgp2d() {
     NS_LOG_FUNCTION (this);
+    delete this->m_workerPool;
+    delete this->m_bgpConfigChannel;
 }
 
 TypeId Ibgp2d::GetTypeId () {
     static TypeId tid = TypeId ("ns3::Ibgp2d")
                         .SetParent<Application> ()
                         .AddConstructor<Ibgp2d> ()
+                        .AddAttribute ("IncrementalSpf",
+                                       "Repair the shortest path tree of each IGP neighbor according to the "
+                                       "IGP changes instead of recomputing it from scratch.",
+                                       BooleanValue (true),
+                                       MakeBooleanAccessor (&Ibgp2d::m_incrementalSpf),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("SharedFirstHopCache",
+                                       "Share the first hops computed over a given LSDB content with the "
+                                       "other iBGP2 daemons of the simulation (see OspfFirstHopCache).",
+                                       BooleanValue (true),
+                                       MakeBooleanAccessor (&Ibgp2d::m_sharedCache),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("NumThreads",
+                                       "Number of threads computing the shortest path trees of the IGP "
+                                       "neighbors (1: sequential).",
+                                       UintegerValue (1),
+                                       MakeUintegerAccessor (&Ibgp2d::m_numThreads),
+                                       MakeUintegerChecker<uint32_t> (1))
+                        .AddAttribute ("BatchMode",
+                                       "Defer the recomputations triggered at a given time to a batch "
+                                       "processing every iBGP2 daemon concerned at the end of this "
+                                       "timestamp (see Ibgp2dBatch).",
+                                       BooleanValue (false),
+                                       MakeBooleanAccessor (&Ibgp2d::m_batchMode),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("CommunityTags",
+                                       "Tag the routes learned by each ASBR from its eBGP neighbors with "
+                                       "a community encoding its router-id, and filter the routes "
+                                       "according to this community instead of their nexthop.",
+                                       BooleanValue (false),
+                                       MakeBooleanAccessor (&Ibgp2d::m_communityTags),
+                                       MakeBooleanChecker ())
+                        .AddAttribute ("SpfInitialDelay",
+                                       "Delay between the first IGP change of a quiet period and the "
+                                       "recomputation of the iBGP2 redistribution (SPF throttling).",
+                                       TimeValue (Seconds (0)),
+                                       MakeTimeAccessor (&Ibgp2d::m_spfInitialDelay),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("SpfHoldTime",
+                                       "Minimal time between two consecutive recomputations. It is doubled "
+                                       "each time an IGP change occurs during the hold time "
+                                       "(0 and SpfInitialDelay = 0: no throttling).",
+                                       TimeValue (Seconds (0)),
+                                       MakeTimeAccessor (&Ibgp2d::m_spfHoldTime),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("SpfMaxHoldTime",
+                                       "Upper bound of the hold time between two consecutive "
+                                       "recomputations.",
+                                       TimeValue (Seconds (0)),
+                                       MakeTimeAccessor (&Ibgp2d::m_spfMaxHoldTime),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("MinFlushInterval",
+                                       "Minimal time between two pushes of the iBGP2 filters in bgpd. The "
+                                       "changes computed meanwhile are merged, so that bgpd only receives "
+                                       "their net effect (0: no rate limiting).",
+                                       TimeValue (Seconds (0)),
+                                       MakeTimeAccessor (&Ibgp2d::m_flushInterval),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("FibInstallDelay",
+                                       "Time given to zebra to install the routes of an IGP change before "
+                                       "refreshing the iBGP2 neighbors (0: refresh as soon as the filters "
+                                       "are installed).",
+                                       TimeValue (Seconds (0)),
+                                       MakeTimeAccessor (&Ibgp2d::m_fibInstallDelay),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("VtyKeepAlive",
+                                       "Idle time after which an empty line is sent to the bgpd VTY to keep "
+                                       "the session open (0: no keepalive). Only used by the default "
+                                       "VtyBgpConfigChannel.",
+                                       TimeValue (Seconds (60)),
+                                       MakeTimeAccessor (&Ibgp2d::m_vtyKeepAlive),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("SpfTimeBinWidth",
+                                       "Width of the bins of the histogram of the wall-clock time of the "
+                                       "recomputations. In batch mode, a recomputation lasts as long as "
+                                       "the whole batch.",
+                                       TimeValue (MicroSeconds (100)),
+                                       MakeTimeAccessor (&Ibgp2d::m_spfTimeBinWidth),
+                                       MakeTimeChecker ())
+                        .AddAttribute ("PushDelayBinWidth",
+                                       "Width of the bins of the histogram of the simulated time from the "
+                                       "first LSA altering the IGP graph to the push in bgpd.",
+                                       TimeValue (MilliSeconds (100)),
+                                       MakeTimeAccessor (&Ibgp2d::m_pushDelayBinWidth),
+                                       MakeTimeChecker ())
+                        .AddTraceSource ("BgpCommandFailed",
+                                         "A command sent to bgpd has been rejected (command, error message).",
+                                         MakeTraceSourceAccessor (&Ibgp2d::m_bgpCommandFailedTrace))
+                        .AddTraceSource ("LsUpdate",
+                                         "A LS-Update has been sniffed (number of LSAs, number of LSAs "
+                                         "altering the IGP graph).",
+                                         MakeTraceSourceAccessor (&Ibgp2d::m_lsUpdateTrace))
+                        .AddTraceSource ("SpfRun",
+                                         "The shortest path trees have been recomputed (number of IGP "
+                                         "neighbors, wall-clock time).",
+                                         MakeTraceSourceAccessor (&Ibgp2d::m_spfRunTrace))
+                        .AddTraceSource ("Push",
+                                         "The iBGP2 filters have been pushed in bgpd (prefix-list entries "
+                                         "added, entries removed, delay since the first IGP change pushed).",
+                                         MakeTraceSourceAccessor (&Ibgp2d::m_pushTrace))
+                        .AddTraceSource ("BgpCommandsSent",
+                                         "Commands have been sent to bgpd (number of commands).",
+                                         MakeTraceSourceAccessor (&Ibgp2d::m_bgpCommandsSentTrace))
                         ;
     return tid;
 }
@@ -116,6 +244,9 @@ TypeId Ibgp2d::GetTypeId () {
 void Ibgp2d::StartApplication() {
     NS_LOG_FUNCTION (this);
 
+    this->m_stats.spfTime.SetBinWidth (this->m_spfTimeBinWidth.GetSeconds());
+    this->m_stats.pushDelay.SetBinWidth (this->m_pushDelayBinWidth.GetSeconds());
+
     Ptr<Node> node = this->GetNode();
     Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
     uint32_t numInterfaces = ipv4->GetNInterfaces();
@@ -142,14 +273,24 @@ void Ibgp2d::StartApplication() {
             continue;
         }
 
+        // The packets sniffed on a point-to-point device start with the
+        // 2-byte PPP header, the other devices (CSMA LANs) are framed in
+        // Ethernet. The context identifies the device in HandlePacket.
+        std::ostringstream context;
+        context << i;
+        uint32_t linkHeaderSize = device->IsPointToPoint() ? OSPF_PPP_HEADER_SIZE : OSPF_ETHERNET_HEADER_SIZE;
+        this->m_linkHeaderSizes[context.str()] = linkHeaderSize;
+
         NS_LOG_LOGIC (
             "Connecting sink to device " << i
             << " (IP = " << ipv4->GetAddress (i, 0)
-            << ", MTU = " << device->GetMtu () << ")."
+            << ", MTU = " << device->GetMtu ()
+            << ", link-layer header = " << linkHeaderSize << " bytes)."
         );
 
-        bool result = device->TraceConnectWithoutContext (
+        bool result = device->TraceConnect (
             "Sniffer",
+            context.str(),
             MakeCallback (&Ibgp2d::HandlePacket, this)
         );
 
@@ -159,6 +300,16 @@ void Ibgp2d::StartApplication() {
 
 void Ibgp2d::StopApplication () {
     NS_LOG_FUNCTION (this);
+
+    if (this->m_batchPending) {
+        Singleton<Ibgp2dBatch>::Get()->Cancel (this);
+        this->m_batchPending = false;
+    }
+
+    Simulator::Cancel (this->m_spfEvent);
+    Simulator::Cancel (this->m_flushEvent);
+    Simulator::Cancel (this->m_refreshEvent);
+
     this->BgpdDisconnect();
 }
 
@@ -182,162 +333,360 @@ const Ibgp2d::rid_t & Ibgp2d::GetRouterId() const {
     return this->m_routerId;
 }
 
-const OspfGraphHelper * Ibgp2d::GetOspfGraphHelper() const {
+const OspfGraphHelper * Ibgp2d::GetOspfGraphHelper (const Ipv4Address & areaId) const {
+    NS_LOG_FUNCTION (this << areaId);
+    MapAreas::const_iterator fit (this->m_areas.find (areaId));
+    return (fit != this->m_areas.end()) ? GetPointer (fit->second.ospfGraphHelper) : NULL;
+}
+
+void Ibgp2d::GetAreaIds (std::vector<Ipv4Address> & areaIds) const {
     NS_LOG_FUNCTION (this);
-    return GetPointer (this->m_ospfGraphHelper);
+    for (const auto & p : this->m_areas) {
+        areaIds.push_back (p.first);
+    }
 }
 
-void Ibgp2d::HandlePacket (Ptr<const Packet> p) {
-    NS_LOG_FUNCTION (this << p);
+const Ibgp2dStats & Ibgp2d::GetStats () const {
+    return this->m_stats;
+}
 
-    if (uint8_t * buffer =  PacketGetBuffer (p)) {
-        if (!IsOspfPacket (buffer)) {
-            NS_LOG_LOGIC ("Packet discarded (not OSPF)");
-            return;
+void Ibgp2d::ClearStats () {
+    NS_LOG_FUNCTION (this);
+    this->m_stats.Clear();
+}
+
+Ibgp2d::Area & Ibgp2d::GetArea (const Ipv4Address & areaId) {
+    NS_LOG_FUNCTION (this << areaId);
+
+    MapAreas::iterator fit (this->m_areas.find (areaId));
+    if (fit != this->m_areas.end()) {
+        return fit->second;
+    }
+
+    NS_LOG_LOGIC ("Router " << this->GetRouterId() << " belongs to area " << areaId);
+    Area & area = this->m_areas[areaId];
+    area.ospfGraphHelper = CreateObject<OspfGraphHelper>();
+    area.csrVersion = 0;
+    area.u = 0;
+    return area;
+}
+
+void Ibgp2d::HandlePacket (std::string context, Ptr<const Packet> p) {
+    NS_LOG_FUNCTION (this << context << p);
+    const uint32_t ipOffset = this->m_linkHeaderSizes[context];
+
+    // ns3::Packet does not provide a read-only access to its buffer, so the
+    // bytes must be copied. Most of the packets sniffed are not relevant
+    // (e.g. BGP sessions), so only their headers are copied to classify them.
+    uint8_t header[OSPF_PEEK_SIZE];
+    uint32_t headerSize = p->CopyData (header, OSPF_PEEK_SIZE);
+    uint8_t ospfType;
+
+    if (!GetOspfPacketType (header, headerSize, ospfType, ipOffset)) {
+        NS_LOG_LOGIC ("Packet discarded (not OSPF)");
+        return;
+    }
+
+    /*
+    // DEBUG
+    {
+        std::cout << "===============================================================" << std::endl;
+
+        std::string filename = MakePcapFilename();
+        std::ofstream ofs(filename);
+        if (ofs) {
+            std::cout << Ipv4Address(this->GetRouterId())
+                      << ": Writting " << filename << std::endl;
+            PacketWritePcap(ofs, Simulator::Now(), p, PcapHelper::DLT_PPP);
+            ofs.close();
+            tcpdump(std::cout, p);
+        }
+    }
+    */
+
+    // Only the LS-Update packets carry LSAs: they are copied in a buffer
+    // reused from one packet to another, and parsed into views over this
+    // buffer. Nothing is allocated in steady state.
+    this->m_lsas.clear();
+    const Area * areaLsas = NULL;
+    if (ospfType == OSPF_TYPE_LS_UPDATE) {
+        uint32_t packetSize = p->GetSize();
+        if (this->m_buffer.size() < packetSize) {
+            this->m_buffer.resize (packetSize);
+        }
+        p->CopyData (&this->m_buffer[0], packetSize);
+
+        // The LSAs are handled by the IGP graph of the area they have
+        // been sniffed in.
+        Ipv4Address areaId;
+        if (ospf::GetOspfAreaId (&this->m_buffer[0], packetSize, areaId, ipOffset)) {
+            ospf::ParseOspfLsUpdate (&this->m_buffer[0], packetSize, this->m_lsas, ipOffset);
+            areaLsas = &this->GetArea (areaId);
         }
+    }
 
-        /*
-        // DEBUG
-        {
-            std::cout << "===============================================================" << std::endl;
-
-            std::string filename = MakePcapFilename();
-            std::ofstream ofs(filename);
-            if (ofs) {
-                std::cout << Ipv4Address(this->GetRouterId())
-                          << ": Writting " << filename << std::endl;
-                PacketWritePcap(ofs, Simulator::Now(), p, PcapHelper::DLT_PPP);
-                ofs.close();
-                tcpdump(std::cout, p);
-            }
+    // Determine whether the IGP topology has changed. This is done for
+    // every area, even if the packet carries no LSA, so that the LSAs
+    // which are not refreshed anymore are withdrawn.
+    static const std::vector<ospf::OspfLsaView> noLsas;
+    bool hasChanged = false;
+    uint64_t numLsasChanged = 0;
+
+    for (auto & entry : this->m_areas) {
+        Area & area = entry.second;
+        uint64_t numLsasChangedPrev = area.ospfGraphHelper->GetNumLsasChanged();
+        area.ospfGraphHelper->SetRouterId (this->GetRouterId());
+        ospf::OspfChangeSet changes = area.ospfGraphHelper->HandleLsa (
+            (&area == areaLsas) ? this->m_lsas : noLsas
+        );
+        numLsasChanged += area.ospfGraphHelper->GetNumLsasChanged() - numLsasChangedPrev;
+
+        if (!changes.IsEmpty()) {
+            hasChanged = true;
+            area.changes.Merge (changes);
         }
-        */
+    }
+
+    if (!this->m_lsas.empty()) {
+        this->m_stats.numLsas += this->m_lsas.size();
+        this->m_stats.numLsasChanged += numLsasChanged;
+        this->m_lsUpdateTrace (this->m_lsas.size(), numLsasChanged);
+    }
+
+    // Recompute iBGP2 redistribution (possibly later).
+    if (hasChanged) {
+        this->m_lastIgpChange = Simulator::Now();
+        if (!this->m_hasPendingChange) {
+            this->m_hasPendingChange = true;
+            this->m_firstPendingChange = this->m_lastIgpChange;
+        }
+        this->ScheduleSpf();
+        return;
+    }
+
+    // A recomputation is pending: bgpd will be updated once it is done.
+    if (this->m_spfEvent.IsRunning() || this->m_batchPending) return;
+
+    this->UpdateBgpd (false);
+}
 
-        std::vector<OspfLsa *> lsas;
-        ExtractOspfLsa (buffer, lsas);
+void Ibgp2d::ScheduleSpf() {
+    NS_LOG_FUNCTION (this);
+
+    // The changes received meanwhile are merged in the Area, so they will
+    // be processed by the pending recomputation.
+    if (this->m_spfEvent.IsRunning()) {
+        NS_LOG_LOGIC ("Recomputation already scheduled");
+        return;
+    }
+
+    if (this->m_spfInitialDelay.IsZero() && this->m_spfHoldTime.IsZero()) {
+        this->RunSpf();
+        return;
+    }
+
+    // Like the OSPF SPF throttling: a change occurring after a quiet period
+    // (no recomputation during the current hold time) is processed after the
+    // initial delay. Otherwise the recomputation is deferred to the end of
+    // the hold time, and the hold time is doubled (up to its maximum).
+    Time now = Simulator::Now();
+    Time delay = this->m_spfInitialDelay;
+
+    if (now - this->m_spfLastRun >= this->m_spfHold) {
+        this->m_spfHold = this->m_spfHoldTime;
+    } else {
+        Time holdEnd = this->m_spfLastRun + this->m_spfHold - now;
+        if (holdEnd > delay) delay = holdEnd;
+        this->m_spfHold = std::min (
+            this->m_spfHold + this->m_spfHold,
+            std::max (this->m_spfMaxHoldTime, this->m_spfHoldTime)
+        );
+    }
 
-        // Determine whether the IGP topology has changed.
-        bool hasChanged = false;
-        if (!lsas.empty ()) {
-            this->m_ospfGraphHelper->SetRouterId (this->GetRouterId());
-            hasChanged = this->m_ospfGraphHelper->HandleLsa (lsas);
-            for (auto & lsa : lsas) delete lsa;
+    NS_LOG_LOGIC ("Recomputation scheduled in " << delay.GetSeconds() << "s (hold time = " << this->m_spfHold.GetSeconds() << "s)");
+    this->m_spfEvent = Simulator::Schedule (delay, &Ibgp2d::RunSpf, this);
+}
+
+void Ibgp2d::RunSpf() {
+    NS_LOG_FUNCTION (this);
+    this->m_spfLastRun = Simulator::Now();
+
+    // In batch mode, the recomputation and the push in bgpd are deferred
+    // to the end of the current timestamp (see Ibgp2dBatch).
+    if (this->m_batchMode) {
+        if (!this->m_batchPending) {
+            this->m_batchPending = true;
+            Singleton<Ibgp2dBatch>::Get()->Enqueue (this);
         }
-        free (buffer);
+        return;
+    }
+
+    this->UpdateIbgp2Redistribution();
+    this->UpdateBgpd (true);
+}
+
+void Ibgp2d::UpdateBgpd (bool hasChanged) {
+    NS_LOG_FUNCTION (this << hasChanged);
+
+    // Push (if possible) iBGP2d filters in bgpd.
+
+    // TODO:
+    // We must check whether bgpd is running. This should be checked by
+    // testing whether the telnet bgpd client embedded in iBGP2d connects
+    // successfully to bgpd. For sake of simplicity, we simply tests here
+    // if bgpd has already started.
+
+    Ptr<BgpConfig> bgpConfig = this->GetNode()->GetObject<BgpConfig>();
+    NS_ASSERT(bgpConfig);
+    Time bgpdStartTime = bgpConfig->GetStartTime();
+    bool bgpdIsRunning = ( bgpdStartTime < Simulator::Now() );
 
-        // Recompute iBGP2 redistribution.
+    if (bgpdIsRunning) {
+        // Update filters
         if (hasChanged) {
-            UpdateIbgp2Redistribution();
-        }
-
-        // Push (if possible) iBGP2d filters in bgpd.
-
-        // TODO:
-        // We must check whether bgpd is running. This should be checked by
-        // testing whether the telnet bgpd client embedded in iBGP2d connects
-        // successfully to bgpd. For sake of simplicity, we simply tests here
-        // if bgpd has already started.
-
-        Ptr<BgpConfig> bgpConfig = this->GetNode()->GetObject<BgpConfig>();
-        NS_ASSERT(bgpConfig);
-        Time bgpdStartTime = bgpConfig->GetStartTime();
-        bool bgpdIsRunning = ( bgpdStartTime < Simulator::Now() );
-
-        if (bgpdIsRunning) {
-            // Update filters
-            if (hasChanged) {
-                NS_LOG_DEBUG("[IBGP2]: " << this->GetRouterId() << ": IGP topology has changed");
-                this->UpdateBgpConfiguration();
-            } else if (!this->m_bgpdWasRunning) {
-                NS_LOG_DEBUG("[IBGP2]: " << this->GetRouterId() << ": bgpd starts");
-                this->UpdateBgpConfiguration();
-            }
-        } else if (!bgpdIsRunning) {
-            /*
-            NS_LOG_DEBUG(
-                "[IBGP2]: " << this->GetRouterId()
-                      << ": bgpd is not yet running: bgpdStartTime = "
-                      << bgpdStartTime.GetSeconds() << " > t = "
-                      << Simulator::Now().GetSeconds()
-            );
-            */
+            NS_LOG_DEBUG("[IBGP2]: " << this->GetRouterId() << ": IGP topology has changed");
+            this->ScheduleBgpConfiguration();
+        } else if (!this->m_bgpdWasRunning) {
+            NS_LOG_DEBUG("[IBGP2]: " << this->GetRouterId() << ": bgpd starts");
+            this->ScheduleBgpConfiguration();
         }
+    } else if (!bgpdIsRunning) {
+        /*
+        NS_LOG_DEBUG(
+            "[IBGP2]: " << this->GetRouterId()
+                  << ": bgpd is not yet running: bgpdStartTime = "
+                  << bgpdStartTime.GetSeconds() << " > t = "
+                  << Simulator::Now().GetSeconds()
+        );
+        */
+    }
+
+    // Update bgpdWasRunning flag.
+    this->m_bgpdWasRunning = bgpdIsRunning;
+}
+
+void Ibgp2d::ScheduleBgpConfiguration() {
+    NS_LOG_FUNCTION (this);
+
+    // The pending push will install the filters computed meanwhile.
+    if (this->m_flushEvent.IsRunning()) {
+        NS_LOG_LOGIC ("Push already scheduled");
+        return;
+    }
+
+    Time now = Simulator::Now();
+    Time next = this->m_lastFlush + this->m_flushInterval;
 
-        // Update bgpdWasRunning flag.
-        this->m_bgpdWasRunning = bgpdIsRunning;
+    if (this->m_flushInterval.IsZero() || next <= now) {
+        this->UpdateBgpConfiguration();
+        return;
     }
+
+    NS_LOG_LOGIC ("Push scheduled in " << (next - now).GetSeconds() << "s");
+    this->m_flushEvent = Simulator::Schedule (next - now, &Ibgp2d::UpdateBgpConfiguration, this);
 }
 
 bool Ibgp2d::UpdateBgpConfiguration() {
     NS_LOG_FUNCTION (this);
+    this->m_lastFlush = Simulator::Now();
     std::ostringstream oss;
     std::set<Ipv4Address> neighborsAltered;
 
     // Craft the string of command that will be transmitted to bgpd.
     oss << "#-------------------------BEGIN------------------- t = "
         << Simulator::Now().GetSeconds() << std::endl;
+    bool isTaggingAltered = this->m_communityTags && !this->m_isTagging;
+    if (isTaggingAltered) {
+        this->BgpWriteCommunityTagging (oss);
+    }
+
+    uint64_t numEntriesAdded = this->m_stats.numFilterEntriesAdded;
+    uint64_t numEntriesRemoved = this->m_stats.numFilterEntriesRemoved;
     size_t numNeighborsAltered = this->WriteIbgp2Filters (oss, neighborsAltered);
     oss << "#--------------------------END--------------------" << std::endl;
 
     NS_LOG_DEBUG(numNeighborsAltered << " altered neighbors:" << std::endl << oss.str());
 
-    if (numNeighborsAltered) {
-        // Note; previously I was directly calling:
-        // this->RefreshIbgp2Neighbors(neighborsAltered);
-
-        // Wait 1s in order to let the FIB being updated. This avoid to
-        // forward the current best route which sometimes, is no more the
-        // optimal one once the IGP packet is processed.
-
-        Simulator::ScheduleWithContext (
-            Simulator::GetContext(),
-            Seconds (1),
-            &Ibgp2d::RefreshIbgp2Neighbors,
-            this,
-            neighborsAltered
+    // The channel keeps the session alive, send only actual changes.
+    this->BgpdConnect();
+    if (numNeighborsAltered || isTaggingAltered) {
+        const std::string commands = oss.str();
+        this->CountBgpCommands (commands);
+        this->m_bgpConfigChannel->Configure (commands);
+
+        Time delay = this->m_hasPendingChange ? Simulator::Now() - this->m_firstPendingChange : Seconds (0);
+        if (this->m_hasPendingChange) {
+            this->m_stats.pushDelay.AddValue (delay.GetSeconds());
+        }
+        this->m_pushTrace (
+            this->m_stats.numFilterEntriesAdded - numEntriesAdded,
+            this->m_stats.numFilterEntriesRemoved - numEntriesRemoved,
+            delay
         );
+    }
 
-    } else {
-        oss.flush();
-        oss << "write terminal" << std::endl;
+    // The IGP changes are reflected in bgpd, unless a recomputation is
+    // still pending.
+    if (!this->m_spfEvent.IsRunning() && !this->m_batchPending) {
+        this->m_hasPendingChange = false;
+    }
+
+    if (numNeighborsAltered) {
+        this->ScheduleRefresh (neighborsAltered);
     }
 
-    this->BgpdConnect();
-    this->m_telnetBgp->AppendCommand (oss.str());
     return (numNeighborsAltered > 0);
 }
 
-void Ibgp2d::RefreshIbgp2Neighbors (std::set< Ipv4Address > & neighborsAltered) {
+void Ibgp2d::ScheduleRefresh (const std::set<Ipv4Address> & neighborsAltered) {
     NS_LOG_FUNCTION (this);
+    this->m_neighborsToRefresh.insert (neighborsAltered.begin(), neighborsAltered.end());
+
+    // The pending refresh will also cover these neighbors.
+    if (this->m_refreshEvent.IsRunning()) return;
+
+    Time now = Simulator::Now();
+    Time fibInstalled = this->m_lastIgpChange + this->m_fibInstallDelay;
+
+    if (fibInstalled <= now) {
+        this->RefreshIbgp2Neighbors();
+        return;
+    }
+
+    NS_LOG_LOGIC ("Refresh scheduled in " << (fibInstalled - now).GetSeconds() << "s");
+    this->m_refreshEvent = Simulator::Schedule (fibInstalled - now, &Ibgp2d::RefreshIbgp2Neighbors, this);
+}
+
+void Ibgp2d::RefreshIbgp2Neighbors () {
+    NS_LOG_FUNCTION (this);
+
+    if (this->m_neighborsToRefresh.empty()) {
+        return;
+    }
+
     std::cout << "t = " << Simulator::Now().GetSeconds()
               << ": Node [" << this->GetRouterId()
               << "]: updating iBGP configuration." << std::endl;
 
-    for (auto & n : neighborsAltered) {
+    for (auto & n : this->m_neighborsToRefresh) {
         std::cout << "t = " << Simulator::Now().GetSeconds()
                   << ": Node [" << this->GetRouterId() << "]:   updating "
                   << n << std::endl;
     }
 
-    if (neighborsAltered.empty()) {
-        return;
-    }
-
     std::ostringstream oss;
 
-    // bgpd(config)#
-    oss << EOT << std::endl;
-
     // bgpd#
-    for (auto & ip_v : neighborsAltered) {
-        oss << "clear ip bgp " << ip_v << " soft" << std::endl;
+    for (auto & ip_v : this->m_neighborsToRefresh) {
+        oss << "clear ip bgp " << ip_v << " soft out" << std::endl;
     }
 
-    // bgpd(config)#
-    oss << "configure terminal" << std::endl;
+    this->m_neighborsToRefresh.clear();
 
     this->BgpdConnect();
-    this->m_telnetBgp->AppendCommand (oss.str());
+    const std::string commands = oss.str();
+    this->CountBgpCommands (commands);
+    this->m_bgpConfigChannel->Execute (commands);
 }
 
 
@@ -354,117 +703,479 @@ std::ostream & operator << (std::ostream & os, const std::set<T> & s) {
 void Ibgp2d::UpdateIbgp2Redistribution() {
     NS_LOG_FUNCTION (this);
 
+    if (!this->PrepareIbgp2Redistribution()) {
+        return;
+    }
+
+    // The neighbors only share the (immutable) snapshot, so they can be
+    // processed concurrently.
+    if (this->m_numThreads > 1 && !this->m_workerPool) {
+        this->m_workerPool = new WorkerPool (this->m_numThreads);
+    }
+
+    WorkerPool::Task task = [this] (std::size_t i) {
+        this->ComputeIbgp2Redistribution (i);
+    };
+
+    if (this->m_workerPool) {
+        this->m_workerPool->Run (this->m_neighbors.size(), task);
+    } else {
+        for (std::size_t i = 0; i < this->m_neighbors.size(); ++i) task (i);
+    }
+
+    this->FinishIbgp2Redistribution();
+    this->ReleaseIbgp2Redistribution();
+}
+
+bool Ibgp2d::PrepareIbgp2Redistribution (Ibgp2dBatch * batch) {
+    NS_LOG_FUNCTION (this);
+
+    typedef ospf::OspfCsrGraph::arc_t    arc_t;
+
     // We denote by u this router and v each of its iBGP2/IGP neighbor
     const ospf::router_id_t & rid_u = this->GetRouterId();
     NS_ASSERT (rid_u != DUMMY_ROUTER_ID);
 
-    const ospf::OspfGraph & gospf = this->m_ospfGraphHelper->GetGraph ();
-
-    // Find the vertex corresponding to the managed router
-    vd_t u;
+    // The router embedding this iBGP2d instance does not yet belong to
+    // the IGP graph of any area or the router-id of this router is not yet
+    // known. We have to wait a bit more that the IGP converges...
     {
-        bool ok;
-        boost::tie (u, ok) = this->m_ospfGraphHelper->GetVertex (rid_u);
+        bool ok = false;
+        for (MapAreas::const_iterator it = this->m_areas.begin(); !ok && it != this->m_areas.end(); ++it) {
+            ok = it->second.ospfGraphHelper->GetVertex (rid_u).second;
+        }
 
-        // The router embedding this iBGP2d instance does not yet belong to
-        // the IGP graph or the router-id of this router is not yet known.
-        // We have to wait a bit more that the IGP converges...
         if (!ok) {
             // Note this "error" is normal while the IGP converges the first time.
             //NS_LOG_INFO ("[iBGP2]: " << rid_u << ": cannot find " << rid_u << " IGP graph." );
-            return;
+            return false;
         }
     }
 
-    // Compute the Dijkstra's algorithm from each IGP neighbor point of view.
-    BOOST_FOREACH (const ed_t & e_uv, boost::out_edges (u, gospf)) {
-        const vd_t & v = boost::target (e_uv, gospf);
+    // Fast path: if no arc has changed since the last computation and if the
+    // ASBRs are the same, the shortest paths and thus the ASBRs enabled for
+    // each neighbor are unchanged. Only the prefixes (external networks of
+    // the ASBRs, transit networks) must be remapped in the filters.
+    std::vector<vertex_t> asbrs;
+    bool isUnchanged = this->m_hasNeighbors;
+
+    for (MapAreas::const_iterator it = this->m_areas.begin(); isUnchanged && it != this->m_areas.end(); ++it) {
+        asbrs.clear();
+        this->GetAsbrs (it->second, asbrs);
+        isUnchanged = !it->second.changes.HasTopologyChanged() && asbrs == it->second.asbrs;
+    }
 
-        if (u == v) {
-            // Some loops are built in the OSPF graph to store metrics toward
-            // external networks. We can ignore those arc since we consider
-            // only neighbors v != u in iBGP2.
-            continue;
+    if (isUnchanged) {
+        NS_LOG_LOGIC ("IGP topology unchanged, only remap the prefixes");
+        for (auto & entry : this->m_areas) {
+            entry.second.csrVersion = entry.second.ospfGraphHelper->GetVersion();
+            entry.second.changes.Clear();
         }
+        this->UpdateIbgp2Filters();
+        return false;
+    }
 
-        const rid_t & rid_v = gospf[v].GetRouterId();
-        const ospf::OspfGraph & ospfGraph = this->m_ospfGraphHelper->GetGraph();
-        std::map<vd_t, vd_t> predecessors;
-        std::map<vd_t, uint32_t> distances;
+    ospf::OspfFirstHopCache * cache = this->m_sharedCache ?
+        Singleton<ospf::OspfFirstHopCache>::Get() :
+        NULL;
 
-        boost::dijkstra_shortest_paths (
-            ospfGraph,
-            v,
-            predecessor_map (boost::make_assoc_property_map (predecessors)).
-            weight_map (boost::make_function_property_map<ed_t, uint32_t> (
-                [&] (const ed_t & e) -> uint32_t {
-                    return ospfGraph[e].GetDistance();
-                }
-            )).
-            distance_map (boost::make_assoc_property_map (distances))
-        );
+    this->m_neighbors.clear();
+
+    for (auto & entry : this->m_areas) {
+        Area & area = entry.second;
+        const Ptr<OspfGraphHelper> & ospfGraphHelper = area.ospfGraphHelper;
+
+        // Rebuild the snapshot of the IGP graph only if it has changed.
+        uint32_t version = ospfGraphHelper->GetVersion();
+        if (area.csrVersion != version) {
+            area.csrGraph.Build (ospfGraphHelper->GetGraph());
+            area.csrVersion = version;
+            area.asbrs.clear();
+            this->GetAsbrs (area, area.asbrs);
+
+            if (this->m_sharedCache) {
+                area.signature.Build (area.csrGraph, area.asbrs);
+            }
+        }
 
-        std::set<rid_t> rids_n_enabled;
+        // Each tree records the IGP changes it does not reflect yet.
+        for (auto & q : area.spts) {
+            q.second.changes.Merge (area.changes);
+        }
+        area.changes.Clear();
+        area.sptsNext.clear();
 
-        if (predecessors[u] == v) {
-            // If we are here u is a child of v in the SPT rooted in v. Each node
-            // n belonging to the subtree rooted in u is potentially a nexthop
-            // announcing BGP routes that must be redistributed by u to v.
+        // Find the vertex corresponding to the managed router. It may not
+        // belong yet to the IGP graph of each of its areas.
+        vd_t u;
+        bool ok;
+        boost::tie (u, ok) = ospfGraphHelper->GetVertex (rid_u);
+        if (!ok) {
+            area.spts.clear();
+            continue;
+        }
 
-            BOOST_FOREACH (const vd_t & n, boost::vertices (gospf)) {
-                if (n == v) {
-                    // n announcements have no reason to transit via u to return
-                    // to v == n, so we filter them.
-                    continue;
+        // Compute the Dijkstra's algorithm from each IGP neighbor point of view,
+        // unless another router has already done it over the same LSDB content
+        // (or is about to do it in the same batch). The tree of a neighbor
+        // already known is repaired according to the arcs that have changed,
+        // the tree of a new neighbor is computed.
+        const ospf::OspfCsrGraph & g = area.csrGraph;
+        area.u = u;
+
+        for (arc_t a = g.GetOutBegin (u), end = g.GetOutEnd (u); a != end; ++a) {
+            const vertex_t n = g.GetTarget (a);
+
+            if (g.IsNetwork (n)) {
+                // Each router attached to a network of u is an IGP neighbor.
+                for (arc_t b = g.GetOutBegin (n), end_n = g.GetOutEnd (n); b != end_n; ++b) {
+                    const vertex_t v = g.GetTarget (b);
+                    if (v != u) this->PrepareNeighborSpf (area, v, cache, batch);
                 }
+            } else if (!ospfGraphHelper->HasAsbrSummary (rid_u, g.GetRouterId (n))) {
+                // An ASBR of another area is not an IGP neighbor.
+                this->PrepareNeighborSpf (area, n, cache, batch);
+            }
+        }
 
-                const ospf::router_id_t & rid_n = gospf[n].GetRouterId();
-                bool enableIbgp2_nuv = false;
+        // The trees of the routers which are no more IGP neighbors are dropped.
+        area.spts.clear();
+    }
 
-                // Walk along the shortest path from n to v. If we reach u just
-                // before reaching v, (n, u, v) satisfies the iBGP2 criterion
+    this->m_spfStart = std::chrono::steady_clock::now();
 
-                unsigned i;
-                for (vd_t vcur = n, i = 0; vcur != v ; vcur = predecessors[vcur], i++) {
+    // The other routers of the batch may reuse the trees computed here.
+    if (cache && batch) {
+        for (const NeighborSpf & neighbor : this->m_neighbors) {
+            if (!neighbor.isCached && !neighbor.producer) {
+                const Area & area = *neighbor.area;
+                batch->AddProducer (area.signature, area.csrGraph.GetRouterId (neighbor.v), &neighbor);
+            }
+        }
+    }
 
-                    if (vcur == predecessors[vcur]) {
-                        // vcur has no predecessor : it occurs if n is in the OSPF graph, but is unreachable from v.
-                        break;
-                    }
+    return true;
+}
 
-                    NS_ASSERT (i < boost::num_vertices (gospf)); // corrupted predecessors map ?
+void Ibgp2d::PrepareNeighborSpf (
+    Area & area,
+    vertex_t v,
+    ospf::OspfFirstHopCache * cache,
+    Ibgp2dBatch * batch
+) {
+    const rid_t & rid_v = area.csrGraph.GetRouterId (v);
 
-                    if (vcur == u) {
-                        enableIbgp2_nuv = true;
-                        break;
-                    }
-                }
+    // v may share several networks with u.
+    if (area.sptsNext.find (rid_v) != area.sptsNext.end()) return;
 
-                if (enableIbgp2_nuv) {
-                    rids_n_enabled.insert (rid_n);
-                }
-            } // for n
-        } else {
-            // predecessors[u] != v, so we must filter any iBGP announce from u to v.
-            // rids_n_enabled remains empty.
+    NeighborTree & tree = area.sptsNext[rid_v];
+    MapSpts::iterator fit (area.spts.find (rid_v));
+    if (fit != area.spts.end()) {
+        std::swap (tree, fit->second);
+    }
+
+    NeighborSpf neighbor;
+    neighbor.area = &area;
+    neighbor.v = v;
+    neighbor.tree = &tree;
+    neighbor.producer = NULL;
+    neighbor.isCached = false;
+    neighbor.isRepaired = false;
+    neighbor.isChild = false;
+
+    const ospf::OspfFirstHopCache::FirstHops * firstHops = cache ?
+        cache->Find (area.signature, rid_v) :
+        NULL;
+
+    if (firstHops) {
+        neighbor.isCached = true;
+        this->ApplyFirstHops (*firstHops, neighbor);
+    } else if (cache && batch && (neighbor.producer = batch->FindProducer (area.signature, rid_v))) {
+        // Another router of the batch computes this tree.
+    } else if (this->m_incrementalSpf && tree.spf.GetSource() == v && tree.spf.IsComplete()) {
+        neighbor.isRepaired = true;
+        this->GetArcsChanged (area, tree.changes, neighbor.arcsChanged);
+        tree.changes.Clear();
+    } else {
+        tree.changes.Clear();
+    }
+
+    this->m_neighbors.push_back (neighbor);
+}
+
+void Ibgp2d::ComputeIbgp2Redistribution (std::size_t i) {
+    NeighborSpf & neighbor = this->m_neighbors[i];
+
+    if (!neighbor.isCached && !neighbor.producer) {
+        this->ComputeNeighborSpf (neighbor);
+    }
+}
+
+void Ibgp2d::FinishIbgp2Redistribution () {
+    NS_LOG_FUNCTION (this);
+
+    ospf::OspfFirstHopCache * cache = this->m_sharedCache ?
+        Singleton<ospf::OspfFirstHopCache>::Get() :
+        NULL;
+
+    // The cache is updated sequentially in the order of the neighbors.
+    for (NeighborSpf & neighbor : this->m_neighbors) {
+        if (neighbor.producer) {
+            this->ApplyFirstHops (neighbor.producer->firstHops, neighbor);
+            neighbor.producer = NULL;
+        } else if (cache && !neighbor.isCached) {
+            const Area & area = *neighbor.area;
+            cache->Insert (area.signature, area.csrGraph.GetRouterId (neighbor.v), neighbor.firstHops);
         }
 
-        // Deduces from rids_n_enabled the corresponding prefixes
-        std::set<Ipv4Prefix> & enabledNexthops = this->m_mapFilters[rid_v];
+        // The ASBRs enabled for this neighbor are kept to remap the prefixes
+        // if only the external networks change. The first hops are kept
+        // until ReleaseIbgp2Redistribution, since the next routers of the
+        // batch may read them.
+        neighbor.arcsChanged.clear();
+        neighbor.tree = NULL;
+    }
+
+    this->m_hasNeighbors = true;
+    this->UpdateIbgp2Filters();
+
+    for (auto & entry : this->m_areas) {
+        entry.second.spts.swap (entry.second.sptsNext);
+        entry.second.sptsNext.clear();
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - this->m_spfStart;
+    ++this->m_stats.numSpfRuns;
+    this->m_stats.spfTime.AddValue (elapsed.count());
+    this->m_spfRunTrace (this->m_neighbors.size(), Seconds (elapsed.count()));
+}
+
+void Ibgp2d::ReleaseIbgp2Redistribution () {
+    NS_LOG_FUNCTION (this);
+
+    for (NeighborSpf & neighbor : this->m_neighbors) {
+        neighbor.firstHops.clear();
+    }
+}
+
+void Ibgp2d::UpdateIbgp2Filters () {
+    NS_LOG_FUNCTION (this);
+
+    typedef std::pair<const OspfGraphHelper *, rid_t> AsbrKey;
+
+    const rid_t & rid_u = this->GetRouterId();
 
-        if (predecessors[u] == v) {
+    // The filters are recomputed from scratch. A neighbor which is no more
+    // adjacent to u keeps an empty filter, so that WriteIbgp2Filters disables
+    // its previously enabled nexthops.
+    for (auto & p : this->m_mapFilters) {
+        p.second.reset();
+    }
+
+    // The external networks of an ASBR are indexed once, and then added to
+    // the filter of each neighbor for which this ASBR is enabled.
+    std::map<AsbrKey, Ipv4PrefixBitset> mapExternals;
+
+    // v is granted any nexthop if u is its first hop toward every other
+    // ASBR, in each area they share.
+    std::map<rid_t, bool> mapPermitAny;
+
+    for (const NeighborSpf & neighbor : this->m_neighbors) {
+        const Ptr<OspfGraphHelper> & ospfGraphHelper = neighbor.area->ospfGraphHelper;
+        const rid_t & rid_v = neighbor.area->csrGraph.GetRouterId (neighbor.v);
+
+        // A router adjacent to u in several areas gets the union of the
+        // nexthops enabled in each of them.
+        Ipv4PrefixBitset & enabledNexthops = this->m_mapFilters[rid_v];
+        this->m_mapInterfaces[rid_v] = ospfGraphHelper->GetInterface (rid_v, rid_u);
+
+        // Deduces from the enabled ASBRs the corresponding prefixes
+        if (neighbor.isChild && this->m_communityTags) {
+            // The communities of the enabled ASBRs, indexed as /32 prefixes.
+            this->m_prefixes.clear();
+            for (const rid_t & rid_n : neighbor.asbrs) {
+                this->m_prefixes.insert (Ipv4Prefix (rid_n, Ipv4Mask::GetOnes()));
+            }
+            this->m_prefixIndex.Insert (this->m_prefixes, enabledNexthops);
+        } else if (neighbor.isChild) {
             // TODO We should enumerate the IP of u in the filter.
             // For the moment we use a simpler implementation : we only accept
             // the interface of v directly connected to u.
-            this->m_ospfGraphHelper->GetTransitNetworks (rid_u, rid_v, enabledNexthops);
+            this->m_prefixes.clear();
+            ospfGraphHelper->GetTransitNetworks (rid_u, rid_v, this->m_prefixes);
+            this->m_prefixIndex.Insert (this->m_prefixes, enabledNexthops);
 
-            for (const rid_t & rid_n : rids_n_enabled) {
+            for (const rid_t & rid_n : neighbor.asbrs) {
                 // External networks connected to the ASBR identified by rid_n
-                this->m_ospfGraphHelper->GetExternalNetworks (rid_n, enabledNexthops);
+                AsbrKey key (PeekPointer (ospfGraphHelper), rid_n);
+                std::map<AsbrKey, Ipv4PrefixBitset>::iterator fit (mapExternals.find (key));
+
+                if (fit == mapExternals.end()) {
+                    fit = mapExternals.insert (std::make_pair (key, Ipv4PrefixBitset())).first;
+                    this->m_prefixes.clear();
+                    ospfGraphHelper->GetExternalNetworks (rid_n, this->m_prefixes);
+                    this->m_prefixIndex.Insert (this->m_prefixes, fit->second);
+                }
+
+                Ipv4PrefixIndex::Union (enabledNexthops, fit->second);
+            }
+        } else {
+            // predecessors[u] != v, so we must filter any iBGP announce from u to v.
+        }
+
+        const std::vector<vertex_t> & asbrs = neighbor.area->asbrs;
+        std::size_t numAsbrs = asbrs.size() - std::count (asbrs.begin(), asbrs.end(), neighbor.v);
+        bool permitAny = neighbor.isChild && !neighbor.asbrs.empty() && neighbor.asbrs.size() == numAsbrs;
+        mapPermitAny.insert (std::make_pair (rid_v, true)).first->second &= permitAny;
+    } // for v
+
+    // The filter then collapses into 0.0.0.0/0 (see Ipv4PrefixAggregate).
+    // In community mode, the filter is bounded by the number of ASBRs.
+    if (this->m_communityTags) return;
+
+    this->m_prefixes.clear();
+    this->m_prefixes.insert (Ipv4Prefix (Ipv4Address::GetAny(), Ipv4Mask::GetZero()));
+
+    for (const auto & p : mapPermitAny) {
+        if (p.second) {
+            this->m_prefixIndex.Insert (this->m_prefixes, this->m_mapFilters[p.first]);
+        }
+    }
+}
+
+void Ibgp2d::GetAsbrs (const Area & area, std::vector<vertex_t> & asbrs) const {
+    NS_LOG_FUNCTION (this);
+
+    // Only the ASBRs have external networks, so the iBGP2 criterion is
+    // only evaluated for them. An ASBR may be known through its external
+    // LSAs before appearing in the IGP graph (or in an ASBR Summary LSA).
+    std::vector<rid_t> rids_asbr;
+    area.ospfGraphHelper->GetAsbrs (rids_asbr);
+
+    for (const rid_t & rid_n : rids_asbr) {
+        vd_t n;
+        bool ok;
+        boost::tie (n, ok) = area.ospfGraphHelper->GetVertex (rid_n);
+        if (ok) asbrs.push_back (n);
+    }
+}
+
+void Ibgp2d::ApplyFirstHops (
+    const ospf::OspfFirstHopCache::FirstHops & firstHops,
+    NeighborSpf & neighbor
+) const {
+    const ospf::OspfCsrGraph & g = neighbor.area->csrGraph;
+    const rid_t & rid_u = this->GetRouterId();
+    rid_t rid_fh;
+
+    // The first hop from v toward u is u iif u is a child of v.
+    neighbor.isChild = ospf::OspfFirstHopCache::GetFirstHop (firstHops, rid_u, rid_fh) && rid_fh == rid_u;
+    neighbor.asbrs.clear();
+
+    if (neighbor.isChild) {
+        for (vertex_t n : neighbor.area->asbrs) {
+            const rid_t & rid_n = g.GetRouterId (n);
+            if (ospf::OspfFirstHopCache::GetFirstHop (firstHops, rid_n, rid_fh) && rid_fh == rid_u) {
+                neighbor.asbrs.push_back (rid_n);
+            }
+        }
+    }
+}
+
+void Ibgp2d::GetArcsChanged (
+    const Area & area,
+    const ospf::OspfChangeSet & changes,
+    std::vector<ospf::OspfSpf::Arc> & arcs
+) const {
+    NS_LOG_FUNCTION (this);
+
+    // Vertices are never removed from the IGP graph, so both ends are still
+    // there even if the arc has been removed, and the vertex descriptors of
+    // the IGP graph are the vertices of its snapshot.
+    const ospf::OspfChangeSet::Arcs * arcSets[] = {
+        &changes.GetArcsAdded(),
+        &changes.GetArcsRemoved(),
+        &changes.GetMetricsChanged()
+    };
+
+    for (const ospf::OspfChangeSet::Arcs * arcSet : arcSets) {
+        for (const ospf::OspfChangeSet::Arc & arc : *arcSet) {
+            NS_ASSERT (arc.first < area.csrGraph.GetNumVertices() && arc.second < area.csrGraph.GetNumVertices());
+            arcs.push_back (std::make_pair (vertex_t (arc.first), vertex_t (arc.second)));
+        }
+    }
+}
+
+void Ibgp2d::ComputeNeighborSpf (NeighborSpf & neighbor) const {
+    const Area & area = *neighbor.area;
+    const ospf::OspfCsrGraph & g = area.csrGraph;
+    ospf::OspfSpf & spf = neighbor.tree->spf;
+    const vertex_t u = area.u;
+    const vertex_t v = neighbor.v;
+
+    // The first hops are needed toward the ASBRs, and toward the neighbors
+    // of v to know which of them are children of v (u, or the other routers
+    // reusing the cache). The neighbors attached to a network of v are
+    // reached through the corresponding network vertex.
+    std::vector<vertex_t> targets (area.asbrs);
+    for (ospf::OspfCsrGraph::arc_t a = g.GetOutBegin (v), end = g.GetOutEnd (v); a != end; ++a) {
+        const vertex_t n = g.GetTarget (a);
+
+        if (g.IsNetwork (n)) {
+            for (ospf::OspfCsrGraph::arc_t b = g.GetOutBegin (n), end_n = g.GetOutEnd (n); b != end_n; ++b) {
+                targets.push_back (g.GetTarget (b));
+            }
+        } else {
+            targets.push_back (n);
+        }
+    }
+
+    // A search from scratch can stop once the targets are settled. An
+    // incremental search needs the whole tree to be repaired later.
+    if (neighbor.isRepaired) {
+        if (!neighbor.arcsChanged.empty()) {
+            spf.Update (g, neighbor.arcsChanged);
+        }
+    } else if (this->m_incrementalSpf) {
+        spf.Compute (g, v);
+    } else {
+        spf.Compute (g, v, targets);
+    }
+
+    // With equal cost paths, u may be reached through another neighbor of
+    // v having a lower router-id: u is then not considered as a child of v,
+    // whatever the order in which the arcs have been relaxed.
+    neighbor.isChild = (spf.GetFirstHop (u) == u);
+    neighbor.asbrs.clear();
+
+    if (neighbor.isChild) {
+        // If we are here u is a child of v in the SPT rooted in v. Each
+        // ASBR n belonging to the subtree rooted in u, i.e. such that the
+        // first hop from v toward n is u, is potentially a nexthop
+        // announcing BGP routes that must be redistributed by u to v.
+        // n == v is skipped: its announcements have no reason to transit
+        // via u to return to v, and it has no first hop anyway.
+
+        for (vertex_t n : area.asbrs) {
+            if (spf.GetFirstHop (n) == u) {
+                neighbor.asbrs.push_back (g.GetRouterId (n));
             }
         }
+    }
 
-    } // for e_uv
+    if (this->m_sharedCache) {
+        neighbor.firstHops.clear();
+        for (vertex_t n : targets) {
+            if (n != v && spf.IsReachable (n)) {
+                neighbor.firstHops.push_back (std::make_pair (g.GetRouterId (n), g.GetRouterId (spf.GetFirstHop (n))));
+            }
+        }
+        std::sort (neighbor.firstHops.begin(), neighbor.firstHops.end());
+        neighbor.firstHops.erase (
+            std::unique (neighbor.firstHops.begin(), neighbor.firstHops.end()),
+            neighbor.firstHops.end()
+        );
+    }
 }
 
 size_t Ibgp2d::WriteIbgp2Filters (
@@ -477,107 +1188,178 @@ size_t Ibgp2d::WriteIbgp2Filters (
     const ospf::router_id_t & rid_u = this->GetRouterId();
     NS_ASSERT (rid_u != DUMMY_ROUTER_ID);
 
-    const ospf::OspfGraph & gospf = this->m_ospfGraphHelper->GetGraph ();
+    const std::size_t numPrefixes = this->m_prefixIndex.GetSize();
+    Ipv4PrefixBitset addedBits, removedBits;
+
+    // The bitsets are indexed over the same prefixes, so they are compared
+    // word by word once they have the same size.
+    for (auto & p : this->m_policies) {
+        p.second.filter.resize (numPrefixes);
+    }
 
     for (auto & p : this->m_mapFilters) {
 
         const rid_t & rid_v = p.first;
-        const std::set<Ipv4Prefix> & enabledNexthops = p.second;
+        Ipv4PrefixBitset & enabledNexthops = p.second;
+        enabledNexthops.resize (numPrefixes);
+
+        // If v is a new peer, all the nexthops n such (n, u, v) satisfies
+        // the iBGP2 criterion must be enabled: its previous filter is empty.
+        FilterId filterIdPrev = this->GetFilterId (rid_v);
+        if (filterIdPrev) {
+            if (this->m_policies[filterIdPrev].filter == enabledNexthops) continue;
+        } else if (enabledNexthops.none()) {
+            continue;
+        }
 
-        // Compute diff between the running and the new configuration.
-        std::set<Ipv4Prefix> addedPrefixes;
-        std::set<Ipv4Prefix> removedPrefixes;
+        // v joins the policy of the neighbors having the same filter, so
+        // that bgpd handles as many outbound policies as distinct filters.
+        // Otherwise, the policy of v is updated if v is its only neighbor,
+        // or a new policy is created.
+        FilterId filterId = this->FindPolicy (enabledNexthops);
+        bool isNewPolicy = false;
 
-        {
-            MapFilters::iterator fit (this->m_mapFiltersPrev.find (rid_v));
+        if (!filterId) {
+            if (filterIdPrev && this->m_policies[filterIdPrev].numNeighbors == 1) {
+                filterId = filterIdPrev;
+            } else {
+                filterId = this->CreatePolicy();
+                isNewPolicy = true;
+            }
+        }
 
-            if (fit != this->m_mapFiltersPrev.end()) {
-                // This iBPG2 neighbor v has some filters already installed.
-                std::set<Ipv4Prefix> & enabledPrefixesPrev = fit->second;
+        Policy & policy = this->m_policies[filterId];
+        bool isAltered = false;
+
+        if (isNewPolicy || policy.filter != enabledNexthops) {
+            // Compute diff between the running and the new configuration.
+            addedBits = enabledNexthops;
+            addedBits -= policy.filter;
+            removedBits = policy.filter;
+            removedBits -= enabledNexthops;
+            policy.filter = enabledNexthops;
+
+            std::set<Ipv4Prefix> addedPrefixes;
+            std::set<Ipv4Prefix> removedPrefixes;
+            this->m_prefixIndex.Get (addedBits, addedPrefixes);
+            this->m_prefixIndex.Get (removedBits, removedPrefixes);
+
+            // The prefix-list only stores the minimal covering set of the
+            // filter, so only the changes of this set are written. In
+            // community mode, the prefixes identify ASBRs and are not
+            // aggregated.
+            std::set<Ipv4Prefix> addedEntries;
+            std::set<Ipv4Prefix> removedEntries;
+
+            if (this->m_communityTags) {
+                addedEntries.swap (addedPrefixes);
+                removedEntries.swap (removedPrefixes);
+            }
 
-                // Find next-hop prefixes that are now allowed.
-                for (const Ipv4Prefix & prefix : enabledNexthops) {
-                    if (enabledPrefixesPrev.find (prefix) == enabledPrefixesPrev.end()) {
-                        addedPrefixes.insert (prefix);
-                        enabledPrefixesPrev.insert (prefix);
-                    }
-                }
+            for (const Ipv4Prefix & prefix : removedPrefixes) {
+                policy.aggregate.Remove (prefix, addedEntries, removedEntries);
+            }
 
-                // Find next-hop prefixes that are not allowed anymore.
-                for (const Ipv4Prefix & prefix : enabledPrefixesPrev) {
-                    if (enabledNexthops.find (prefix) == enabledNexthops.end()) {
-                        removedPrefixes.insert (prefix);
-                        enabledPrefixesPrev.erase (prefix);
-                    }
-                }
+            for (const Ipv4Prefix & prefix : addedPrefixes) {
+                policy.aggregate.Add (prefix, addedEntries, removedEntries);
+            }
 
-                enabledPrefixesPrev.insert (addedPrefixes.begin(), addedPrefixes.end());
-            } else {
-                // v is a new peer, so all the nexthops n such (n, u, v) satisfies the iBGP2
-                // createrion must be enabled.
-                addedPrefixes = enabledNexthops;
-                this->m_mapFiltersPrev[rid_v] = enabledNexthops;
+            if (isNewPolicy || !addedEntries.empty() || !removedEntries.empty()) {
+                this->BgpWritePolicy (os, filterId, addedEntries, removedEntries, isNewPolicy);
+                this->m_stats.numFilterEntriesAdded += addedEntries.size();
+                this->m_stats.numFilterEntriesRemoved += removedEntries.size();
+                isAltered = true;
+            }
+        }
+
+        if (filterId != filterIdPrev) {
+            this->m_mapFilterId[rid_v] = filterId;
+            ++policy.numNeighbors;
+            this->BgpWriteIbgp2Peer (os, rid_v, filterId, filterIdPrev == 0);
+            isAltered = true;
+
+            // The previous policy of v is removed once unused.
+            if (filterIdPrev && --this->m_policies[filterIdPrev].numNeighbors == 0) {
+                const Policy & policyPrev = this->m_policies[filterIdPrev];
+                this->m_stats.numFilterEntriesRemoved += this->m_communityTags ?
+                    policyPrev.filter.count() :
+                    policyPrev.aggregate.GetNumEntries();
+                this->BgpWriteRemovePolicy (os, filterIdPrev);
+                this->m_policies.erase (filterIdPrev);
             }
         }
 
-        if (!addedPrefixes.empty() || !removedPrefixes.empty()) {
-            const Ipv4Address & ip_v  = this->m_ospfGraphHelper->GetInterface (rid_v, rid_u);
+        if (isAltered) {
+            const Ipv4Address & ip_v  = this->m_mapInterfaces[rid_v];
             alteredNeighbors.insert (ip_v);
-            this->BgpWriteIbgp2Peer (os, rid_v, addedPrefixes, removedPrefixes);
         }
     } // for each neighbor
 
+    // Release the nexthop networks no more permitted by any policy, so that
+    // m_prefixIndex, and thus the bitsets, only grow with the filters. The
+    // other filters are either empty or equal to the filter of a policy.
+    if (!alteredNeighbors.empty()) {
+        Ipv4PrefixBitset usedBits (numPrefixes);
+        for (auto & p : this->m_policies) {
+            Ipv4PrefixIndex::Union (usedBits, p.second.filter);
+        }
+        this->m_prefixIndex.Prune (usedBits);
+    }
+
     return alteredNeighbors.size();
 }
 
+void Ibgp2d::SetBgpConfigChannel (BgpConfigChannel * channel) {
+    NS_LOG_FUNCTION (this << channel);
+    this->BgpdDisconnect();
+    delete this->m_bgpConfigChannel;
+    this->m_bgpConfigChannel = channel;
+}
+
+BgpConfigChannel * Ibgp2d::GetBgpConfigChannel () const {
+    NS_LOG_FUNCTION (this);
+    return this->m_bgpConfigChannel;
+}
+
 void Ibgp2d::BgpdConnect() {
     NS_LOG_FUNCTION (this);
-    Ptr<Node> node = this->GetNode();
 
     // Connect iBGP2 to BGPd (if not yet connected)
-    if (!this->m_telnetBgp) {
-
-        Ptr<BgpConfig> bgpConfig = node->GetObject<BgpConfig>();
-        NS_ASSERT (bgpConfig);
-        this->m_telnetBgp = new Telnet (
-            node,
-            Ipv4Address (LOCALHOST),
-            bgpConfig->GetVtyPort(),
-            bgpConfig->GetHostname() + "_ibgpv2_bgp.txt",
-            Seconds (0)
-        );
-
-        // Connection (mode normal)
-        const std::string & password = bgpConfig->GetPassword();
-
-        if (password.size()) {
-            this->m_telnetBgp->AppendCommand (password);
+    if (!this->m_isBgpdConnected) {
+        if (!this->m_bgpConfigChannel) {
+            this->m_bgpConfigChannel = new VtyBgpConfigChannel (this->m_vtyKeepAlive);
         }
 
-        // bgpd>
+        this->m_bgpConfigChannel->SetCommandCallback (MakeCallback (&Ibgp2d::HandleBgpCommand, this));
+        this->m_bgpConfigChannel->Open (this->GetNode());
+        this->m_isBgpdConnected = true;
 
-        const std::string & passwordEnable = bgpConfig->GetPasswordEnable();
-        this->m_telnetBgp->AppendCommand ("enable");
-
-        if (passwordEnable.size()) {
-            this->m_telnetBgp->AppendCommand (passwordEnable);
-        }
-
-        // bgpd#
+        // bgpd(config)#
+    }
+}
 
-        this->m_telnetBgp->AppendCommand ("configure terminal");
+void Ibgp2d::HandleBgpCommand(const VtyCommand & command) {
+    NS_LOG_LOGIC ("[" << command.line << "] acknowledged by bgpd in " << command.GetLatency().GetSeconds() << "s");
 
-        // bgpd(config)#
+    if (command.isError) {
+        NS_LOG_WARN ("bgpd rejected [" << command.line << "]: " << command.output);
+        ++this->m_stats.numBgpCommandsFailed;
+        this->m_bgpCommandFailedTrace (command.line, command.output);
     }
 }
 
+void Ibgp2d::CountBgpCommands(const std::string & commands) {
+    uint32_t numCommands = std::count (commands.begin(), commands.end(), '\n');
+    this->m_stats.numBgpCommands += numCommands;
+    this->m_bgpCommandsSentTrace (numCommands);
+}
+
 void Ibgp2d::BgpdDisconnect() {
     NS_LOG_FUNCTION (this);
 
-    if (this->m_telnetBgp) {
-        this->m_telnetBgp->Close();
-        delete this->m_telnetBgp;
-        this->m_telnetBgp = 0;
+    if (this->m_isBgpdConnected) {
+        this->m_bgpConfigChannel->Close();
+        this->m_isBgpdConnected = false;
     }
 }
 
@@ -588,62 +1370,183 @@ void Ibgp2d::BgpWriteBegin (std::ostream & os) const {
     // bgpd(config-router)#
 }
 
-void Ibgp2d::BgpWriteIbgp2Peer (
+void Ibgp2d::BgpWriteCommunityTagging (std::ostream & os) {
+    NS_LOG_FUNCTION (this);
+
+    Ptr<BgpConfig> bgpConfig = this->GetNode()->GetObject<BgpConfig>();
+    NS_ASSERT (bgpConfig);
+    std::set<Ipv4Address> externalNeighbors;
+    bgpConfig->GetExternalNeighbors (externalNeighbors);
+    this->m_isTagging = true;
+
+    // Only the ASBRs tag their routes.
+    if (externalNeighbors.empty()) return;
+
+    // bgpd(config)#
+    os << "route-map " << IBGP2_TAG_ROUTE_MAP << " permit 1" << std::endl;
+
+    // bgpd(config-route-map)#
+    os << "set community " << Ibgp2d::MakeCommunity (this->GetRouterId()) << " additive" << std::endl
+       << "exit" << std::endl;
+
+    // bgpd(config)#
+    this->BgpWriteBegin (os);
+
+    // bgpd(config-router)#
+    for (const Ipv4Address & ip_e : externalNeighbors) {
+        os << "neighbor " << ip_e << " route-map " << IBGP2_TAG_ROUTE_MAP << " in" << std::endl;
+    }
+
+    os << "exit" << std::endl;
+
+    // bgpd(config)#
+}
+
+void Ibgp2d::BgpWritePolicy (
     std::ostream & os,
-    const Ipv4Address & rid_v,
+    FilterId filterId,
     const std::set<Ipv4Prefix> & nexthopPrefixesEnabled,
-    const std::set<Ipv4Prefix> & nexthopPrefixesDisabled
+    const std::set<Ipv4Prefix> & nexthopPrefixesDisabled,
+    bool isNewPolicy
 ) {
-    NS_LOG_FUNCTION (this << rid_v);
-    // bgpd(config)#
-    const Ipv4Address & rid_u = this->GetRouterId();
-    const Ipv4Address & ip_v  = this->m_ospfGraphHelper->GetInterface (rid_v, rid_u);
+    NS_LOG_FUNCTION (this << filterId);
+    NS_ASSERT (filterId > 0);
 
-    // Get the filter-id corresponding to v. Create it if it does not yet exist.
-    FilterId filterId_v = this->GetFilterId (rid_v);
-    bool isNewNeighbor = (filterId_v == 0);
+    std::string routeMap = Ibgp2d::MakeRouteMapName (filterId);
 
-    // If v has no filter-id, then v is a new iBGP2 peer.
-    if (isNewNeighbor) {
-        filterId_v = this->AssignFilterId (rid_v);
+    if (this->m_communityTags) {
+        // One community-list entry per enabled ASBR.
+        std::string communityList = Ibgp2d::MakeCommunityListName (filterId);
+
+        // bgpd(config)#
+        for (auto & prefix_n : nexthopPrefixesEnabled) {
+            os << "ip community-list standard " << communityList << " permit "
+               << Ibgp2d::MakeCommunity (prefix_n.GetAddress()) << std::endl;
+        }
+
+        for (auto & prefix_n : nexthopPrefixesDisabled) {
+            os << "no ip community-list standard " << communityList << " permit "
+               << Ibgp2d::MakeCommunity (prefix_n.GetAddress()) << std::endl;
+        }
+
+        if (isNewPolicy) {
+            // bgpd(config)#
+            os << "route-map " << routeMap << " permit 1" << std::endl;
+
+            // bgpd(config-route-map)#
+            os << "match community " << communityList << std::endl
+               << "exit"                             << std::endl;
+
+            // bgpd(config)#
+        }
+        return;
     }
 
-    std::string routeMap_v = Ibgp2d::MakeRouteMapName (filterId_v);
-    std::string acl_v =  Ibgp2d::MakeRouteMapName (filterId_v);
+    std::string prefixList = Ibgp2d::MakePrefixListName (filterId);
 
-    // Declare the new neighbor and the corresponding route_map
-    if (isNewNeighbor) {
-        // bgpd(config)#
-        this->BgpWriteBegin (os);
+    // Create/update the prefix-list. Each prefix has the same sequence
+    // number in every prefix-list, so that bgpd inserts or deletes an
+    // entry at a known position instead of appending it. The entries are
+    // disjoint, so their order does not matter. The new entries are
+    // inserted first: when siblings are merged (or split), the nexthops
+    // they cover stay permitted in the meantime.
+    // bgpd(config)#
+    for (auto & prefix_n : nexthopPrefixesEnabled) {
+        uint32_t seq = this->AcquirePrefixListSeq (prefix_n);
+        os << "ip prefix-list " << prefixList << MakeNexthopPrefixListElement (prefix_n, seq) << std::endl;
+    }
 
-        // bgpd(config-router)#
-        os << "neighbor "  << ip_v << " remote-as " << this->GetAsn()       << std::endl
-           << "neighbor "  << ip_v << " route-reflector-client"             << std::endl
-           << "neighbor "  << ip_v << " route-map " << routeMap_v << " out" << std::endl
-           << "route-map " << routeMap_v << " permit 1"                     << std::endl;
+    for (auto & prefix_n : nexthopPrefixesDisabled) {
+        uint32_t seq = this->ReleasePrefixListSeq (prefix_n);
+        os << "no ip prefix-list " << prefixList << MakeNexthopPrefixListElement (prefix_n, seq) << std::endl;
+    }
+
+    // Do not add the last rule "ip prefix-list PREFIX-LIST-xxx deny any"
+    // which is implicit.
+
+    // Declare the corresponding route-map
+    if (isNewPolicy) {
+        // bgpd(config)#
+        os << "route-map " << routeMap << " permit 1" << std::endl;
 
         // bgpd(config-route-map)#
-        os << "match ip next-hop " << acl_v << std::endl
-           << "exit"                        << std::endl;
+        os << "match ip next-hop prefix-list " << prefixList << std::endl
+           << "exit"                                      << std::endl;
 
         // bgpd(config)#
     }
+}
 
-    NS_ASSERT (filterId_v > 0);
+void Ibgp2d::BgpWriteRemovePolicy (std::ostream & os, FilterId filterId) {
+    NS_LOG_FUNCTION (this << filterId);
 
-    // Create/update the access-list acl_v
     // bgpd(config)#
-    for (auto & prefix_n : nexthopPrefixesDisabled) {
-        os << "no access-list " << acl_v << " permit " << prefix_n << std::endl;
+    os << "no route-map " << Ibgp2d::MakeRouteMapName (filterId) << std::endl;
+
+    if (this->m_communityTags) {
+        os << "no ip community-list standard " << Ibgp2d::MakeCommunityListName (filterId) << std::endl;
+    } else {
+        os << "no ip prefix-list " << Ibgp2d::MakePrefixListName (filterId) << std::endl;
+
+        // The entries are removed with the prefix-list.
+        std::set<Ipv4Prefix> entries;
+        this->m_policies[filterId].aggregate.GetEntries (entries);
+        for (const Ipv4Prefix & prefix_n : entries) {
+            this->ReleasePrefixListSeq (prefix_n);
+        }
     }
+}
 
-    for (auto & prefix_n : nexthopPrefixesEnabled) {
-        os << "access-list " << acl_v << " permit " << prefix_n << std::endl;
+uint32_t Ibgp2d::AcquirePrefixListSeq (const Ipv4Prefix & prefix) {
+    NS_LOG_FUNCTION (this << prefix);
+    uint32_t i = this->m_prefixListSeqs.Insert (prefix);
+    if (i >= this->m_prefixListRefs.size()) {
+        this->m_prefixListRefs.resize (this->m_prefixListSeqs.GetSize(), 0);
     }
+    ++this->m_prefixListRefs[i];
+    return i + 1;
+}
 
-    // Do not add the last rule "access-list ACL-xxx deny any" which is
-    // implicit and can be triggered before "access-list ACL-xxx permit ..."
-    // rules inserted later.
+uint32_t Ibgp2d::ReleasePrefixListSeq (const Ipv4Prefix & prefix) {
+    NS_LOG_FUNCTION (this << prefix);
+    uint32_t i = this->m_prefixListSeqs.Insert (prefix);
+    NS_ASSERT (i < this->m_prefixListRefs.size() && this->m_prefixListRefs[i] > 0);
+
+    // The sequence number may then be reused by another entry.
+    if (--this->m_prefixListRefs[i] == 0) {
+        this->m_prefixListSeqs.Remove (prefix);
+    }
+    return i + 1;
+}
+
+void Ibgp2d::BgpWriteIbgp2Peer (
+    std::ostream & os,
+    const Ipv4Address & rid_v,
+    FilterId filterId,
+    bool isNewNeighbor
+) {
+    NS_LOG_FUNCTION (this << rid_v << filterId);
+    const Ipv4Address & ip_v  = this->m_mapInterfaces[rid_v];
+
+    // bgpd(config)#
+    this->BgpWriteBegin (os);
+
+    // bgpd(config-router)#
+    if (isNewNeighbor) {
+        os << "neighbor " << ip_v << " remote-as " << this->GetAsn() << std::endl
+           << "neighbor " << ip_v << " route-reflector-client"       << std::endl;
+
+        // The tags of the ASBRs must be propagated to v.
+        if (this->m_communityTags) {
+            os << "neighbor " << ip_v << " send-community" << std::endl;
+        }
+    }
+
+    // Binding another route-map replaces the previous one.
+    os << "neighbor " << ip_v << " route-map " << Ibgp2d::MakeRouteMapName (filterId) << " out" << std::endl
+       << "exit" << std::endl;
+
+    // bgpd(config)#
 }
 
 //----------------------------------------------------------------------------
@@ -656,23 +1559,49 @@ Ibgp2d::FilterId Ibgp2d::GetFilterId (const Ipv4Address & rid_v) const {
     return (fit != this->m_mapFilterId.end()) ? fit->second : 0;
 }
 
-const Ibgp2d::FilterId & Ibgp2d::AssignFilterId (const Ipv4Address & rid_v) {
-    NS_LOG_FUNCTION (this << rid_v);
-    FilterId acl_v = ++this->m_lastFilterId;
-    return (this->m_mapFilterId[rid_v] = acl_v);
+Ibgp2d::FilterId Ibgp2d::FindPolicy (const Ipv4PrefixBitset & filter) const {
+    NS_LOG_FUNCTION (this);
+    for (const auto & p : this->m_policies) {
+        if (p.second.filter == filter) return p.first;
+    }
+    return 0;
+}
+
+Ibgp2d::FilterId Ibgp2d::CreatePolicy () {
+    NS_LOG_FUNCTION (this);
+    FilterId filterId = ++this->m_lastFilterId;
+    Policy & policy = this->m_policies[filterId];
+    policy.filter.resize (this->m_prefixIndex.GetSize());
+    policy.numNeighbors = 0;
+    return filterId;
 }
 
-std::string Ibgp2d::MakeAccessListName (const Ibgp2d::FilterId & filterId) {
+std::string Ibgp2d::MakePrefixListName (const Ibgp2d::FilterId & filterId) {
     NS_LOG_FUNCTION (filterId);   // static
     std::ostringstream oss;
-    oss << IBGP2_ROUTE_MAP_PREFIX << filterId;
+    oss << IBGP2_PREFIX_LIST_PREFIX << filterId;
+    return oss.str();
+}
+
+std::string Ibgp2d::MakeCommunityListName (const Ibgp2d::FilterId & filterId) {
+    NS_LOG_FUNCTION (filterId);   // static
+    std::ostringstream oss;
+    oss << IBGP2_COMMUNITY_LIST_PREFIX << filterId;
+    return oss.str();
+}
+
+std::string Ibgp2d::MakeCommunity (const rid_t & rid_n) {
+    NS_LOG_FUNCTION (rid_n);   // static
+    std::ostringstream oss;
+    uint32_t value = rid_n.Get();
+    oss << (value >> 16) << ':' << (value & 0xffff);
     return oss.str();
 }
 
 std::string Ibgp2d::MakeRouteMapName (const Ibgp2d::FilterId & filterId) {
     NS_LOG_FUNCTION (filterId);   // static
     std::ostringstream oss;
-    oss << IBGP2_ACCESS_LIST_PREFIX << filterId;
+    oss << IBGP2_ROUTE_MAP_PREFIX << filterId;
     return oss.str();
 }
 
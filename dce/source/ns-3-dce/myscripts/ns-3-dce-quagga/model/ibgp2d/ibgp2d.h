@@ -25,23 +25,40 @@
 
 #define IBGP2_DUMMY_NID           "0.0.0.0"
 #define IBGP2_ROUTE_MAP_PREFIX    "ROUTE-MAP-"
-#define IBGP2_ACCESS_LIST_PREFIX  "ACCESS-LIST-"
+#define IBGP2_PREFIX_LIST_PREFIX  "PREFIX-LIST-"
+#define IBGP2_COMMUNITY_LIST_PREFIX "COMMUNITY-LIST-"
+#define IBGP2_TAG_ROUTE_MAP       "IBGP2-TAG"
 
+#include <chrono>                   // std::chrono::steady_clock
 #include <map>                      // std::map
+#include <string>                   // std::string
 #include <vector>                   // std::vector
 
 #include "ns3/application.h"        // ns3::Application
+#include "ns3/event-id.h"           // ns3::EventId
 #include "ns3/ipv4-address.h"       // ns3::Ipv4Address
+#include "ns3/nstime.h"             // ns3::Time
 #include "ns3/packet.h"             // ns3::Packet
 #include "ns3/ptr.h"                // ns3::Ptr
 #include "ns3/socket.h"             // ns3::Socket
+#include "ns3/traced-callback.h"    // ns3::TracedCallback
 
+#include "bgp-config-channel.h"             // ns3::BgpConfigChannel
+#include "ibgp2d-stats.h"                   // ns3::Ibgp2dStats
 #include "../helper/ospf-graph-helper.h"    // ns3::OspfGraphHelper
 #include "../ipv4-prefix.h"                 // ns3::Ipv4Prefix
-#include "../telnet-wrapper.h"              // ns3::Telnet
+#include "../ipv4-prefix-aggregate.h"       // ns3::Ipv4PrefixAggregate
+#include "../ipv4-prefix-index.h"           // ns3::Ipv4PrefixIndex, ns3::Ipv4PrefixBitset
+#include "../ospf-graph/ospf-change-set.h"  // ns3::ospf::OspfChangeSet
+#include "../ospf-graph/ospf-first-hop-cache.h" // ns3::ospf::OspfGraphSignature
+#include "../ospf-graph/ospf-lsa-view.h"    // ns3::ospf::OspfLsaView
+#include "../ospf-graph/ospf-spf.h"         // ns3::ospf::OspfCsrGraph, ns3::ospf::OspfSpf
+#include "../worker-pool.h"                 // ns3::WorkerPool
 
 namespace ns3 {
 
+class Ibgp2dBatch;
+
 /**
  * \ingroup applications
  * \brief iBGP2 daemon.
@@ -65,6 +82,19 @@ namespace ns3 {
  * If the OSPF graph topology changes, iBGP2 updates consequently the
  * iBGP filters configured on u.
  *
+ * The OSPF graph is maintained per OSPF area: u only knows the topology
+ * of the areas it belongs to, and the ASBRs of the other areas are
+ * reached through the area border routers announcing them (ASBR Summary
+ * LSAs). The criterion is evaluated for each neighbor v in the area
+ * shared by u and v, so the size of the graphs and the cost of the SPFs
+ * are bounded by the size of the areas.
+ *
+ * By default, the filters match the nexthops of the BGP routes, so they
+ * enumerate the external networks of each enabled ASBR. In community mode
+ * (see the CommunityTags attribute), each ASBR tags the routes learned
+ * from its eBGP neighbors with a community encoding its router-id, and
+ * the filters only enumerate the enabled ASBRs.
+ *
  * WARNING:
  * - This implementation assumes that the underlying bgp daemon the one
  *   provided by quagga.
@@ -74,11 +104,15 @@ namespace ns3 {
  *   OSPF/iBGP2 neighbors.
  * - If the router-id of a neighbor v changes, some obsolete filters
  *   may be kept in memory (and in the bgpd configuration).
+ * - In community mode, the inbound route-map of the eBGP neighbors is
+ *   replaced by the one tagging the routes.
  */
 
 class Ibgp2d :
     public Application
 {
+    friend class Ibgp2dBatch;
+    friend class Ibgp2dTestCase;
 public:
     typedef uint32_t FilterId;
 private:
@@ -94,36 +128,161 @@ private:
     typedef Ipv4Address rid_t;  /**< OSPF router-id (identifies a router in the OSPF graph). */
     typedef Ipv4Address nid_t;  /**< OSPF network link-id (identifies a network in the OSPF graph). */
 
-    typedef std::map<rid_t, std::set<Ipv4Prefix> >    MapFilters;
+    typedef std::map<rid_t, Ipv4PrefixBitset>         MapFilters;
     typedef std::map<rid_t, FilterId>                 MapFilterId;
+    typedef ospf::OspfCsrGraph::vertex_t              vertex_t;
+
+    /**
+     * @brief Shortest path tree rooted in an IGP neighbor. The tree is not
+     *   repaired while its first hops are found in the OspfFirstHopCache,
+     *   so the IGP changes it does not reflect yet are stored with it.
+     */
+
+    struct NeighborTree {
+        ospf::OspfSpf           spf;        /**< The shortest path tree. */
+        ospf::OspfChangeSet     changes;    /**< IGP changes not yet reflected in spf. */
+    };
+
+    typedef std::map<rid_t, NeighborTree>             MapSpts;
+    typedef std::map<rid_t, Ipv4Address>              MapInterfaces;
+
+    /**
+     * @brief State related to an OSPF area this router belongs to.
+     */
+
+    struct Area {
+        Ptr<OspfGraphHelper>    ospfGraphHelper;    /**< IGP graph of the area. */
+        ospf::OspfCsrGraph      csrGraph;           /**< Snapshot of the IGP graph used to run the SPFs. */
+        uint32_t                csrVersion;         /**< Version of the IGP graph corresponding to csrGraph. */
+        std::vector<vertex_t>   asbrs;              /**< Vertices of csrGraph connected to external networks. */
+        ospf::OspfGraphSignature signature;         /**< Signature of csrGraph and asbrs. */
+        MapSpts                 spts;               /**< Shortest path tree rooted in each IGP neighbor of the area. */
+        MapSpts                 sptsNext;           /**< Trees of the current IGP neighbors during a recomputation. */
+        ospf::OspfChangeSet     changes;            /**< IGP changes not yet dispatched in spts. */
+        vertex_t                u;                  /**< Vertex of this router in csrGraph during a recomputation. */
+    };
+
+    typedef std::map<Ipv4Address, Area>               MapAreas;
+
+    /**
+     * @brief Shortest path computation related to an IGP neighbor v. It
+     *   only involves immutable data, so that the neighbors can be
+     *   processed concurrently.
+     */
+
+    struct NeighborSpf {
+        Area *                  area;       /**< The area shared by u and v. */
+        vertex_t                v;          /**< The IGP neighbor. */
+        NeighborTree *          tree;       /**< The shortest path tree rooted in v. */
+        const NeighborSpf *     producer;   /**< The computation of another router of the batch providing the first hops (if any). */
+        bool                    isCached;   /**< true iif the results below come from the OspfFirstHopCache. */
+        bool                    isRepaired; /**< true iif the tree is repaired instead of being computed. */
+        std::vector<ospf::OspfSpf::Arc> arcsChanged; /**< The arcs to repair. */
+        bool                    isChild;    /**< true iif u is a child of v in this tree. */
+        std::vector<rid_t>      asbrs;      /**< ASBRs n such that (n, u, v) satisfies the iBGP2 criterion. */
+        ospf::OspfFirstHopCache::FirstHops firstHops; /**< First hops from v, inserted in the cache and read by the other routers of the batch. */
+    };
+
+    /**
+     * @brief Outbound policy (a route-map matching a prefix-list) shared by
+     *   the iBGP2 neighbors having the same filter.
+     */
+
+    struct Policy {
+        Ipv4PrefixBitset        filter;         /**< Nexthop networks (or ASBRs in community mode) permitted. */
+        Ipv4PrefixAggregate     aggregate;      /**< Minimal covering set of filter (the prefix-list entries). */
+        std::size_t             numNeighbors;   /**< Number of neighbors bound to this policy. */
+    };
+
+    typedef std::map<FilterId, Policy>                MapPolicies;
 
     //-----------------------------------------------------------------
     // Members
     //-----------------------------------------------------------------
 
     // BGPd
-    Telnet *                m_telnetBgp;        /**< Telnet connection to the bgpd running on the Node. */
+    BgpConfigChannel *      m_bgpConfigChannel; /**< Channel to the bgpd running on the Node (owned). */
+    bool                    m_isBgpdConnected;  /**< true iif m_bgpConfigChannel is open. */
+    Time                    m_vtyKeepAlive;     /**< Idle time before a keepalive on the default channel. */
+    TracedCallback<const std::string &, const std::string &> m_bgpCommandFailedTrace; /**< Fired when bgpd rejects a command. */
     uint32_t                m_asn;              /**< AS number of the Node. */
 
     // OSPF
-    Ptr<OspfGraphHelper>    m_ospfGraphHelper;  /**< IGP graph helper. */
+    MapAreas                m_areas;            /**< State of each OSPF area this router belongs to (keyed by area ID). */
     rid_t                   m_routerId;         /**< OSPF router-id of the Node. */
+    std::vector<uint8_t>    m_buffer;           /**< Copy of the last LS-Update packet sniffed. */
+    std::map<std::string, uint32_t> m_linkHeaderSizes; /**< Size of the link-layer header of the packets sniffed on each device (keyed by trace context). */
+    std::vector<ospf::OspfLsaView> m_lsas;      /**< Views over the LSAs carried by m_buffer. */
+
+    // SPF
+    bool                    m_sharedCache;      /**< Share the first hops with the other routers. */
+    bool                    m_incrementalSpf;   /**< Repair m_spts instead of recomputing them. */
+    uint32_t                m_numThreads;       /**< Number of threads computing the trees (1: sequential). */
+    WorkerPool *            m_workerPool;       /**< Threads computing the trees (NULL if sequential). */
+
+    // Batch
+    bool                    m_batchMode;        /**< Defer the recomputations to the end of the timestamp (see Ibgp2dBatch). */
+    bool                    m_batchPending;     /**< true iif this instance is queued in the Ibgp2dBatch. */
+
+    // Community mode
+    bool                    m_communityTags;    /**< Filter the routes according to the community of their ASBR. */
+    bool                    m_isTagging;        /**< true iif the routes learned from the eBGP neighbors are tagged. */
+
+    // SPF throttling
+    Time                    m_spfInitialDelay;  /**< Delay before a recomputation following a quiet period. */
+    Time                    m_spfHoldTime;      /**< Initial hold time between two recomputations. */
+    Time                    m_spfMaxHoldTime;   /**< Maximal hold time between two recomputations. */
+    Time                    m_spfHold;          /**< Current hold time. */
+    Time                    m_spfLastRun;       /**< Time of the last recomputation. */
+    EventId                 m_spfEvent;         /**< Pending recomputation (if any). */
+
+    // Push rate limiting
+    Time                    m_flushInterval;    /**< Minimal time between two pushes in bgpd. */
+    Time                    m_lastFlush;        /**< Time of the last push. */
+    EventId                 m_flushEvent;       /**< Pending push (if any). */
+
+    // Refresh of the iBGP2 neighbors
+    Time                    m_fibInstallDelay;  /**< Time given to zebra to install the routes of an IGP change. */
+    Time                    m_lastIgpChange;    /**< Time of the last IGP change. */
+    EventId                 m_refreshEvent;     /**< Pending refresh (if any). */
+    std::set<Ipv4Address>   m_neighborsToRefresh; /**< iBGP2 neighbors whose filter has changed since the last refresh. */
+    std::vector<NeighborSpf> m_neighbors;       /**< Per-neighbor computations of the current (or last) recomputation. */
+    bool                    m_hasNeighbors;     /**< true iif m_neighbors reflects the current IGP topology. */
 
     // For each router, store a set of networks from which transmission of
     // BGP announcements is allowed. We identify routers by their IPv4 address
-    // (used by BGP), not their router ID.
+    // (used by BGP), not their router ID. The sets are bitsets over the
+    // networks indexed in m_prefixIndex.
 
-    MapFilters              m_mapFilters;        /**< BGP filters that will be installed by iBGP2. */
-    MapFilters              m_mapFiltersPrev;    /**< Filters previously installed, needed to make a diff. */
+    Ipv4PrefixIndex         m_prefixIndex;       /**< Dense index of the nexthop networks involved in the filters. */
+    MapFilters              m_mapFilters;        /**< BGP filters that will be installed by iBGP2 at the next push. */
+    MapPolicies             m_policies;          /**< Policies installed in bgpd, needed to make a diff. */
+    Ipv4PrefixIndex         m_prefixListSeqs;    /**< Sequence number (minus one) of each prefix-list entry, shared by the prefix-lists. */
+    std::vector<uint32_t>   m_prefixListRefs;    /**< Number of prefix-lists holding each entry (indexed like m_prefixListSeqs). */
+    std::set<Ipv4Prefix>    m_prefixes;          /**< Scratch set reused while building the filters. */
+    MapInterfaces           m_mapInterfaces;     /**< Address of each iBGP2 neighbor v (interface of v connected to u). */
 
-    // iBGP2 manages an access-list per IGP/iBGP2 neighbor, identified by an
-    // integer. This mapping and the last used identifier are stored.
+    // iBGP2 manages a policy per distinct filter, identified by an integer.
+    // The policy bound to each IGP/iBGP2 neighbor and the last used
+    // identifier are stored.
 
-    MapFilterId             m_mapFilterId;      /**< Mapping neighbor / access-list identifier. */
-    FilterId                m_lastFilterId;     /**< Last used access-list identifier. */
+    MapFilterId             m_mapFilterId;      /**< Mapping neighbor / policy identifier. */
+    FilterId                m_lastFilterId;     /**< Last used policy identifier. */
 
     bool                    m_bgpdWasRunning;
 
+    // Instrumentation
+    Ibgp2dStats             m_stats;            /**< Counters and histograms of this instance. */
+    Time                    m_spfTimeBinWidth;  /**< Width of the bins of m_stats.spfTime. */
+    Time                    m_pushDelayBinWidth; /**< Width of the bins of m_stats.pushDelay. */
+    bool                    m_hasPendingChange; /**< true iif an IGP change is not yet pushed in bgpd. */
+    Time                    m_firstPendingChange; /**< Time of the first IGP change not yet pushed in bgpd. */
+    std::chrono::steady_clock::time_point m_spfStart; /**< Wall-clock time at which the current recomputation started. */
+    TracedCallback<uint32_t, uint32_t> m_lsUpdateTrace; /**< Fired for each LS-Update (LSAs, LSAs altering the IGP graph). */
+    TracedCallback<uint32_t, Time> m_spfRunTrace; /**< Fired for each recomputation (IGP neighbors, wall-clock time). */
+    TracedCallback<uint32_t, uint32_t, Time> m_pushTrace; /**< Fired for each push (entries added, entries removed, delay since the IGP change). */
+    TracedCallback<uint32_t> m_bgpCommandsSentTrace; /**< Fired when commands are sent to bgpd (number of commands). */
+
     //-----------------------------------------------------------------
     // Application methods
     //-----------------------------------------------------------------
@@ -138,19 +297,55 @@ private:
     /**
      * @brief Sink to handle a packet.
      * Sink that receive packets. Used with the NetDevice "Sniffer" source.
+     * @param context Identifies the device which has sniffed the packet
+     *   (see m_linkHeaderSizes).
      * @param p The packet to handle.
      */
 
-    void HandlePacket (const Ptr<const Packet> p);
+    void HandlePacket (std::string context, const Ptr<const Packet> p);
+
+    /**
+     * @brief Retrieve the state related to an OSPF area, and create it
+     *   if this router was not known to belong to this area.
+     * @param areaId The area ID.
+     * @return The corresponding Area.
+     */
+
+    Area & GetArea (const Ipv4Address & areaId);
+
+    /**
+     * @brief Schedule the recomputation of the iBGP2 redistribution once
+     *   the IGP topology has changed. The recomputations are throttled
+     *   (see the SpfInitialDelay, SpfHoldTime and SpfMaxHoldTime
+     *   attributes), so that a burst of LSAs results in a single
+     *   recomputation and a single push in bgpd.
+     */
+
+    void ScheduleSpf();
+
+    /**
+     * @brief Recompute the iBGP2 redistribution (or queue this instance in
+     *   the Ibgp2dBatch in batch mode), and push the filters in bgpd.
+     */
+
+    void RunSpf();
+
+    /**
+     * @brief Push (if bgpd is running) the iBGP2 filters in bgpd.
+     * @param hasChanged Pass true if the IGP topology has changed since the
+     *   last call.
+     */
+
+    void UpdateBgpd (bool hasChanged);
 
     //-----------------------------------------------------------------
     // Filters
     //-----------------------------------------------------------------
 
     /**
-     * @brief Retrieve the filter id assigned to a given neighboring router.
-     *   This id is use to identify the corresponding route-map and the
-     *   corresponding filter.
+     * @brief Retrieve the filter id of the policy bound to a given
+     *   neighboring router. This id is use to identify the corresponding
+     *   route-map and the corresponding prefix-list.
      * @param rid_v The OSPF router-id of a neighbor of the router embedding
      *   this iBGP2d instance.
      * @returns The corresponding FilterId (>1), 0 otherwise.
@@ -159,14 +354,20 @@ private:
     Ibgp2d::FilterId GetFilterId(const rid_t & rid_v) const;
 
     /**
-     * @brief Assign a new filter identifier to a neighbor.This id is use
-     *   to identify the corresponding route-map and the corresponding filter
-     * @param rid_v The OSPF router-id of a neighbor of the router embedding
-     *   this iBGP2d instance.
-     * @return The filter identifier assigned to this neighbor.
+     * @brief Search the policy installing a given filter.
+     * @param filter The filter (resized to m_prefixIndex.GetSize()).
+     * @return The filter id of the policy, 0 if not found.
+     */
+
+    Ibgp2d::FilterId FindPolicy(const Ipv4PrefixBitset & filter) const;
+
+    /**
+     * @brief Create a new policy, whose filter is empty and which is not
+     *   bound to any neighbor.
+     * @return The filter id assigned to this policy.
      */
 
-    const Ibgp2d::FilterId & AssignFilterId(const rid_t & rid_v);
+    Ibgp2d::FilterId CreatePolicy();
 
     /**
      * @brief Compute for each neighbor v which external IGP networks contains
@@ -179,20 +380,158 @@ private:
 
     void UpdateIbgp2Redistribution();
 
+    /**
+     * @brief First step of UpdateIbgp2Redistribution: refresh the
+     *   snapshot of the IGP graph and prepare the computation related to
+     *   each IGP neighbor (m_neighbors).
+     * @param batch The batch processing this instance (if any). The trees
+     *   computed by the other routers of the batch over the same LSDB
+     *   content are then reused.
+     * @return false if there is nothing to compute: this router does not
+     *   belong to the IGP graph yet, or no arc has changed and the filters
+     *   have been directly updated from the ASBRs previously enabled for
+     *   each neighbor.
+     */
+
+    bool PrepareIbgp2Redistribution(Ibgp2dBatch * batch = NULL);
+
+    /**
+     * @brief Prepare the computation related to an IGP neighbor (see
+     *   PrepareIbgp2Redistribution). A neighbor already prepared (e.g.
+     *   sharing several networks with u) is ignored.
+     * @param area The area in which v is an IGP neighbor of u.
+     * @param v The vertex of the IGP neighbor.
+     * @param cache The cache of first hops (if enabled).
+     * @param batch The batch processing this instance (if any).
+     */
+
+    void PrepareNeighborSpf(
+        Area & area,
+        vertex_t v,
+        ospf::OspfFirstHopCache * cache,
+        Ibgp2dBatch * batch
+    );
+
+    /**
+     * @brief Second step of UpdateIbgp2Redistribution: run the computation
+     *   related to an IGP neighbor. Distinct neighbors (of this instance or
+     *   of other instances) may be processed concurrently.
+     * @param i The index of the neighbor in m_neighbors.
+     */
+
+    void ComputeIbgp2Redistribution(std::size_t i);
+
+    /**
+     * @brief Last step of UpdateIbgp2Redistribution: store the first hops
+     *   in the cache and deduce the filters of each IGP neighbor.
+     */
+
+    void FinishIbgp2Redistribution();
+
+    /**
+     * @brief Release the first hops computed by the last recomputation,
+     *   once the other routers of the batch have read them.
+     */
+
+    void ReleaseIbgp2Redistribution();
+
+    /**
+     * @brief Rebuild the filters of each IGP neighbor from the ASBRs enabled
+     *   for this neighbor (see m_neighbors) and their current prefixes.
+     */
+
+    void UpdateIbgp2Filters();
+
+    /**
+     * @brief Retrieve the vertices of the IGP graph of an area corresponding
+     *   to the ASBRs (including the ASBRs of the other areas announced by
+     *   the ABRs).
+     * @param area The area.
+     * @param asbrs The vector where the vertices are appended (sorted by
+     *   router-id).
+     */
+
+    void GetAsbrs(const Area & area, std::vector<vertex_t> & asbrs) const;
+
+    /**
+     * @brief Deduce from the first hops of an IGP neighbor v (computed by
+     *   another router) whether u is a child of v, and the ASBRs whose
+     *   routes must be redistributed by u to v.
+     * @param firstHops The first hops from v.
+     * @param neighbor The neighbor to update.
+     */
+
+    void ApplyFirstHops(
+        const ospf::OspfFirstHopCache::FirstHops & firstHops,
+        NeighborSpf & neighbor
+    ) const;
+
+    /**
+     * @brief Translate the arcs altered in a change set into arcs of
+     *   the snapshot of the IGP graph of an area.
+     * @param area The area.
+     * @param changes The change set.
+     * @param arcs The vector where the arcs are appended.
+     */
+
+    void GetArcsChanged(
+        const Area & area,
+        const ospf::OspfChangeSet & changes,
+        std::vector<ospf::OspfSpf::Arc> & arcs
+    ) const;
+
+    /**
+     * @brief Compute (or repair) the shortest path tree rooted in an IGP
+     *   neighbor v, and deduce the ASBRs whose routes must be redistributed
+     *   by u to v. This method may be run concurrently for distinct
+     *   neighbors, so it must not log nor alter the members of Ibgp2d.
+     * @param neighbor The neighbor to process.
+     */
+
+    void ComputeNeighborSpf(NeighborSpf & neighbor) const;
+
+    /**
+     * @brief Push the filters in bgpd, now or once the MinFlushInterval
+     *   elapsed since the last push.
+     *
+     * The filters to install (m_mapFilters) and the ones installed (see
+     * m_policies) form the pending delta of each neighbor: the filters
+     * recomputed meanwhile overwrite m_mapFilters, so a nexthop enabled
+     * then disabled before the push cancels out, and bgpd only receives
+     * the net change.
+     */
+
+    void ScheduleBgpConfiguration();
+
     /**
      * @brief Update filters installed on each iBGP2 session accordingly the
      *   iBGP2 diffusion criterion.
+     * @return true iif at least one iBGP2 neighbor has been altered.
      */
 
     bool UpdateBgpConfiguration ();
 
     /**
-     * @brief Perform a "clear ip bgp ... soft" over a set of neighbors.
+     * @brief Schedule the refresh of the iBGP2 neighbors whose filter has
+     *   changed. The refresh commands are queued behind the commands
+     *   updating the filters, so bgpd runs them once the filters are
+     *   installed. If FibInstallDelay is set, the refresh is also deferred
+     *   until zebra is expected to have installed the routes of the last
+     *   IGP change, to avoid forwarding a route whose IGP path is not yet
+     *   the optimal one. The neighbors altered meanwhile are merged.
      * @param neighborsAltered The set of iBGP2 neighbors that must be
      *   refreshed.
      */
 
-    void RefreshIbgp2Neighbors(std::set<Ipv4Address> & neighborsAltered);
+    void ScheduleRefresh(const std::set<Ipv4Address> & neighborsAltered);
+
+    /**
+     * @brief Perform a "clear ip bgp ... soft out" over the neighbors whose
+     *   filter has changed (see m_neighborsToRefresh). Only the outbound
+     *   policies change, so the inbound routes are not requested again.
+     */
+
+    void RefreshIbgp2Neighbors();
 
     /**
      * @brief Write in an output stream the quagga commands that must be issued
@@ -216,12 +555,29 @@ private:
     static std::string MakeRouteMapName(const FilterId & filterId);
 
     /**
-     * @brief Build a access-list identifier.
-     * @param filterId The filter identifier which will uses the access-list.
-     * @return The corresponding access-list name (used in bgpd configuration file).
+     * @brief Build a prefix-list identifier.
+     * @param filterId The filter identifier which will uses the prefix-list.
+     * @return The corresponding prefix-list name (used in bgpd configuration file).
      */
 
-    static std::string MakeAccessListName(const FilterId & filterId);
+    static std::string MakePrefixListName(const FilterId & filterId);
+
+    /**
+     * @brief Build a community-list identifier.
+     * @param filterId The filter identifier which will uses the community-list.
+     * @return The corresponding community-list name (used in bgpd configuration file).
+     */
+
+    static std::string MakeCommunityListName(const FilterId & filterId);
+
+    /**
+     * @brief Build the community tagging the routes of an ASBR.
+     * @param rid_n The router-id of the ASBR.
+     * @return The community AA:NN, where AA (resp. NN) are the 16 high
+     *   (resp. low) bits of rid_n.
+     */
+
+    static std::string MakeCommunity(const rid_t & rid_n);
 
 public:
 
@@ -281,11 +637,52 @@ public:
     const rid_t& GetRouterId() const;
 
     /**
-     * @brief Accessor to the OSPF graph managed by this IBgpController.
-     * @returns The corresponding pointer.
+     * @brief Accessor to the OSPF graph of an area managed by this
+     *   IBgpController.
+     * @param areaId The area ID.
+     * @returns The corresponding pointer, NULL if this router does not
+     *   belong to this area.
+     */
+
+    const OspfGraphHelper * GetOspfGraphHelper(const Ipv4Address & areaId) const;
+
+    /**
+     * @brief Retrieve the OSPF areas this router belongs to.
+     * @param areaIds The vector where the area IDs are appended.
+     */
+
+    void GetAreaIds(std::vector<Ipv4Address> & areaIds) const;
+
+    /**
+     * @brief Retrieve the counters and histograms of this instance.
+     * @return The statistics gathered since the start (or the last call to
+     *   ClearStats()).
+     */
+
+    const Ibgp2dStats & GetStats() const;
+
+    /**
+     * @brief Reset the counters and histograms of this instance.
+     */
+
+    void ClearStats();
+
+    /**
+     * @brief Set the channel used to configure bgpd. It must be called
+     *   before the application starts, otherwise the VTY is used (see
+     *   VtyBgpConfigChannel).
+     * @param channel The channel, allocated with new. This Ibgp2d instance
+     *   takes its ownership.
      */
 
-    const OspfGraphHelper * GetOspfGraphHelper() const;
+    void SetBgpConfigChannel(BgpConfigChannel * channel);
+
+    /**
+     * @brief Retrieve the channel used to configure bgpd.
+     * @return The channel, NULL if not yet connected to bgpd.
+     */
+
+    BgpConfigChannel * GetBgpConfigChannel() const;
 
     /**
      * @brief Authenticate iBGP2d to BGPd.
@@ -293,6 +690,20 @@ public:
 
     void BgpdConnect();
 
+    /**
+     * @brief Function called back when bgpd acknowledges a command.
+     * @param command The command, its output and its latency.
+     */
+
+    void HandleBgpCommand(const VtyCommand & command);
+
+    /**
+     * @brief Account for commands about to be sent to bgpd.
+     * @param commands The commands (one per line).
+     */
+
+    void CountBgpCommands(const std::string & commands);
+
     /**
      * @brief Disconnect iBGP2 from BGPd.
      */
@@ -307,22 +718,78 @@ public:
 
     void BgpWriteBegin(std::ostream & os) const;
 
+    /**
+     * @brief Write in an output stream the quagga commands tagging the
+     *   routes learned from the eBGP neighbors of this router with its
+     *   community (see MakeCommunity).
+     * @param os The output stream.
+     */
+
+    void BgpWriteCommunityTagging(std::ostream & os);
+
+    /**
+     * @brief Write in an output stream the quagga commands to create or
+     *   update a policy.
+     * @param os The output stream.
+     * @param filterId The filter id of the policy.
+     * @param nexthopPrefixesEnabled The prefix-list entries to add (see
+     *   Ipv4PrefixAggregate), containing nexthops n such as (n, u, v) now
+     *   satisfies the iBGP2 criterion. In community mode, the /32 prefixes
+     *   of the ASBRs whose community must be permitted.
+     * @param nexthopPrefixesDisabled The prefix-list entries to remove.
+     * @param isNewPolicy Pass true to declare the route-map of the policy.
+     */
+
+    void BgpWritePolicy(
+        std::ostream & os,
+        FilterId filterId,
+        const std::set<Ipv4Prefix> & nexthopPrefixesEnabled,
+        const std::set<Ipv4Prefix> & nexthopPrefixesDisabled,
+        bool isNewPolicy
+    );
+
+    /**
+     * @brief Write in an output stream the quagga commands to remove a
+     *   policy no more bound to any neighbor.
+     * @param os The output stream.
+     * @param filterId The filter id of the policy.
+     */
+
+    void BgpWriteRemovePolicy(std::ostream & os, FilterId filterId);
+
+    /**
+     * @brief Retrieve the sequence number of a prefix-list entry, and
+     *   count one more prefix-list holding it.
+     * @param prefix The prefix of the entry.
+     * @return The sequence number of the entry.
+     */
+
+    uint32_t AcquirePrefixListSeq(const Ipv4Prefix & prefix);
+
+    /**
+     * @brief Retrieve the sequence number of a prefix-list entry, and
+     *   count one less prefix-list holding it. The sequence number is
+     *   released once no prefix-list holds the entry anymore.
+     * @param prefix The prefix of the entry.
+     * @return The sequence number of the entry.
+     */
+
+    uint32_t ReleasePrefixListSeq(const Ipv4Prefix & prefix);
+
     /**
      * @brief Write in an output stream the quagga commands to configure
-     *   an iBGP2 peer.
+     *   an iBGP2 peer and bind it to a policy.
      * @param os The output stream.
      * @param rid_v The router-id of the neighboring router v.
-     * @param nexthopPrefixesEnabled The prefixes containing the nexthops n
-     *   such as (n, u, v) now/still satisfies the iBGP2 criterion.
-     * @param nexthopPrefixesDisabled The prefixes containing the nexthops n
-     *   such as (n, u, v) does not satisfy the iBGP2 criterion anymore.
+     * @param filterId The filter id of the policy.
+     * @param isNewNeighbor Pass true to declare v in bgpd.
      */
 
     void BgpWriteIbgp2Peer(
         std::ostream & os,
         const rid_t & rid_v,
-        const std::set<Ipv4Prefix> & nexthopPrefixesEnabled,
-        const std::set<Ipv4Prefix> & nexthopPrefixesDisabled
+        FilterId filterId,
+        bool isNewNeighbor
     );
 
 };
@@ -0,0 +1,182 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+#include "ns3/ipv4-prefix-aggregate.h"
+
+namespace ns3 {
+
+namespace {
+
+typedef uint64_t Key;
+
+inline uint8_t GetLength (Key key) {
+    return key & 0xff;
+}
+
+inline uint64_t GetAddress (Key key) {
+    return key >> 8;
+}
+
+inline uint64_t GetMask (uint8_t length) {
+    return length ? (0xffffffffULL << (32 - length)) & 0xffffffffULL : 0;
+}
+
+inline Key MakeKey (uint64_t address, uint8_t length) {
+    return ((address & GetMask (length)) << 8) | length;
+}
+
+inline Key MakeKey (const Ipv4Prefix & prefix) {
+    return MakeKey (prefix.GetAddress().Get(), prefix.GetPrefixLength());
+}
+
+inline Ipv4Prefix MakePrefix (Key key) {
+    return Ipv4Prefix (
+        Ipv4Address (uint32_t (GetAddress (key))),
+        Ipv4Mask (uint32_t (GetMask (GetLength (key))))
+    );
+}
+
+inline Key GetParent (Key key) {
+    return MakeKey (GetAddress (key), GetLength (key) - 1);
+}
+
+inline Key GetSibling (Key key) {
+    return MakeKey (GetAddress (key) ^ (1ULL << (32 - GetLength (key))), GetLength (key));
+}
+
+inline Key GetChild (Key key, bool high) {
+    uint8_t length = GetLength (key) + 1;
+    return MakeKey (GetAddress (key) | (high ? 1ULL << (32 - length) : 0), length);
+}
+
+/** The keys of the prefixes included in key are in [key, GetEnd (key)). */
+inline Key GetEnd (Key key) {
+    return (GetAddress (key) + (1ULL << (32 - GetLength (key)))) << 8;
+}
+
+} // anonymous namespace
+
+bool Ipv4PrefixAggregate::HasCoveredAncestor (Key key) const {
+    while (GetLength (key) > 0) {
+        key = GetParent (key);
+        if (this->m_covered.count (key)) return true;
+    }
+    return false;
+}
+
+void Ipv4PrefixAggregate::Report (Key key, std::set<Ipv4Prefix> & changes, std::set<Ipv4Prefix> & opposite) {
+    Ipv4Prefix prefix = MakePrefix (key);
+    if (!opposite.erase (prefix)) {
+        changes.insert (prefix);
+    }
+}
+
+bool Ipv4PrefixAggregate::Add (
+    const Ipv4Prefix & prefix,
+    std::set<Ipv4Prefix> & entriesAdded,
+    std::set<Ipv4Prefix> & entriesRemoved
+) {
+    Key key = MakeKey (prefix);
+    if (!this->m_prefixes.insert (key).second) return false;
+
+    // Already covered by both of its halves.
+    if (!this->m_covered.insert (key).second) return true;
+
+    // Merge the siblings up to the highest covered prefix.
+    Key top = key;
+    while (GetLength (top) > 0 && this->m_covered.count (GetSibling (top))) {
+        Key parent = GetParent (top);
+        if (!this->m_covered.insert (parent).second) break;
+        top = parent;
+    }
+
+    if (this->HasCoveredAncestor (top)) return true;
+
+    // top replaces the covering prefixes it includes.
+    std::set<Key>::iterator
+        it  (this->m_entries.lower_bound (top)),
+        end (this->m_entries.lower_bound (GetEnd (top)));
+    for (std::set<Key>::iterator jt = it; jt != end; ++jt) {
+        Report (*jt, entriesRemoved, entriesAdded);
+    }
+    this->m_entries.erase (it, end);
+
+    this->m_entries.insert (top);
+    Report (top, entriesAdded, entriesRemoved);
+    return true;
+}
+
+bool Ipv4PrefixAggregate::Remove (
+    const Ipv4Prefix & prefix,
+    std::set<Ipv4Prefix> & entriesAdded,
+    std::set<Ipv4Prefix> & entriesRemoved
+) {
+    Key key = MakeKey (prefix);
+    if (!this->m_prefixes.erase (key)) return false;
+
+    // Still covered by both of its halves.
+    if (GetLength (key) < 32
+    &&  this->m_covered.count (GetChild (key, false))
+    &&  this->m_covered.count (GetChild (key, true))) {
+        return true;
+    }
+
+    // The ancestors covered through key are not covered anymore.
+    this->m_covered.erase (key);
+    Key top = key;
+    while (GetLength (top) > 0) {
+        Key parent = GetParent (top);
+        if (!this->m_covered.count (parent) || this->m_prefixes.count (parent)) break;
+        this->m_covered.erase (parent);
+        top = parent;
+    }
+
+    if (!this->m_entries.erase (top)) return true;
+    Report (top, entriesRemoved, entriesAdded);
+
+    // top is replaced by the highest covered prefixes it includes.
+    Key end = GetEnd (top);
+    for (std::set<Key>::const_iterator it (this->m_covered.lower_bound (top));
+        it != this->m_covered.end() && *it < end;
+        it = this->m_covered.lower_bound (GetEnd (*it))
+    ) {
+        this->m_entries.insert (*it);
+        Report (*it, entriesAdded, entriesRemoved);
+    }
+
+    return true;
+}
+
+void Ipv4PrefixAggregate::GetEntries (std::set<Ipv4Prefix> & entries) const {
+    for (Key key : this->m_entries) {
+        entries.insert (MakePrefix (key));
+    }
+}
+
+std::size_t Ipv4PrefixAggregate::GetNumEntries () const {
+    return this->m_entries.size();
+}
+
+std::size_t Ipv4PrefixAggregate::GetNumPrefixes () const {
+    return this->m_prefixes.size();
+}
+
+} // namespace ns3
@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+#ifndef IPV4_PREFIX_AGGREGATE_H
+#define IPV4_PREFIX_AGGREGATE_H
+
+#include <cstddef>                      // std::size_t
+#include <cstdint>                      // uint*_t
+#include <set>                          // std::set
+
+#include "ns3/ipv4-prefix.h"            // ns3::Ipv4Prefix
+
+namespace ns3 {
+
+/**
+ * @class Ipv4PrefixAggregate
+ * @brief Maintains the minimal set of prefixes covering exactly the
+ *   addresses of a set of prefixes.
+ *
+ * A prefix is covered if it has been added, or if both of its halves are
+ * covered: two sibling prefixes are thus merged into their parent, and a
+ * prefix included in another one is dropped. The covering set is made of
+ * the covered prefixes whose no ancestor is covered.
+ *
+ * Adding or removing a prefix only revisits its ancestors and the
+ * covering prefixes it contains, and the resulting changes of the
+ * covering set are reported, so that an access-list can be updated
+ * incrementally. Adding 0.0.0.0/0 collapses the covering set into this
+ * single prefix, while the other prefixes are kept to restore it.
+ */
+
+class Ipv4PrefixAggregate
+{
+private:
+    typedef uint64_t Key;   /**< (network address << 8) | prefix length: sorted by address, then by length. */
+
+    std::set<Key>   m_prefixes; /**< Prefixes added (and not removed). */
+    std::set<Key>   m_covered;  /**< Prefixes added, or whose both halves are covered. */
+    std::set<Key>   m_entries;  /**< Covered prefixes having no covered ancestor (covering set). */
+
+    /**
+     * @brief Test whether a prefix has a covered ancestor.
+     * @param key The prefix.
+     * @return true iif an ancestor of key belongs to m_covered.
+     */
+
+    bool HasCoveredAncestor (Key key) const;
+
+    /**
+     * @brief Record a change of the covering set, unless it cancels a
+     *   previous change.
+     * @param key The prefix.
+     * @param changes The set where the prefix is recorded.
+     * @param opposite The set where the opposite changes are recorded.
+     */
+
+    static void Report (Key key, std::set<Ipv4Prefix> & changes, std::set<Ipv4Prefix> & opposite);
+
+public:
+
+    /**
+     * @brief Add a prefix.
+     * @param prefix The prefix.
+     * @param entriesAdded The set where the prefixes entering the covering
+     *   set are inserted.
+     * @param entriesRemoved The set where the prefixes leaving the covering
+     *   set are inserted.
+     * @return true iif the prefix was not yet added.
+     */
+
+    bool Add (
+        const Ipv4Prefix & prefix,
+        std::set<Ipv4Prefix> & entriesAdded,
+        std::set<Ipv4Prefix> & entriesRemoved
+    );
+
+    /**
+     * @brief Remove a prefix.
+     * @param prefix The prefix.
+     * @param entriesAdded The set where the prefixes entering the covering
+     *   set are inserted.
+     * @param entriesRemoved The set where the prefixes leaving the covering
+     *   set are inserted.
+     * @return true iif the prefix was added.
+     */
+
+    bool Remove (
+        const Ipv4Prefix & prefix,
+        std::set<Ipv4Prefix> & entriesAdded,
+        std::set<Ipv4Prefix> & entriesRemoved
+    );
+
+    /**
+     * @brief Retrieve the covering set.
+     * @param entries The set where the covering prefixes are inserted.
+     */
+
+    void GetEntries (std::set<Ipv4Prefix> & entries) const;
+
+    /**
+     * @brief Retrieve the size of the covering set.
+     * @return The number of covering prefixes.
+     */
+
+    std::size_t GetNumEntries () const;
+
+    /**
+     * @brief Retrieve the number of prefixes added (and not removed).
+     * @return The number of prefixes.
+     */
+
+    std::size_t GetNumPrefixes () const;
+};
+
+} // namespace ns3
+
+#endif // IPV4_PREFIX_AGGREGATE_H
@@ -0,0 +1,96 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+#include "ns3/ipv4-prefix-index.h"
+
+namespace ns3 {
+
+uint32_t Ipv4PrefixIndex::Insert (const Ipv4Prefix & prefix) {
+    std::pair<std::map<Ipv4Prefix, uint32_t>::iterator, bool> ret =
+        this->m_indices.insert (std::make_pair (prefix, uint32_t (this->m_prefixes.size())));
+
+    if (ret.second) {
+        if (this->m_freeIndices.empty()) {
+            this->m_prefixes.push_back (prefix);
+        } else {
+            ret.first->second = this->m_freeIndices.back();
+            this->m_freeIndices.pop_back();
+            this->m_prefixes[ret.first->second] = prefix;
+        }
+    }
+
+    return ret.first->second;
+}
+
+void Ipv4PrefixIndex::Insert (const std::set<Ipv4Prefix> & prefixes, Ipv4PrefixBitset & bitset) {
+    for (const Ipv4Prefix & prefix : prefixes) {
+        uint32_t i = this->Insert (prefix);
+        if (i >= bitset.size()) {
+            bitset.resize (this->m_prefixes.size());
+        }
+        bitset.set (i);
+    }
+}
+
+const Ipv4Prefix & Ipv4PrefixIndex::Get (uint32_t i) const {
+    return this->m_prefixes[i];
+}
+
+void Ipv4PrefixIndex::Get (const Ipv4PrefixBitset & bitset, std::set<Ipv4Prefix> & prefixes) const {
+    for (Ipv4PrefixBitset::size_type i = bitset.find_first(); i != Ipv4PrefixBitset::npos; i = bitset.find_next (i)) {
+        prefixes.insert (this->m_prefixes[i]);
+    }
+}
+
+void Ipv4PrefixIndex::Remove (const Ipv4Prefix & prefix) {
+    std::map<Ipv4Prefix, uint32_t>::iterator it (this->m_indices.find (prefix));
+    if (it != this->m_indices.end()) {
+        this->m_freeIndices.push_back (it->second);
+        this->m_indices.erase (it);
+    }
+}
+
+void Ipv4PrefixIndex::Prune (const Ipv4PrefixBitset & used) {
+    for (std::map<Ipv4Prefix, uint32_t>::iterator it (this->m_indices.begin()); it != this->m_indices.end();) {
+        if (it->second < used.size() && used.test (it->second)) {
+            ++it;
+        } else {
+            this->m_freeIndices.push_back (it->second);
+            this->m_indices.erase (it++);
+        }
+    }
+}
+
+std::size_t Ipv4PrefixIndex::GetSize () const {
+    return this->m_prefixes.size();
+}
+
+void Ipv4PrefixIndex::Union (Ipv4PrefixBitset & bitset, Ipv4PrefixBitset & other) {
+    if (bitset.size() < other.size()) {
+        bitset.resize (other.size());
+    } else if (other.size() < bitset.size()) {
+        other.resize (bitset.size());
+    }
+
+    bitset |= other;
+}
+
+} // namespace ns3
@@ -0,0 +1,135 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+#ifndef IPV4_PREFIX_INDEX_H
+#define IPV4_PREFIX_INDEX_H
+
+#include <cstddef>                      // std::size_t
+#include <cstdint>                      // uint*_t
+#include <map>                          // std::map
+#include <set>                          // std::set
+#include <vector>                       // std::vector
+
+#include <boost/dynamic_bitset.hpp>     // boost::dynamic_bitset
+
+#include "ns3/ipv4-prefix.h"            // ns3::Ipv4Prefix
+
+namespace ns3 {
+
+/**
+ * @brief Set of Ipv4Prefix, where the bit i is set iif the prefix having
+ *   the index i in an Ipv4PrefixIndex belongs to the set. The sets built
+ *   over the same Ipv4PrefixIndex are compared and combined word by word.
+ */
+
+typedef boost::dynamic_bitset<uint64_t> Ipv4PrefixBitset;
+
+/**
+ * @class Ipv4PrefixIndex
+ * @brief Assigns a dense index to each Ipv4Prefix it has seen.
+ *
+ * An index is only reassigned once released (see Remove and Prune), i.e.
+ * once no bitset has its bit set anymore, so an Ipv4PrefixBitset remains
+ * valid as the index grows. It may then be shorter than GetSize(): the
+ * missing bits are unset. The released indices are reused first, so that
+ * GetSize() stays bounded by the number of prefixes in use at once.
+ */
+
+class Ipv4PrefixIndex
+{
+private:
+    std::map<Ipv4Prefix, uint32_t>  m_indices;  /**< Index of each prefix. */
+    std::vector<Ipv4Prefix>         m_prefixes; /**< Prefix of each index. */
+    std::vector<uint32_t>           m_freeIndices; /**< Released indices, reused by Insert. */
+
+public:
+
+    /**
+     * @brief Retrieve the index of a prefix, and assign it a new index if
+     *   needed.
+     * @param prefix An Ipv4Prefix.
+     * @return The index of the prefix.
+     */
+
+    uint32_t Insert (const Ipv4Prefix & prefix);
+
+    /**
+     * @brief Set in a bitset the bits of some prefixes, which are indexed
+     *   if needed. The bitset is extended to GetSize() bits.
+     * @param prefixes The prefixes.
+     * @param bitset The updated bitset.
+     */
+
+    void Insert (const std::set<Ipv4Prefix> & prefixes, Ipv4PrefixBitset & bitset);
+
+    /**
+     * @brief Retrieve the prefix corresponding to an index.
+     * @param i An index (lower than GetSize()).
+     * @return The corresponding prefix.
+     */
+
+    const Ipv4Prefix & Get (uint32_t i) const;
+
+    /**
+     * @brief Retrieve the prefixes whose bit is set in a bitset.
+     * @param bitset The bitset.
+     * @param prefixes The set where the prefixes are inserted.
+     */
+
+    void Get (const Ipv4PrefixBitset & bitset, std::set<Ipv4Prefix> & prefixes) const;
+
+    /**
+     * @brief Release the index of a prefix. The bit of this index must be
+     *   unset in every bitset.
+     * @param prefix An Ipv4Prefix (ignored if not indexed).
+     */
+
+    void Remove (const Ipv4Prefix & prefix);
+
+    /**
+     * @brief Release the index of every prefix whose bit is unset in a
+     *   bitset.
+     * @param used The union of the bitsets still in use.
+     */
+
+    void Prune (const Ipv4PrefixBitset & used);
+
+    /**
+     * @brief Retrieve the number of indices assigned so far, released or
+     *   not, i.e. the size of the bitsets.
+     * @return The number of indices.
+     */
+
+    std::size_t GetSize () const;
+
+    /**
+     * @brief Add the prefixes of a bitset to another one. The shortest
+     *   of them is first extended, so that they are combined word by word.
+     * @param bitset The updated bitset.
+     * @param other The added bitset.
+     */
+
+    static void Union (Ipv4PrefixBitset & bitset, Ipv4PrefixBitset & other);
+};
+
+} // namespace ns3
+
+#endif // IPV4_PREFIX_INDEX_H
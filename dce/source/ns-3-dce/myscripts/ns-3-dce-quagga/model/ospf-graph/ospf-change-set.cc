@@ -0,0 +1,145 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#include "ns3/ospf-change-set.h"
+
+namespace ns3 {
+namespace ospf {
+
+OspfChangeSet::OspfChangeSet() :
+    m_networksChanged (false),
+    m_numAlterations (0)
+{}
+
+void OspfChangeSet::AddArc (OspfChangeSet::vertex_t u, OspfChangeSet::vertex_t v) {
+    Arc arc (u, v);
+    ++this->m_numAlterations;
+
+    if (this->m_arcsRemoved.erase (arc)) {
+        // Removed then added back: the metric may differ.
+        this->m_metricsChanged.insert (arc);
+    } else {
+        this->m_arcsAdded.insert (arc);
+    }
+}
+
+void OspfChangeSet::RemoveArc (OspfChangeSet::vertex_t u, OspfChangeSet::vertex_t v) {
+    Arc arc (u, v);
+    ++this->m_numAlterations;
+    this->m_metricsChanged.erase (arc);
+
+    if (!this->m_arcsAdded.erase (arc)) {
+        // The arc was there before this change set.
+        this->m_arcsRemoved.insert (arc);
+    }
+}
+
+void OspfChangeSet::ChangeMetric (OspfChangeSet::vertex_t u, OspfChangeSet::vertex_t v) {
+    Arc arc (u, v);
+    ++this->m_numAlterations;
+
+    // An arc added in this change set is already reported with its new metric.
+    if (this->m_arcsAdded.find (arc) == this->m_arcsAdded.end()) {
+        this->m_metricsChanged.insert (arc);
+    }
+}
+
+void OspfChangeSet::ChangeExternals (const router_id_t & asbr) {
+    ++this->m_numAlterations;
+    this->m_externalsChanged.insert (asbr);
+}
+
+void OspfChangeSet::ChangeNetworks() {
+    ++this->m_numAlterations;
+    this->m_networksChanged = true;
+}
+
+void OspfChangeSet::Merge (const OspfChangeSet & o) {
+    for (const Arc & arc : o.m_arcsRemoved)    this->RemoveArc (arc.first, arc.second);
+    for (const Arc & arc : o.m_arcsAdded)      this->AddArc (arc.first, arc.second);
+    for (const Arc & arc : o.m_metricsChanged) this->ChangeMetric (arc.first, arc.second);
+    this->m_externalsChanged.insert (o.m_externalsChanged.begin(), o.m_externalsChanged.end());
+    this->m_networksChanged |= o.m_networksChanged;
+    this->m_numAlterations += o.m_externalsChanged.size() + o.m_networksChanged;
+}
+
+void OspfChangeSet::Clear() {
+    this->m_arcsAdded.clear();
+    this->m_arcsRemoved.clear();
+    this->m_metricsChanged.clear();
+    this->m_externalsChanged.clear();
+    this->m_networksChanged = false;
+    this->m_numAlterations = 0;
+}
+
+bool OspfChangeSet::IsEmpty() const {
+    return !this->HasTopologyChanged()
+        && this->m_externalsChanged.empty()
+        && !this->m_networksChanged;
+}
+
+bool OspfChangeSet::HasTopologyChanged() const {
+    return !this->m_arcsAdded.empty()
+        || !this->m_arcsRemoved.empty()
+        || !this->m_metricsChanged.empty();
+}
+
+const OspfChangeSet::Arcs & OspfChangeSet::GetArcsAdded() const {
+    return this->m_arcsAdded;
+}
+
+const OspfChangeSet::Arcs & OspfChangeSet::GetArcsRemoved() const {
+    return this->m_arcsRemoved;
+}
+
+const OspfChangeSet::Arcs & OspfChangeSet::GetMetricsChanged() const {
+    return this->m_metricsChanged;
+}
+
+const OspfChangeSet::Routers & OspfChangeSet::GetExternalsChanged() const {
+    return this->m_externalsChanged;
+}
+
+bool OspfChangeSet::HasNetworksChanged() const {
+    return this->m_networksChanged;
+}
+
+std::size_t OspfChangeSet::GetNumAlterations() const {
+    return this->m_numAlterations;
+}
+
+void OspfChangeSet::Print (std::ostream & os) const {
+    os << "OspfChangeSet(+" << this->m_arcsAdded.size()
+       << " -"         << this->m_arcsRemoved.size()
+       << " ~"         << this->m_metricsChanged.size()
+       << " externals: " << this->m_externalsChanged.size()
+       << " networks: "  << (this->m_networksChanged ? "yes" : "no")
+       << ')';
+}
+
+std::ostream & operator << (std::ostream & os, const OspfChangeSet & changes) {
+    changes.Print (os);
+    return os;
+}
+
+} // namespace ospf
+} // namespace ns3
@@ -0,0 +1,205 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#ifndef OSPF_CHANGE_SET_H
+#define OSPF_CHANGE_SET_H
+
+#include <cstddef>                          // std::size_t
+#include <ostream>                          // std::ostream
+#include <set>                              // std::set
+#include <utility>                          // std::pair
+
+#include "ns3/ospf-packet.h"                // ns3::ospf::router_id_t
+
+namespace ns3 {
+namespace ospf {
+
+/**
+ * @class OspfChangeSet
+ * @brief Describes how an OspfGraph has been altered by a batch of LSAs.
+ *
+ * Arcs are identified by the vertex descriptors of their source and target
+ * in the OspfGraph: since the vertices are never removed, they remain valid
+ * even once the arc has been removed, and they do not mix up a router and a
+ * network having the same identifier.
+ *
+ * The sets are kept normalized: an arc removed then added again is
+ * reported as a metric change, an arc added then removed is not reported
+ * at all.
+ */
+
+class OspfChangeSet
+{
+public:
+    typedef std::size_t                         vertex_t;   /**< Vertex descriptor of the OspfGraph. */
+    typedef std::pair<vertex_t, vertex_t>       Arc;        /**< (source, target) */
+    typedef std::set<Arc>                       Arcs;
+    typedef std::set<router_id_t>               Routers;
+
+private:
+    Arcs        m_arcsAdded;            /**< Arcs added in the OspfGraph. */
+    Arcs        m_arcsRemoved;          /**< Arcs removed from the OspfGraph. */
+    Arcs        m_metricsChanged;       /**< Arcs whose (lowest) metric has changed. */
+    Routers     m_externalsChanged;     /**< ASBRs whose external networks have changed. */
+    bool        m_networksChanged;      /**< True if the prefixes or interfaces of some transit networks have changed. */
+    std::size_t m_numAlterations;       /**< Number of alterations recorded since the last Clear(). */
+
+public:
+
+    /**
+     * @brief Constructor (empty change set).
+     */
+
+    OspfChangeSet();
+
+    /**
+     * @brief Record that an arc has been added.
+     * @param u The source of the arc.
+     * @param v The target of the arc.
+     */
+
+    void AddArc(vertex_t u, vertex_t v);
+
+    /**
+     * @brief Record that an arc has been removed.
+     * @param u The source of the arc.
+     * @param v The target of the arc.
+     */
+
+    void RemoveArc(vertex_t u, vertex_t v);
+
+    /**
+     * @brief Record that the metric of an arc has changed.
+     * @param u The source of the arc.
+     * @param v The target of the arc.
+     */
+
+    void ChangeMetric(vertex_t u, vertex_t v);
+
+    /**
+     * @brief Record that the external networks of an ASBR have changed.
+     * @param asbr The router-id of the ASBR.
+     */
+
+    void ChangeExternals(const router_id_t & asbr);
+
+    /**
+     * @brief Record that some transit networks (prefixes or interfaces)
+     *   have changed.
+     */
+
+    void ChangeNetworks();
+
+    /**
+     * @brief Append another change set to this one.
+     * @param o The change set that occurred after *this.
+     */
+
+    void Merge(const OspfChangeSet & o);
+
+    /**
+     * @brief Reset this change set.
+     */
+
+    void Clear();
+
+    /**
+     * @brief Test whether nothing has changed.
+     * @return true iif this change set is empty.
+     */
+
+    bool IsEmpty() const;
+
+    /**
+     * @brief Test whether the shortest paths may have changed.
+     * @return true iif at least one arc has been added, removed or
+     *   has seen its metric changed.
+     */
+
+    bool HasTopologyChanged() const;
+
+    /**
+     * @brief Accessor to the arcs added.
+     * @return The corresponding set of arcs.
+     */
+
+    const Arcs & GetArcsAdded() const;
+
+    /**
+     * @brief Accessor to the arcs removed.
+     * @return The corresponding set of arcs.
+     */
+
+    const Arcs & GetArcsRemoved() const;
+
+    /**
+     * @brief Accessor to the arcs whose metric has changed.
+     * @return The corresponding set of arcs.
+     */
+
+    const Arcs & GetMetricsChanged() const;
+
+    /**
+     * @brief Accessor to the ASBRs whose external networks have changed.
+     * @return The corresponding set of router-ids.
+     */
+
+    const Routers & GetExternalsChanged() const;
+
+    /**
+     * @brief Test whether some transit networks have changed.
+     * @return true iif some prefixes or interfaces of transit networks have
+     *   changed.
+     */
+
+    bool HasNetworksChanged() const;
+
+    /**
+     * @brief Retrieve the number of alterations recorded since the last
+     *   Clear(), even if they cancel each other out. Comparing this number
+     *   before and after an update tells whether it altered something.
+     * @return The number of alterations.
+     */
+
+    std::size_t GetNumAlterations() const;
+
+    /**
+     * @brief Print this OspfChangeSet in an output stream.
+     * @param os The output stream.
+     */
+
+    void Print(std::ostream & os) const;
+};
+
+/**
+ * @brief Print an OspfChangeSet in an output stream.
+ * @param os The output stream.
+ * @param changes An OspfChangeSet.
+ * @return The updated output stream.
+ */
+
+std::ostream & operator << (std::ostream & os, const OspfChangeSet & changes);
+
+} // namespace ospf
+} // namespace ns3
+
+#endif // OSPF_CHANGE_SET_H
@@ -0,0 +1,190 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+
+#include "ns3/ospf-first-hop-cache.h"
+
+#include <algorithm>                        // std::sort, std::lower_bound
+
+#include "ns3/log.h"                        // NS_LOG_*
+
+NS_LOG_COMPONENT_DEFINE ("OspfFirstHopCache");
+
+namespace ns3 {
+namespace ospf {
+
+//-----------------------------------------------------------------
+// OspfGraphSignature
+//-----------------------------------------------------------------
+
+OspfGraphSignature::OspfGraphSignature() :
+    m_numArcs (0),
+    m_hash (0)
+{}
+
+void OspfGraphSignature::Build (const OspfCsrGraph & g, const std::vector<OspfCsrGraph::vertex_t> & asbrs) {
+    typedef OspfCsrGraph::vertex_t vertex_t;
+    typedef OspfCsrGraph::arc_t    arc_t;
+
+    // Sort the arcs by (source, target) router-ids. The weight is not part
+    // of the sort key since there is at most one arc per pair of vertices.
+    // A router and a network may have the same identifier (e.g. the DR and
+    // its network), so the kind of both ends breaks the ties.
+    std::vector<std::pair<std::pair<uint64_t, uint32_t>, arc_t> > arcs;
+    arcs.reserve (g.GetNumArcs());
+
+    for (vertex_t u = 0; u < g.GetNumVertices(); ++u) {
+        uint64_t rid_u = g.GetRouterId (u).Get();
+        for (arc_t a = g.GetOutBegin (u), end = g.GetOutEnd (u); a != end; ++a) {
+            vertex_t v = g.GetTarget (a);
+            uint64_t rid_v = g.GetRouterId (v).Get();
+            uint32_t kinds = (g.IsNetwork (u) ? 0x1 : 0) | (g.IsNetwork (v) ? 0x2 : 0);
+            arcs.push_back (std::make_pair (std::make_pair ((rid_u << 32) | rid_v, kinds), a));
+        }
+    }
+    std::sort (arcs.begin(), arcs.end());
+
+    std::vector<uint32_t> rids_asbr;
+    for (vertex_t n : asbrs) {
+        rids_asbr.push_back (g.GetRouterId (n).Get());
+    }
+    std::sort (rids_asbr.begin(), rids_asbr.end());
+
+    this->m_numArcs = arcs.size();
+    this->m_words.clear();
+    this->m_words.reserve (4 * arcs.size() + rids_asbr.size());
+
+    // The Summary LSAs carry 24-bit metrics, so the weights get their own
+    // word instead of sharing it with the kinds.
+    for (const std::pair<std::pair<uint64_t, uint32_t>, arc_t> & arc : arcs) {
+        this->m_words.push_back (arc.first.first >> 32);
+        this->m_words.push_back (arc.first.first & 0xffffffff);
+        this->m_words.push_back (arc.first.second);
+        this->m_words.push_back (g.GetWeight (arc.second));
+    }
+    this->m_words.insert (this->m_words.end(), rids_asbr.begin(), rids_asbr.end());
+
+    // FNV-1a
+    this->m_hash = 0xcbf29ce484222325ULL ^ this->m_numArcs;
+    for (uint32_t word : this->m_words) {
+        this->m_hash = (this->m_hash ^ word) * 0x100000001b3ULL;
+    }
+}
+
+uint64_t OspfGraphSignature::GetHash() const {
+    return this->m_hash;
+}
+
+bool OspfGraphSignature::operator == (const OspfGraphSignature & o) const {
+    return this->m_hash    == o.m_hash
+        && this->m_numArcs == o.m_numArcs
+        && this->m_words   == o.m_words;
+}
+
+//-----------------------------------------------------------------
+// OspfFirstHopCache
+//-----------------------------------------------------------------
+
+OspfFirstHopCache::OspfFirstHopCache() :
+    m_capacity (8),
+    m_numHits (0),
+    m_numMisses (0)
+{}
+
+OspfFirstHopCache::Entry * OspfFirstHopCache::FindEntry (const OspfGraphSignature & signature) {
+    for (std::list<Entry>::iterator it = this->m_entries.begin(); it != this->m_entries.end(); ++it) {
+        if (it->first == signature) {
+            this->m_entries.splice (this->m_entries.begin(), this->m_entries, it);
+            return &this->m_entries.front();
+        }
+    }
+    return NULL;
+}
+
+const OspfFirstHopCache::FirstHops * OspfFirstHopCache::Find (const OspfGraphSignature & signature, const router_id_t & v) {
+    NS_LOG_FUNCTION (this << v);
+
+    if (Entry * entry = this->FindEntry (signature)) {
+        MapFirstHops::const_iterator fit (entry->second.find (v));
+        if (fit != entry->second.end()) {
+            ++this->m_numHits;
+            return &fit->second;
+        }
+    }
+
+    ++this->m_numMisses;
+    return NULL;
+}
+
+void OspfFirstHopCache::Insert (const OspfGraphSignature & signature, const router_id_t & v, const FirstHops & firstHops) {
+    NS_LOG_FUNCTION (this << v);
+
+    Entry * entry = this->FindEntry (signature);
+    if (!entry) {
+        this->m_entries.push_front (Entry (signature, MapFirstHops()));
+        entry = &this->m_entries.front();
+
+        while (this->m_entries.size() > this->m_capacity) {
+            this->m_entries.pop_back();
+        }
+    }
+
+    entry->second[v] = firstHops;
+}
+
+bool OspfFirstHopCache::GetFirstHop (const FirstHops & firstHops, const router_id_t & n, router_id_t & firstHop) {
+    FirstHops::const_iterator fit = std::lower_bound (
+        firstHops.begin(), firstHops.end(), FirstHop (n, router_id_t())
+    );
+
+    if (fit == firstHops.end() || fit->first != n) {
+        return false;
+    }
+
+    firstHop = fit->second;
+    return true;
+}
+
+void OspfFirstHopCache::SetCapacity (std::size_t capacity) {
+    NS_LOG_FUNCTION (this << capacity);
+    this->m_capacity = (capacity > 0) ? capacity : 1;
+
+    while (this->m_entries.size() > this->m_capacity) {
+        this->m_entries.pop_back();
+    }
+}
+
+void OspfFirstHopCache::Clear() {
+    NS_LOG_FUNCTION (this);
+    this->m_entries.clear();
+}
+
+uint64_t OspfFirstHopCache::GetNumHits() const {
+    return this->m_numHits;
+}
+
+uint64_t OspfFirstHopCache::GetNumMisses() const {
+    return this->m_numMisses;
+}
+
+} // namespace ospf
+} // namespace ns3
@@ -0,0 +1,204 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+
+#ifndef OSPF_FIRST_HOP_CACHE_H
+#define OSPF_FIRST_HOP_CACHE_H
+
+#include <cstddef>                          // std::size_t
+#include <cstdint>                          // uint*_t
+#include <list>                             // std::list
+#include <map>                              // std::map
+#include <utility>                          // std::pair
+#include <vector>                           // std::vector
+
+#include "ns3/ospf-packet.h"                // ns3::ospf::router_id_t
+#include "ns3/ospf-spf.h"                   // ns3::ospf::OspfCsrGraph
+
+namespace ns3 {
+namespace ospf {
+
+/**
+ * @class OspfGraphSignature
+ * @brief Canonical description of the part of an LSDB the iBGP2 criterion
+ *   depends on: the weighted arcs between routers and the set of ASBRs.
+ *
+ * Two routers may discover the IGP routers in a different order, so their
+ * OspfCsrGraph may number the vertices differently. The signature only
+ * involves router-ids: the arcs (source, target, weight) and the ASBRs
+ * are sorted, so two routers having the same LSDB content have the same
+ * signature. The network vertices are identified by their network
+ * identifier, flagged so that they cannot be confused with a router.
+ */
+
+class OspfGraphSignature
+{
+private:
+    std::vector<uint32_t>   m_words;    /**< Sorted arcs (4 words each), then sorted ASBRs. */
+    std::size_t             m_numArcs;  /**< Number of arcs stored in m_words. */
+    uint64_t                m_hash;     /**< Hash of m_words. */
+
+public:
+
+    /**
+     * @brief Constructor (empty signature).
+     */
+
+    OspfGraphSignature();
+
+    /**
+     * @brief (Re)build this signature.
+     * @param g The snapshot of the IGP graph.
+     * @param asbrs The vertices of g corresponding to ASBRs.
+     */
+
+    void Build(const OspfCsrGraph & g, const std::vector<OspfCsrGraph::vertex_t> & asbrs);
+
+    /**
+     * @brief Retrieve the hash of this signature.
+     * @return The hash value.
+     */
+
+    uint64_t GetHash() const;
+
+    /**
+     * @brief Compare two signatures.
+     * @param o Another signature.
+     * @return true iif both signatures describe the same LSDB content.
+     */
+
+    bool operator == (const OspfGraphSignature & o) const;
+};
+
+/**
+ * @class OspfFirstHopCache
+ * @brief Process-wide cache of the first hops computed by the iBGP2
+ *   daemons, shared by all the routers of the simulation.
+ *
+ * Every router runs its own iBGP2 daemon, and the shortest path tree
+ * rooted in a router v is needed by each neighbor of v. Once one of them
+ * has computed it, it inserts for each target n (ASBR or neighbor of v) the
+ * first hop from v toward n. The other routers having the same LSDB
+ * content (see OspfGraphSignature) then reuse it instead of running the
+ * Dijkstra's algorithm.
+ *
+ * Only the last few signatures are kept, since the routers converge
+ * toward the same LSDB after each IGP change.
+ *
+ * The cache is not thread-safe, it must be accessed from the simulation
+ * thread only.
+ */
+
+class OspfFirstHopCache
+{
+public:
+    typedef std::pair<router_id_t, router_id_t> FirstHop;   /**< (target n, first hop from v toward n) */
+    typedef std::vector<FirstHop>               FirstHops;  /**< Sorted by target. */
+
+private:
+    typedef std::map<router_id_t, FirstHops>    MapFirstHops;   /**< Maps each root v with its first hops. */
+    typedef std::pair<OspfGraphSignature, MapFirstHops> Entry;
+
+    std::list<Entry>    m_entries;      /**< Most recently used first. */
+    std::size_t         m_capacity;     /**< Maximal number of signatures stored. */
+    uint64_t            m_numHits;      /**< Number of successful lookups. */
+    uint64_t            m_numMisses;    /**< Number of failed lookups. */
+
+    /**
+     * @brief Search the entry related to a signature, and move it in front
+     *   of m_entries.
+     * @param signature The signature.
+     * @return The entry, NULL if not found.
+     */
+
+    Entry * FindEntry(const OspfGraphSignature & signature);
+
+public:
+
+    /**
+     * @brief Constructor.
+     */
+
+    OspfFirstHopCache();
+
+    /**
+     * @brief Retrieve the first hops from a given router, computed over a
+     *   given LSDB content.
+     * @param signature The signature of the LSDB content.
+     * @param v The router-id of the root of the shortest path tree.
+     * @return The first hops, NULL if not in cache.
+     */
+
+    const FirstHops * Find(const OspfGraphSignature & signature, const router_id_t & v);
+
+    /**
+     * @brief Store the first hops from a given router, computed over a
+     *   given LSDB content.
+     * @param signature The signature of the LSDB content.
+     * @param v The router-id of the root of the shortest path tree.
+     * @param firstHops The first hops (sorted by target).
+     */
+
+    void Insert(const OspfGraphSignature & signature, const router_id_t & v, const FirstHops & firstHops);
+
+    /**
+     * @brief Search the first hop toward a target.
+     * @param firstHops Some first hops (sorted by target).
+     * @param n The router-id of the target.
+     * @param firstHop The router-id of the first hop toward n (if found).
+     * @return true iif n is reachable and has been stored in firstHops.
+     */
+
+    static bool GetFirstHop(const FirstHops & firstHops, const router_id_t & n, router_id_t & firstHop);
+
+    /**
+     * @brief Set the number of LSDB contents that can be stored.
+     * @param capacity The new capacity (at least 1).
+     */
+
+    void SetCapacity(std::size_t capacity);
+
+    /**
+     * @brief Remove every entry of this cache.
+     */
+
+    void Clear();
+
+    /**
+     * @brief Retrieve the number of successful lookups.
+     * @return The number of hits.
+     */
+
+    uint64_t GetNumHits() const;
+
+    /**
+     * @brief Retrieve the number of failed lookups.
+     * @return The number of misses.
+     */
+
+    uint64_t GetNumMisses() const;
+};
+
+} // namespace ospf
+} // namespace ns3
+
+#endif // OSPF_FIRST_HOP_CACHE_H
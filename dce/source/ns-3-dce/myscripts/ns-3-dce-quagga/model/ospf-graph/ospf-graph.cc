@@ -32,10 +32,13 @@ namespace ospf {
 // OspfVertex
 //-----------------------------------------------------------------
 
-OspfVertex::OspfVertex() {}
+OspfVertex::OspfVertex() :
+    m_isNetwork (false)
+{}
 
-OspfVertex::OspfVertex (const router_id_t & routerId) :
-    m_routerId (routerId)
+OspfVertex::OspfVertex (const router_id_t & routerId, bool isNetwork) :
+    m_routerId (routerId),
+    m_isNetwork (isNetwork)
 {}
 
 OspfVertex::OspfVertex (const OspfVertex & o) {
@@ -46,8 +49,13 @@ const router_id_t & OspfVertex::GetRouterId() const {
     return this->m_routerId;
 }
 
+bool OspfVertex::IsNetwork() const {
+    return this->m_isNetwork;
+}
+
 void OspfVertex::Copy (const OspfVertex & o) {
     this->m_routerId = o.GetRouterId();
+    this->m_isNetwork = o.IsNetwork();
 }
 
 OspfVertex & OspfVertex::operator= (const OspfVertex & o) {
@@ -57,10 +65,11 @@ OspfVertex & OspfVertex::operator= (const OspfVertex & o) {
 }
 
 bool OspfVertex::operator== (const OspfVertex & o) const {
-    return this->GetRouterId() == o.GetRouterId();
+    return this->GetRouterId() == o.GetRouterId() && this->IsNetwork() == o.IsNetwork();
 }
 
 void OspfVertex::Print (std::ostream & os) const {
+    if (this->IsNetwork()) os << "net:";
     os << this->GetRouterId();
 }
 
@@ -142,6 +151,10 @@ const ns3::ospf::OspfEdge::MapDistances & OspfEdge::GetDistances() const {
     return this->m_mapDistances;
 }
 
+const ns3::ospf::OspfEdge::MapInterfaces & OspfEdge::GetInterfaces() const {
+    return this->m_mapInterfaces;
+}
+
 void OspfEdge::SetMetric (const network_id_t & n, const metric_t & m) {
     this->m_mapDistances[n] = m;
 }
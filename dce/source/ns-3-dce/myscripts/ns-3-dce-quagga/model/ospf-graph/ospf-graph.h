@@ -45,14 +45,17 @@ namespace ospf {
  * In OSPF, arcs usually connect a "router node" to a "network node"
  * and vice-versa.
  *
- * In OspfGraph, only "router nodes" are represented. Information related
- * to OSPF networks are stored in the appropriate OspfEdge structure.
+ * In OspfGraph, both are represented, like in the SPF of RFC 2328 (16.1):
+ * a network (transit network or numbered point-to-point link) is a
+ * "pseudo-node" connected to each of its routers, so that a LAN made of k
+ * routers only costs 2k arcs.
  */
 
 class OspfVertex {
 private:
 
-    router_id_t m_routerId;   /**< Router's OSPF router-id. */
+    router_id_t m_routerId;   /**< Router's OSPF router-id, or network identifier of a network. */
+    bool        m_isNetwork;  /**< true iif this OspfVertex represents a network. */
 
 public:
 
@@ -65,10 +68,12 @@ public:
     /**
      * @brief Constructor.
      * @param routerId The router-id related to the OSPF router
-     *    represented by this OspfVertex.
+     *    represented by this OspfVertex, or the network identifier
+     *    of the network it represents.
+     * @param isNetwork Pass true if this OspfVertex represents a network.
      */
 
-    OspfVertex(const router_id_t & routerId);
+    OspfVertex(const router_id_t & routerId, bool isNetwork = false);
 
     /**
      * @brief Constructor by copy.
@@ -84,6 +89,15 @@ public:
 
     const router_id_t & GetRouterId() const;
 
+    /**
+     * @brief Test whether an OspfVertex represents a network. Its
+     *   "router-id" is then the network identifier (the IP address of
+     *   the DR, or the prefix of a point-to-point link).
+     * @return true iif this OspfVertex represents a network.
+     */
+
+    bool IsNetwork() const;
+
     /**
      * @brief Copy an OspfVertex in *this.
      * @param o The copied OspfVertex.
@@ -102,7 +116,8 @@ public:
     /**
      * @brief Compare two OspfVertex.
      * @param o The OspfVertex compared with *this.
-     * @return true iif the both OspfVertex designs the same OSPF router.
+     * @return true iif the both OspfVertex designs the same OSPF router
+     *   (resp. network).
      */
 
     bool operator == (const OspfVertex & o) const;
@@ -131,10 +146,10 @@ std::ostream & operator << (std::ostream & os, const OspfVertex & v);
  * In OSPF, arcs usually connect a "router node" to a "network node"
  * and vice-versa.
  *
- * In OspfGraph, only "router nodes" are represented, and all the networks
- * shared by to neighboring OSPF router are stored in the corresponding
- * edge connecting the both vertices. The information stored in an OspfEdge
- * is always related to the router acting as the source of the arc.
+ * In OspfGraph, an arc from a router to a network carries the metric and
+ * the interface of the router, and an arc from a network to a router has a
+ * null metric (RFC 2328, 16.1). The only arcs connecting two routers model
+ * the ASBR Summary LSAs (see OspfGraphHelper).
  *
  * In OSPF, each "network node" is identified by the IP address of the
  * Designated Router (DR). This network identifier is used internally
@@ -196,6 +211,15 @@ public:
 
     const MapDistances & GetDistances() const;
 
+    /**
+     * @brief Retrieve the interfaces related to each network involved in
+     *   this OspfEdge.
+     * @return The map storing the interface of the source router related
+     *   to each network involved in this OspfEdge.
+     */
+
+    const MapInterfaces & GetInterfaces() const;
+
     /**
      * @brief Changes the OSPF metric assigned to a network embeded in
      *   this OspfEdge. Basically it calls SetDistance by transforming the
@@ -0,0 +1,144 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#include "ns3/ospf-lsa-view.h"
+
+#include "ns3/log.h"                        // NS_LOG_*
+
+NS_LOG_COMPONENT_DEFINE ("OspfLsaView");
+
+namespace ns3 {
+namespace ospf {
+
+bool OspfLsaView::IsValid (const uint8_t * lsa, uint32_t size) {
+    if (size < OSPF_LSA_HEADER_SIZE) return false;
+
+    uint16_t lsaSize = ReadUint16 (lsa + 18);
+    if (lsaSize < OSPF_LSA_HEADER_SIZE || lsaSize > size) return false;
+
+    switch (lsa[3]) {
+        case OSPF_LSA_TYPE_ROUTER:
+        {
+            if (lsaSize < 24) return false;
+
+            // Each link has 12 bytes, followed by 4 bytes per TOS metric.
+            uint16_t numLinks = ReadUint16 (lsa + 22);
+            uint32_t linkOffset = 24;
+            for (uint16_t i = 0; i < numLinks; ++i) {
+                if (linkOffset + 12 > lsaSize) return false;
+                linkOffset += 12 + 4 * lsa[linkOffset + 9];
+            }
+            return linkOffset <= lsaSize;
+        }
+        case OSPF_LSA_TYPE_NETWORK:
+            return lsaSize >= 24;
+        case OSPF_LSA_TYPE_SUMMARY_NETWORK:
+        case OSPF_LSA_TYPE_SUMMARY_ASBR:
+            return lsaSize >= 28;
+        case OSPF_LSA_TYPE_EXTERNAL:
+            return lsaSize >= 36;
+        default:
+            return true;
+    }
+}
+
+void OspfLsaView::Print (std::ostream & os) const {
+    os << "LSA(type = "     << uint32_t (this->GetLsaType())
+       << ", lsid = "       << this->GetLinkStateId()
+       << ", adv = "        << this->GetAdvertisingRouter()
+       << ", seq = "        << std::hex << this->GetSequenceNumber() << std::dec
+       << ", age = "        << this->GetAge()
+       << ')';
+}
+
+std::ostream & operator << (std::ostream & os, const OspfLsaView & lsa) {
+    lsa.Print (os);
+    return os;
+}
+
+bool OspfRouterLsaView::GetStubNetwork (const Ipv4Address & ifAddress, Ipv4Address & network, Ipv4Mask & mask) const {
+    for (LinkIterator it (this->GetLinks()); !it.IsEnd(); it.Next()) {
+        if (it.GetType() != OSPF_LSR_TYPE_STUB) continue;
+
+        // The link data of a stub link is the mask of the prefix.
+        Ipv4Mask linkMask (it.GetLinkData().Get());
+        if (ifAddress.CombineMask (linkMask) == it.GetLinkId()) {
+            network = it.GetLinkId();
+            mask = linkMask;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseOspfLsUpdate (
+    const uint8_t * buffer,
+    uint32_t size,
+    std::vector<OspfLsaView> & lsas,
+    uint32_t ipOffset
+) {
+    lsas.clear();
+
+    uint32_t ospfOffset = GetOspfOffset (buffer, size, ipOffset);
+    if (!ospfOffset || size < ospfOffset + 28) return false;
+    if (buffer[ospfOffset + 1] != OSPF_TYPE_LS_UPDATE) return false;
+
+    // The packet may be padded: the OSPF header gives the actual length.
+    uint32_t end = ospfOffset + ReadUint16 (buffer + ospfOffset + 2);
+    if (end > size) {
+        NS_LOG_WARN ("Truncated OSPF packet (" << size << " < " << end << " bytes)");
+        return false;
+    }
+
+    uint32_t numLsas = ReadUint32 (buffer + ospfOffset + 24);
+    uint32_t lsaOffset = ospfOffset + 28;
+
+    for (uint32_t i = 0; i < numLsas; ++i) {
+        const uint8_t * lsa = buffer + lsaOffset;
+        if (lsaOffset > end || !OspfLsaView::IsValid (lsa, end - lsaOffset)) {
+            NS_LOG_WARN ("Malformed LSA " << i << '/' << numLsas << " at offset " << lsaOffset);
+            return false;
+        }
+
+        uint16_t lsaSize = ReadUint16 (lsa + 18);
+        lsas.push_back (OspfLsaView (lsa, lsaSize));
+        lsaOffset += lsaSize;
+    }
+
+    return true;
+}
+
+bool GetOspfAreaId (
+    const uint8_t * buffer,
+    uint32_t size,
+    Ipv4Address & areaId,
+    uint32_t ipOffset
+) {
+    uint32_t ospfOffset = GetOspfOffset (buffer, size, ipOffset);
+    if (!ospfOffset || size < ospfOffset + 12) return false;
+
+    areaId = Ipv4Address (ReadUint32 (buffer + ospfOffset + 8));
+    return true;
+}
+
+} // namespace ospf
+} // namespace ns3
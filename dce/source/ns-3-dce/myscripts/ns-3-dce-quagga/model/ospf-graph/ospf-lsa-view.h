@@ -0,0 +1,322 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#ifndef OSPF_LSA_VIEW_H
+#define OSPF_LSA_VIEW_H
+
+#include <cstdint>                          // uint*_t
+#include <ostream>                          // std::ostream
+#include <vector>                           // std::vector
+
+#include "ns3/ipv4-address.h"               // ns3::Ipv4Address, ns3::Ipv4Mask
+#include "ns3/ospf-packet.h"                // ns3::ospf::router_id_t, ns3::ospf::metric_t
+
+#define OSPF_LSA_HEADER_SIZE 20
+
+namespace ns3 {
+namespace ospf {
+
+/**
+ * @brief Read a 16-bit integer in network byte order.
+ * @param bytes The address of the first byte (no alignment required).
+ * @return The corresponding integer.
+ */
+
+inline uint16_t ReadUint16(const uint8_t * bytes) {
+    return uint16_t ((bytes[0] << 8) | bytes[1]);
+}
+
+/**
+ * @brief Read a 32-bit integer in network byte order.
+ * @param bytes The address of the first byte (no alignment required).
+ * @return The corresponding integer.
+ */
+
+inline uint32_t ReadUint32(const uint8_t * bytes) {
+    return (uint32_t (bytes[0]) << 24) | (uint32_t (bytes[1]) << 16)
+         | (uint32_t (bytes[2]) << 8)  |  uint32_t (bytes[3]);
+}
+
+/**
+ * @class OspfLsaView
+ * @brief Non-owning view over an LSA carried by a packet.
+ *
+ * A view only stores the address and the size of the LSA: it does not
+ * allocate anything and remains valid as long as the packet bytes. The
+ * views are built by ParseOspfLsUpdate, which checks that the LSA (and its
+ * type specific fields) fits in the packet, so the accessors do not check
+ * the bounds anymore.
+ * @sa https://www.ietf.org/rfc/rfc2328.txt section A.4.1
+ */
+
+class OspfLsaView
+{
+protected:
+    const uint8_t * m_lsa;  /**< First byte of the LSA header. */
+    uint16_t        m_size; /**< Size of the LSA (header included). */
+
+public:
+
+    /**
+     * @brief Constructor.
+     * @param lsa The first byte of the LSA header.
+     * @param size The size of the LSA (header included).
+     */
+
+    OspfLsaView(const uint8_t * lsa, uint16_t size) :
+        m_lsa (lsa),
+        m_size (size)
+    {}
+
+    /**
+     * @brief Check whether an LSA, and its type specific fields, fits in
+     *   a buffer.
+     * @param lsa The first byte of the LSA header.
+     * @param size The number of bytes available from lsa.
+     * @return true iif a view over this LSA can be built.
+     */
+
+    static bool IsValid(const uint8_t * lsa, uint32_t size);
+
+    uint16_t GetAge() const               { return ReadUint16 (this->m_lsa); }
+    uint8_t GetLsaType() const            { return this->m_lsa[3]; }
+    Ipv4Address GetLinkStateId() const    { return Ipv4Address (ReadUint32 (this->m_lsa + 4)); }
+    router_id_t GetAdvertisingRouter() const { return router_id_t (ReadUint32 (this->m_lsa + 8)); }
+    uint32_t GetSequenceNumber() const    { return ReadUint32 (this->m_lsa + 12); }
+    uint16_t GetChecksum() const          { return ReadUint16 (this->m_lsa + 16); }
+    uint16_t GetSize() const              { return this->m_size; }
+
+    /**
+     * @brief Retrieve the bytes following the LSA header.
+     * @return The address of the first byte of the body.
+     */
+
+    const uint8_t * GetBody() const       { return this->m_lsa + OSPF_LSA_HEADER_SIZE; }
+
+    /**
+     * @brief Retrieve the number of bytes following the LSA header.
+     * @return The size of the body.
+     */
+
+    uint16_t GetBodySize() const          { return this->m_size - OSPF_LSA_HEADER_SIZE; }
+
+    /**
+     * @brief Print the header of this LSA in an output stream.
+     * @param os The output stream.
+     */
+
+    void Print(std::ostream & os) const;
+};
+
+/**
+ * @brief Print an OspfLsaView in an output stream.
+ * @param os The output stream.
+ * @param lsa The OspfLsaView.
+ * @return The updated output stream.
+ */
+
+std::ostream & operator << (std::ostream & os, const OspfLsaView & lsa);
+
+/**
+ * @class OspfRouterLsaView
+ * @brief View over a Router LSA.
+ * @sa https://www.ietf.org/rfc/rfc2328.txt section A.4.2
+ */
+
+class OspfRouterLsaView :
+    public OspfLsaView
+{
+public:
+
+    /**
+     * @brief Iterates over the links of a Router LSA. The TOS metrics are
+     *   skipped.
+     */
+
+    class LinkIterator {
+        const uint8_t * m_link;     /**< First byte of the current link. */
+        uint16_t        m_numLinks; /**< Number of links remaining (current one included). */
+    public:
+        LinkIterator(const uint8_t * link, uint16_t numLinks) :
+            m_link (link),
+            m_numLinks (numLinks)
+        {}
+
+        bool IsEnd() const                  { return this->m_numLinks == 0; }
+        void Next()                         { this->m_link += 12 + 4 * this->m_link[9]; --this->m_numLinks; }
+        Ipv4Address GetLinkId() const       { return Ipv4Address (ReadUint32 (this->m_link)); }
+        Ipv4Address GetLinkData() const     { return Ipv4Address (ReadUint32 (this->m_link + 4)); }
+        uint8_t GetType() const             { return this->m_link[8]; }
+        metric_t GetMetric() const          { return ReadUint16 (this->m_link + 10); }
+    };
+
+    /**
+     * @brief Constructor.
+     * @param lsa A view over a valid LSA of type OSPF_LSA_TYPE_ROUTER.
+     */
+
+    explicit OspfRouterLsaView(const OspfLsaView & lsa) :
+        OspfLsaView (lsa)
+    {}
+
+    uint16_t GetNumLinks() const            { return ReadUint16 (this->m_lsa + 22); }
+    LinkIterator GetLinks() const           { return LinkIterator (this->m_lsa + 24, this->GetNumLinks()); }
+
+    /**
+     * @brief Search the stub link covering an interface address. For each
+     *   numbered point-to-point link, the router also announces a stub link
+     *   toward the prefix of the link (RFC 2328, 12.4.1.1).
+     * @param ifAddress The address of an interface of the router.
+     * @param network The address of the prefix (if found).
+     * @param mask The mask of the prefix (if found).
+     * @return true iif a stub link covers ifAddress.
+     */
+
+    bool GetStubNetwork(const Ipv4Address & ifAddress, Ipv4Address & network, Ipv4Mask & mask) const;
+};
+
+/**
+ * @class OspfNetworkLsaView
+ * @brief View over a Network LSA.
+ * @sa https://www.ietf.org/rfc/rfc2328.txt section A.4.3
+ */
+
+class OspfNetworkLsaView :
+    public OspfLsaView
+{
+public:
+
+    /**
+     * @brief Constructor.
+     * @param lsa A view over a valid LSA of type OSPF_LSA_TYPE_NETWORK.
+     */
+
+    explicit OspfNetworkLsaView(const OspfLsaView & lsa) :
+        OspfLsaView (lsa)
+    {}
+
+    Ipv4Mask GetNetworkMask() const         { return Ipv4Mask (ReadUint32 (this->m_lsa + 20)); }
+    uint16_t GetNumAttachedRouters() const  { return (this->m_size - 24) >> 2; }
+    router_id_t GetAttachedRouter(uint16_t i) const { return router_id_t (ReadUint32 (this->m_lsa + 24 + 4 * i)); }
+};
+
+/**
+ * @class OspfSummaryLsaView
+ * @brief View over a Summary LSA, originated by an area border router
+ *   (ABR) in each of its areas: a Network Summary LSA (type 3) announces a
+ *   prefix of another area, an ASBR Summary LSA (type 4) announces an ASBR
+ *   of another area (its link-state ID is then the router-id of the ASBR).
+ *   Only the TOS 0 metric is exposed.
+ * @sa https://www.ietf.org/rfc/rfc2328.txt section A.4.4
+ */
+
+class OspfSummaryLsaView :
+    public OspfLsaView
+{
+public:
+
+    /**
+     * @brief Constructor.
+     * @param lsa A view over a valid LSA of type OSPF_LSA_TYPE_SUMMARY_NETWORK
+     *   or OSPF_LSA_TYPE_SUMMARY_ASBR.
+     */
+
+    explicit OspfSummaryLsaView(const OspfLsaView & lsa) :
+        OspfLsaView (lsa)
+    {}
+
+    Ipv4Mask GetNetworkMask() const         { return Ipv4Mask (ReadUint32 (this->m_lsa + 20)); }
+    metric_t GetMetric() const              { return ReadUint32 (this->m_lsa + 24) & 0xffffff; }
+};
+
+/**
+ * @class OspfExternalLsaView
+ * @brief View over an AS External LSA (only the TOS 0 metric is exposed).
+ * @sa https://www.ietf.org/rfc/rfc2328.txt section A.4.5
+ */
+
+class OspfExternalLsaView :
+    public OspfLsaView
+{
+public:
+
+    /**
+     * @brief Constructor.
+     * @param lsa A view over a valid LSA of type OSPF_LSA_TYPE_EXTERNAL.
+     */
+
+    explicit OspfExternalLsaView(const OspfLsaView & lsa) :
+        OspfLsaView (lsa)
+    {}
+
+    Ipv4Mask GetNetworkMask() const         { return Ipv4Mask (ReadUint32 (this->m_lsa + 20)); }
+    bool IsType2() const                    { return (this->m_lsa[24] & 0x80) != 0; }
+    metric_t GetMetric() const              { return ReadUint32 (this->m_lsa + 24) & 0xffffff; }
+    Ipv4Address GetForwardingAddress() const { return Ipv4Address (ReadUint32 (this->m_lsa + 28)); }
+    uint32_t GetRouteTag() const            { return ReadUint32 (this->m_lsa + 32); }
+};
+
+/**
+ * @brief Parse the LSAs carried by an OSPF LS-Update packet. Every field
+ *   is checked against the size of the packet (and the length announced
+ *   in the OSPF header).
+ * @param buffer The bytes of the packet (starting from the PPP header,
+ *   see IsOspfPacket).
+ * @param size The size of the packet.
+ * @param lsas A vector cleared then filled with a view per LSA. Its
+ *   capacity is kept from one packet to another, so that parsing does not
+ *   allocate in steady state.
+ * @param ipOffset The size of the link-layer header (see IsOspfPacket).
+ * @return false if the packet is not an LS-Update packet or is truncated
+ *   (the LSAs preceding the error are kept).
+ */
+
+bool ParseOspfLsUpdate(
+    const uint8_t * buffer,
+    uint32_t size,
+    std::vector<OspfLsaView> & lsas,
+    uint32_t ipOffset = OSPF_PPP_HEADER_SIZE
+);
+
+/**
+ * @brief Retrieve the area an OSPF packet belongs to. The Router, Network
+ *   and Summary LSAs carried by an LS-Update packet are scoped to this
+ *   area, while the AS External LSAs are flooded in every (non-stub) area.
+ * @param buffer The bytes of the packet (starting from the PPP header,
+ *   see IsOspfPacket).
+ * @param size The size of the packet.
+ * @param areaId The area ID found in the OSPF header (if any).
+ * @param ipOffset The size of the link-layer header (see IsOspfPacket).
+ * @return false if the packet is not an OSPF packet or is truncated.
+ */
+
+bool GetOspfAreaId(
+    const uint8_t * buffer,
+    uint32_t size,
+    Ipv4Address & areaId,
+    uint32_t ipOffset = OSPF_PPP_HEADER_SIZE
+);
+
+} // namespace ospf
+} // namespace ns3
+
+#endif // OSPF_LSA_VIEW_H
@@ -0,0 +1,154 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#include "ns3/ospf-lsdb.h"
+
+#include <algorithm>                        // std::equal
+
+#include "ns3/log.h"                        // NS_LOG_*
+
+NS_LOG_COMPONENT_DEFINE ("OspfLsdb");
+
+namespace ns3 {
+namespace ospf {
+
+OspfLsdb::Key::Key (const OspfLsaView & lsa) :
+    type (lsa.GetLsaType()),
+    linkStateId (lsa.GetLinkStateId()),
+    advertisingRouter (lsa.GetAdvertisingRouter())
+{}
+
+bool OspfLsdb::Key::operator < (const OspfLsdb::Key & key) const {
+    if (this->type != key.type) return this->type < key.type;
+    if (this->linkStateId != key.linkStateId) return this->linkStateId < key.linkStateId;
+    return this->advertisingRouter < key.advertisingRouter;
+}
+
+uint32_t OspfLsdb::Entry::GetAge (const Time & now) const {
+    uint32_t age = this->age + uint32_t ((now - this->received).GetSeconds());
+    return age < OSPF_LSA_MAX_AGE ? age : OSPF_LSA_MAX_AGE;
+}
+
+OspfLsdb::OspfLsdb() :
+    m_nextExpiration (Time::Max())
+{}
+
+int OspfLsdb::Compare (const OspfLsaView & lsa, const OspfLsdb::Entry & entry, const Time & now) {
+    // The sequence numbers are signed (RFC 2328, section 12.1.6).
+    int32_t sequenceNumber = int32_t (lsa.GetSequenceNumber());
+    int32_t sequenceNumberEntry = int32_t (entry.sequenceNumber);
+    if (sequenceNumber != sequenceNumberEntry) {
+        return sequenceNumber > sequenceNumberEntry ? 1 : -1;
+    }
+
+    if (lsa.GetChecksum() != entry.checksum) {
+        return lsa.GetChecksum() > entry.checksum ? 1 : -1;
+    }
+
+    uint32_t age = lsa.GetAge() < OSPF_LSA_MAX_AGE ? lsa.GetAge() : OSPF_LSA_MAX_AGE;
+    uint32_t ageEntry = entry.GetAge (now);
+    if ((age == OSPF_LSA_MAX_AGE) != (ageEntry == OSPF_LSA_MAX_AGE)) {
+        return age == OSPF_LSA_MAX_AGE ? 1 : -1;
+    }
+
+    uint32_t ageDiff = age > ageEntry ? age - ageEntry : ageEntry - age;
+    if (ageDiff > OSPF_LSA_MAX_AGE_DIFF) {
+        return age < ageEntry ? 1 : -1;
+    }
+
+    return 0;
+}
+
+OspfLsdb::Result OspfLsdb::Install (const OspfLsaView & lsa, const Time & now) {
+    Key key (lsa);
+    bool isMaxAge = (lsa.GetAge() >= OSPF_LSA_MAX_AGE);
+    Entries::iterator fit (this->m_entries.find (key));
+    bool isNew = (fit == this->m_entries.end());
+
+    if (isNew) {
+        // A MaxAge LSA which is unknown is only flooded to be acknowledged.
+        if (isMaxAge) return LSA_DISCARDED;
+        fit = this->m_entries.insert (std::make_pair (key, Entry())).first;
+    } else {
+        if (Compare (lsa, fit->second, now) <= 0) return LSA_DISCARDED;
+
+        if (isMaxAge) {
+            NS_LOG_LOGIC ("Flush LSA " << lsa);
+            this->m_entries.erase (fit);
+            return LSA_FLUSHED;
+        }
+    }
+
+    Entry & entry = fit->second;
+    const uint8_t * body = lsa.GetBody();
+    bool isSameBody = !isNew
+        && entry.body.size() == lsa.GetBodySize()
+        && std::equal (entry.body.begin(), entry.body.end(), body);
+    Result result = isSameBody ? LSA_REFRESHED : LSA_CHANGED;
+
+    entry.age = lsa.GetAge();
+    entry.sequenceNumber = lsa.GetSequenceNumber();
+    entry.checksum = lsa.GetChecksum();
+    entry.received = now;
+    if (result == LSA_CHANGED) {
+        entry.body.assign (body, body + lsa.GetBodySize());
+    }
+
+    Time expiration = now + Seconds (OSPF_LSA_MAX_AGE - entry.age);
+    if (expiration < this->m_nextExpiration) {
+        this->m_nextExpiration = expiration;
+    }
+
+    return result;
+}
+
+void OspfLsdb::Expire (const Time & now, std::vector<OspfLsdb::Key> & keys) {
+    if (now < this->m_nextExpiration) return;
+
+    this->m_nextExpiration = Time::Max();
+    for (Entries::iterator it = this->m_entries.begin(); it != this->m_entries.end();) {
+        const Entry & entry = it->second;
+
+        if (entry.GetAge (now) >= OSPF_LSA_MAX_AGE) {
+            keys.push_back (it->first);
+            this->m_entries.erase (it++);
+        } else {
+            Time expiration = entry.received + Seconds (OSPF_LSA_MAX_AGE - entry.age);
+            if (expiration < this->m_nextExpiration) {
+                this->m_nextExpiration = expiration;
+            }
+            ++it;
+        }
+    }
+}
+
+std::size_t OspfLsdb::GetSize() const {
+    return this->m_entries.size();
+}
+
+void OspfLsdb::Clear() {
+    this->m_entries.clear();
+    this->m_nextExpiration = Time::Max();
+}
+
+} // namespace ospf
+} // namespace ns3
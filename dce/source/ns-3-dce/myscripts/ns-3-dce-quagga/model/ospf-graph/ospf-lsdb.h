@@ -0,0 +1,168 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#ifndef OSPF_LSDB_H
+#define OSPF_LSDB_H
+
+#include <cstdint>                          // uint*_t
+#include <map>                              // std::map
+#include <vector>                           // std::vector
+
+#include "ns3/ipv4-address.h"               // ns3::Ipv4Address
+#include "ns3/nstime.h"                     // ns3::Time
+#include "ns3/ospf-lsa-view.h"             // ns3::ospf::OspfLsaView
+
+namespace ns3 {
+namespace ospf {
+
+/**
+ * @class OspfLsdb
+ * @brief Link state database: stores, for each LSA identified by (LS type,
+ *   link-state id, advertising router), the header and the content of the
+ *   most recent instance received (see RFC 2328, section 13).
+ *
+ * It is used to filter the LSAs before they alter the OSPF graph: an LSA
+ * flooded on several interfaces, retransmitted or refreshed without change
+ * is discarded, and the LSAs which are flushed (MaxAge) or which are not
+ * refreshed anymore are reported so that their content can be withdrawn.
+ */
+
+class OspfLsdb
+{
+public:
+
+    /**
+     * @brief Identifies an LSA.
+     */
+
+    struct Key {
+        uint8_t         type;               /**< LS type. */
+        Ipv4Address     linkStateId;        /**< Link-state id. */
+        router_id_t     advertisingRouter;  /**< Advertising router. */
+
+        /**
+         * @brief Constructor.
+         * @param lsa The LSA.
+         */
+
+        Key(const OspfLsaView & lsa);
+
+        bool operator < (const Key & key) const;
+    };
+
+    /**
+     * @brief Outcome of Install().
+     */
+
+    enum Result {
+        LSA_DISCARDED,  /**< Same or older instance: nothing to do. */
+        LSA_REFRESHED,  /**< More recent instance, with the same content. */
+        LSA_CHANGED,    /**< New LSA, or more recent instance with another content. */
+        LSA_FLUSHED     /**< MaxAge instance: the LSA has been removed. */
+    };
+
+private:
+
+    /**
+     * @brief The instance of an LSA stored in the LSDB.
+     */
+
+    struct Entry {
+        uint16_t                age;            /**< Age when received (in seconds). */
+        uint32_t                sequenceNumber; /**< LS sequence number. */
+        uint16_t                checksum;       /**< LS checksum. */
+        Time                    received;       /**< Time of reception. */
+        std::vector<uint8_t>    body;           /**< Content of the LSA. */
+
+        /**
+         * @brief Compute the current age of this instance.
+         * @param now The current time.
+         * @return The age (in seconds), at most OSPF_LSA_MAX_AGE.
+         */
+
+        uint32_t GetAge(const Time & now) const;
+    };
+
+    typedef std::map<Key, Entry> Entries;
+
+    Entries     m_entries;          /**< The LSAs. */
+    Time        m_nextExpiration;   /**< No LSA reaches MaxAge before this time. */
+
+    /**
+     * @brief Compare an LSA received with the instance stored in the LSDB
+     *   (see RFC 2328, section 13.1).
+     * @param lsa The LSA received.
+     * @param entry The stored instance.
+     * @param now The current time.
+     * @return A positive (resp. negative) value if lsa is more (resp. less)
+     *   recent than entry, 0 if this is the same instance.
+     */
+
+    static int Compare(const OspfLsaView & lsa, const Entry & entry, const Time & now);
+
+public:
+
+    /**
+     * @brief Constructor (empty LSDB).
+     */
+
+    OspfLsdb();
+
+    /**
+     * @brief Install an LSA in the LSDB if it is more recent than the
+     *   stored instance. The content is only copied if it has changed,
+     *   reusing the memory of the previous instance.
+     * @param lsa The LSA received.
+     * @param now The current time.
+     * @return What must be done with the content of the LSA.
+     */
+
+    Result Install(const OspfLsaView & lsa, const Time & now);
+
+    /**
+     * @brief Remove the LSAs that reached MaxAge since they have been
+     *   received (i.e. that have not been refreshed by their advertising
+     *   router).
+     * @param now The current time.
+     * @param keys The vector where the keys of the LSAs removed are appended.
+     */
+
+    void Expire(const Time & now, std::vector<Key> & keys);
+
+    /**
+     * @brief Retrieve the number of LSAs stored in the LSDB.
+     * @return The number of LSAs.
+     */
+
+    std::size_t GetSize() const;
+
+    /**
+     * @brief Remove every LSA.
+     */
+
+    void Clear();
+};
+
+} // namespace ospf
+} // namespace ns3
+
+#endif // OSPF_LSDB_H
@@ -25,6 +25,21 @@
 
 #define IPPROTO_OSPF    89
 
+// see (RFC 2328, A.3.1, p190)
+#define OSPF_TYPE_HELLO             1
+#define OSPF_TYPE_LS_UPDATE         4
+
+// Size of the link-layer header preceding the IP header in the packets
+// sniffed on a NetDevice: ns-3 prepends 2 bytes (0x0021 for IPv4) to mimic
+// PPP on the point-to-point links, and an Ethernet II header on CSMA links.
+#define OSPF_PPP_HEADER_SIZE        2
+#define OSPF_ETHERNET_HEADER_SIZE   14
+
+// Number of bytes needed by GetOspfPacketType: link-layer header (up to
+// Ethernet), IPv4 header (with options) and the beginning of the OSPF
+// header.
+#define OSPF_PEEK_SIZE              80
+
 // see (RFC 2328, A.4.1, p204)
 #define OSPF_LSA_TYPE_ROUTER          1
 #define OSPF_LSA_TYPE_NETWORK         2
@@ -32,6 +47,11 @@
 #define OSPF_LSA_TYPE_SUMMARY_ASBR    4
 #define OSPF_LSA_TYPE_EXTERNAL        5
 
+// see (RFC 2328, B, p238)
+#define OSPF_LSA_MAX_AGE              3600
+#define OSPF_LSA_MAX_AGE_DIFF         900
+#define OSPF_LS_INFINITY              0xffffff
+
 // see (RFC 2328, A.4.2, p207)
 #define OSPF_LSR_TYPE_PTP          1
 #define OSPF_LSR_TYPE_TRANSIT      2
@@ -88,14 +108,15 @@ typedef uint32_t metric_t;
 
 class OspfLsa {
 private:
-    // uint16_t     m_age;
+    uint16_t      m_age;                /**< The age of the LSA (in seconds) when it has been received. */
     uint8_t       m_lsaType;            /**< The LSA type of this OSPF message. */
     // uint8_t      m_option;
+    Ipv4Address   m_linkStateId;        /**< The link-state id of this OSPF message. */
     Ipv4Address   m_advertisingRouter;  /**< The router-id of the router announcing the message. */
-    // uint32_t     m_sequenceNumber;
-    // uint16_t     m_checksum;
+    uint32_t      m_sequenceNumber;     /**< The LS sequence number of this instance. */
+    uint16_t      m_checksum;           /**< The LS checksum of this instance. */
     // uint16_t     m_length;
-
+    std::vector<uint8_t> m_body;        /**< The bytes following the LSA header. */
 
 protected:
     /**
@@ -112,9 +133,10 @@ public:
      * @brief Constructor.
      * @param lsaType The LSA type of this OSPF message.
      * @param advertisingRouter The Ipv4Address of the advertising router.
+     * @param linkStateId The link-state id of this OSPF message.
      */
 
-    OspfLsa (uint8_t lsaType, const Ipv4Address & advertisingRouter);
+    OspfLsa (uint8_t lsaType, const Ipv4Address & advertisingRouter, const Ipv4Address & linkStateId);
 
     /**
      * @brief Destructor.
@@ -136,6 +158,78 @@ public:
 
     uint8_t GetLsaType() const;
 
+    /**
+     * @brief Retrieve the link-state id of this OSPF message.
+     * @return The corresponding Ipv4Address.
+     */
+
+    const Ipv4Address & GetLinkStateId() const;
+
+    /**
+     * @brief Set the link-state id of this OSPF message.
+     * @param linkStateId The new Ipv4Address.
+     */
+
+    void SetLinkStateId(const Ipv4Address & linkStateId);
+
+    /**
+     * @brief Retrieve the age of this OSPF message when it was received.
+     * @return The age (in seconds).
+     */
+
+    uint16_t GetAge() const;
+
+    /**
+     * @brief Set the age of this OSPF message.
+     * @param age The age (in seconds).
+     */
+
+    void SetAge(uint16_t age);
+
+    /**
+     * @brief Retrieve the LS sequence number of this OSPF message.
+     * @return The sequence number.
+     */
+
+    uint32_t GetSequenceNumber() const;
+
+    /**
+     * @brief Set the LS sequence number of this OSPF message.
+     * @param sequenceNumber The sequence number.
+     */
+
+    void SetSequenceNumber(uint32_t sequenceNumber);
+
+    /**
+     * @brief Retrieve the LS checksum of this OSPF message.
+     * @return The checksum.
+     */
+
+    uint16_t GetChecksum() const;
+
+    /**
+     * @brief Set the LS checksum of this OSPF message.
+     * @param checksum The checksum.
+     */
+
+    void SetChecksum(uint16_t checksum);
+
+    /**
+     * @brief Retrieve the bytes following the LSA header, used to compare
+     *   the content of two instances of an LSA.
+     * @return The corresponding bytes.
+     */
+
+    const std::vector<uint8_t> & GetBody() const;
+
+    /**
+     * @brief Set the bytes following the LSA header.
+     * @param body The address of the first byte.
+     * @param size The number of bytes.
+     */
+
+    void SetBody(const uint8_t * body, std::size_t size);
+
     /**
      * @brief Print this OspfLsa to an output stream.
      * @param os The output stream.
@@ -204,7 +298,6 @@ class OspfNetworkLsa :
     public OspfLsa
 {
 private:
-    Ipv4Address m_linkStateId; /**< The address part of the prefix. */
     Ipv4Mask    m_networkMask; /**< The mask part of the prefix. */
 public:
 
@@ -223,14 +316,6 @@ public:
         const Ipv4Mask           & networkMask
     );
 
-    /**
-     * @brief Retrieve the link-state-id address transported by this
-     *   OspfNetworkLsa.
-     * @return The corresponding network Ipv4Address.
-     */
-
-    const Ipv4Address & GetLinkStateId() const;
-
     /**
      * @brief Retrieve the network mask transported by this
      *   OspfNetworkLsa.
@@ -254,7 +339,6 @@ class OspfExternalLsa :
     public OspfLsa
 {
 private:
-    ospf::network_id_t  m_linkStateId;  /**< The address part of the external network. */
     Ipv4Mask            m_networkMask;  /**< The mask part of the external network. */
     ospf::metric_t      m_metric;       /**< The OSPF metric from the connected router toward this network. */
 public:
@@ -291,20 +375,6 @@ public:
 
     void SetMetric(const ospf::metric_t &  metric);
 
-    /**
-     * @brief Retrieve the link-state id of this OspfExternalLsa instance.
-     * @returns The corresponding Ipv4Address.
-     */
-
-    const Ipv4Address & GetLinkStateId() const;
-
-    /**
-     * @brief Set the link-state id of this OspfExternalLsa instance.
-     * @param linkStateId The new Ipv4Address.
-     */
-
-    void SetLinkStateId(const Ipv4Address & linkStateId);
-
     /**
      * @brief Print this OspfExternalLsa to an output stream.
      * @param os The output stream.
@@ -323,21 +393,55 @@ public:
  * Tests whether a packet is an OSPF packet or not.
  * \param buffer The bytes of the packet (basically the contents of the buffer
  *    nested in a ns3::Packet, see PacketGetBuffer.
+ * \param ipOffset The size of the link-layer header preceding the IP
+ *    header (e.g. OSPF_PPP_HEADER_SIZE, OSPF_ETHERNET_HEADER_SIZE).
  * \returns true iif the Packet is an OSPF packet.
  */
 
-bool IsOspfPacket(const uint8_t * buffer);
+bool IsOspfPacket(const uint8_t * buffer, uint32_t ipOffset = OSPF_PPP_HEADER_SIZE);
+
+/**
+ * \brief Classify a packet from its first bytes, so that only the
+ *   relevant packets have to be copied entirely.
+ * \param buffer The first bytes of the packet (starting from the PPP
+ *   header, see IsOspfPacket).
+ * \param size The number of bytes available in buffer (OSPF_PEEK_SIZE
+ *   bytes are always enough).
+ * \param ospfType The type of the OSPF packet (e.g. OSPF_TYPE_LS_UPDATE),
+ *   set if the packet is an OSPF packet.
+ * \param ipOffset The size of the link-layer header (see IsOspfPacket).
+ * \returns true iif the packet is an OSPF packet.
+ */
+
+bool GetOspfPacketType(const uint8_t * buffer, uint32_t size, uint8_t & ospfType, uint32_t ipOffset = OSPF_PPP_HEADER_SIZE);
+
+/**
+ * \brief Locate the OSPF header of a packet.
+ * \param buffer The bytes of the packet (starting from the PPP header,
+ *   see IsOspfPacket).
+ * \param size The number of bytes available in buffer.
+ * \param ipOffset The size of the link-layer header (see IsOspfPacket).
+ * \returns The offset of the OSPF header in buffer (the two first bytes
+ *   of the OSPF header are available), 0 if this is not an OSPF packet.
+ */
+
+uint32_t GetOspfOffset(const uint8_t * buffer, uint32_t size, uint32_t ipOffset = OSPF_PPP_HEADER_SIZE);
 
 /**
- * \brief Extract LSAs from an OSPF packet of type LS-Update
+ * \brief Extract LSAs from an OSPF packet of type LS-Update. Each LSA is
+ *   allocated: this is convenient to inspect a packet, but the LSAs should
+ *   rather be processed through the views built by
+ *   ospf::ParseOspfLsUpdate (see ospf-lsa-view.h).
  * \param buffer The bytes transported in an IPv4/OSPF packet (starting
  *   from the beginning of the IPv4 header).
+ * \param size The size of the packet.
  * \param lsas An empty vector which will contains the LSA carried
- *    in "buffer".
+ *    in "buffer". They must be deleted by the caller.
  */
 
 void ExtractOspfLsa(
     const uint8_t * buffer,
+    uint32_t size,
     std::vector<OspfLsa *> & lsas
 );
 
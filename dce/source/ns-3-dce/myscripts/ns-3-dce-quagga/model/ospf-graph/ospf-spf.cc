@@ -0,0 +1,419 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#include "ns3/ospf-spf.h"
+
+#include <algorithm>                        // std::sort, std::make_heap, std::push_heap, std::pop_heap
+#include <functional>                       // std::greater
+#include <limits>                           // std::numeric_limits
+
+#include <boost/foreach.hpp>                // BOOST_FOREACH
+#include <boost/graph/adjacency_list.hpp>   // boost::out_edges
+
+#include "ns3/log.h"                        // NS_ASSERT
+
+namespace ns3 {
+namespace ospf {
+
+//-----------------------------------------------------------------
+// OspfCsrGraph
+//-----------------------------------------------------------------
+
+const OspfCsrGraph::vertex_t OspfCsrGraph::NULL_VERTEX = std::numeric_limits<OspfCsrGraph::vertex_t>::max();
+const OspfCsrGraph::arc_t    OspfCsrGraph::NULL_ARC    = std::numeric_limits<OspfCsrGraph::arc_t>::max();
+
+OspfCsrGraph::OspfCsrGraph() :
+    m_maxWeight (0)
+{
+    this->m_offsets.push_back (0);
+    this->m_inOffsets.push_back (0);
+}
+
+void OspfCsrGraph::Build (const OspfGraph & g) {
+    typedef boost::graph_traits<OspfGraph>::edge_descriptor ed_t;
+
+    const std::size_t numVertices = boost::num_vertices (g);
+
+    this->m_offsets.resize (numVertices + 1);
+    this->m_routerIds.resize (numVertices);
+    this->m_isNetwork.resize (numVertices);
+    this->m_targets.clear();
+    this->m_weights.clear();
+    this->m_maxWeight = 0;
+
+    for (vertex_t u = 0; u < numVertices; ++u) {
+        this->m_offsets[u] = this->m_targets.size();
+        this->m_routerIds[u] = g[u].GetRouterId();
+        this->m_isNetwork[u] = g[u].IsNetwork();
+
+        BOOST_FOREACH (const ed_t & e, boost::out_edges (u, g)) {
+            vertex_t v = boost::target (e, g);
+
+            // Loops are useless to compute shortest paths.
+            if (u == v) continue;
+
+            // GetDistance() returns the lowest metric installed on this
+            // OspfEdge: 16 bits for the Router LSAs, 24 bits for the
+            // Summary LSAs. An OspfEdge without metric is seen as
+            // LSInfinity, so that the distances cannot overflow.
+            metric_t metric = g[e].GetDistance();
+            weight_t weight = (metric > OSPF_LS_INFINITY) ? OSPF_LS_INFINITY : metric;
+
+            this->m_targets.push_back (v);
+            this->m_weights.push_back (weight);
+            if (weight > this->m_maxWeight) this->m_maxWeight = weight;
+        }
+    }
+
+    this->m_offsets[numVertices] = this->m_targets.size();
+
+    // Reverse CSR: count the in-arcs of each vertex, then scatter them.
+    const std::size_t numArcs = this->m_targets.size();
+    this->m_inOffsets.assign (numVertices + 1, 0);
+    this->m_sources.resize (numArcs);
+    this->m_inWeights.resize (numArcs);
+
+    for (arc_t a = 0; a < numArcs; ++a) {
+        ++this->m_inOffsets[this->m_targets[a] + 1];
+    }
+
+    for (vertex_t v = 0; v < numVertices; ++v) {
+        this->m_inOffsets[v + 1] += this->m_inOffsets[v];
+    }
+
+    for (vertex_t u = 0; u < numVertices; ++u) {
+        for (arc_t a = this->m_offsets[u]; a != this->m_offsets[u + 1]; ++a) {
+            // m_inOffsets[v] is used as a cursor, and is restored below.
+            arc_t & i = this->m_inOffsets[this->m_targets[a]];
+            this->m_sources[i] = u;
+            this->m_inWeights[i] = this->m_weights[a];
+            ++i;
+        }
+    }
+
+    for (vertex_t v = numVertices; v > 0; --v) {
+        this->m_inOffsets[v] = this->m_inOffsets[v - 1];
+    }
+    this->m_inOffsets[0] = 0;
+}
+
+OspfCsrGraph::arc_t OspfCsrGraph::FindArc (OspfCsrGraph::vertex_t u, OspfCsrGraph::vertex_t v) const {
+    if (u >= this->GetNumVertices()) return NULL_ARC;
+
+    for (arc_t a = this->m_offsets[u], end = this->m_offsets[u + 1]; a != end; ++a) {
+        if (this->m_targets[a] == v) return a;
+    }
+
+    return NULL_ARC;
+}
+
+std::size_t OspfCsrGraph::GetNumVertices() const {
+    return this->m_routerIds.size();
+}
+
+std::size_t OspfCsrGraph::GetNumArcs() const {
+    return this->m_targets.size();
+}
+
+OspfCsrGraph::weight_t OspfCsrGraph::GetMaxWeight() const {
+    return this->m_maxWeight;
+}
+
+const router_id_t & OspfCsrGraph::GetRouterId (OspfCsrGraph::vertex_t u) const {
+    return this->m_routerIds[u];
+}
+
+//-----------------------------------------------------------------
+// OspfSpf
+//-----------------------------------------------------------------
+
+const OspfSpf::distance_t OspfSpf::INFINITE_DISTANCE = std::numeric_limits<OspfSpf::distance_t>::max();
+const OspfCsrGraph::weight_t OspfSpf::MAX_DIAL_WEIGHT = 0xffff;
+
+OspfSpf::OspfSpf() :
+    m_source (OspfCsrGraph::NULL_VERTEX),
+    m_numTargets (0),
+    m_isComplete (false)
+{}
+
+void OspfSpf::Compute (const OspfCsrGraph & g, OspfSpf::vertex_t source) {
+    const std::size_t numVertices = g.GetNumVertices();
+    NS_ASSERT (source < numVertices);
+
+    this->m_source = source;
+    this->m_distances.assign (numVertices, INFINITE_DISTANCE);
+    this->m_predecessors.assign (numVertices, OspfCsrGraph::NULL_VERTEX);
+    this->m_firstHops.assign (numVertices, OspfCsrGraph::NULL_VERTEX);
+
+    this->m_distances[source] = 0;
+    this->m_seeds.clear();
+    this->m_seeds.push_back (std::make_pair (0, source));
+    this->Propagate (g);
+}
+
+void OspfSpf::Compute (const OspfCsrGraph & g, OspfSpf::vertex_t source, const std::vector<OspfSpf::vertex_t> & targets) {
+    this->m_isTarget.assign (g.GetNumVertices(), false);
+    this->m_numTargets = 0;
+
+    for (vertex_t v : targets) {
+        NS_ASSERT (v < g.GetNumVertices());
+        if (!this->m_isTarget[v]) {
+            this->m_isTarget[v] = true;
+            ++this->m_numTargets;
+        }
+    }
+
+    // Without target, nothing has to be computed, but the tree would be
+    // inconsistent: run the complete search.
+    this->Compute (g, source);
+    this->m_numTargets = 0;
+}
+
+void OspfSpf::Update (const OspfCsrGraph & g, const std::vector<OspfSpf::Arc> & arcs) {
+    const std::size_t numVertices = g.GetNumVertices();
+    NS_ASSERT (this->m_source < numVertices);
+    NS_ASSERT (this->m_distances.size() <= numVertices);
+    NS_ASSERT_MSG (this->m_isComplete, "Cannot repair an incomplete shortest path tree");
+
+    // Vertices are never removed from an OspfGraph, new ones are unreachable
+    // until an arc reaches them.
+    this->m_distances.resize (numVertices, INFINITE_DISTANCE);
+    this->m_predecessors.resize (numVertices, OspfCsrGraph::NULL_VERTEX);
+    this->m_firstHops.resize (numVertices, OspfCsrGraph::NULL_VERTEX);
+    this->m_isAffected.assign (numVertices, false);
+    this->m_affected.clear();
+    this->m_seeds.clear();
+
+    // An arc (a, b) of the tree which has been removed or whose weight has
+    // increased invalidates the subtree rooted in b.
+    for (const Arc & arc : arcs) {
+        const vertex_t & a = arc.first, & b = arc.second;
+        if (this->m_predecessors[b] != a || this->m_isAffected[b]) continue;
+
+        OspfCsrGraph::arc_t ab = g.FindArc (a, b);
+        if (ab == OspfCsrGraph::NULL_ARC || this->m_distances[a] + g.GetWeight (ab) > this->m_distances[b]) {
+            this->m_isAffected[b] = true;
+            this->m_affected.push_back (b);
+        }
+    }
+
+    // Collect the subtrees. If the arc (u, v) of the tree has disappeared,
+    // v is already one of the roots, so browsing the new out-arcs is enough.
+    for (std::size_t i = 0; i < this->m_affected.size(); ++i) {
+        vertex_t u = this->m_affected[i];
+
+        for (OspfCsrGraph::arc_t a = g.GetOutBegin (u), end = g.GetOutEnd (u); a != end; ++a) {
+            vertex_t v = g.GetTarget (a);
+
+            if (this->m_predecessors[v] == u && !this->m_isAffected[v]) {
+                this->m_isAffected[v] = true;
+                this->m_affected.push_back (v);
+            }
+        }
+    }
+
+    for (vertex_t v : this->m_affected) {
+        this->m_distances[v] = INFINITE_DISTANCE;
+        this->m_predecessors[v] = OspfCsrGraph::NULL_VERTEX;
+        this->m_firstHops[v] = OspfCsrGraph::NULL_VERTEX;
+    }
+
+    // Each affected vertex is reattached to its best unaffected neighbor.
+    for (vertex_t v : this->m_affected) {
+        for (OspfCsrGraph::arc_t a = g.GetInBegin (v), end = g.GetInEnd (v); a != end; ++a) {
+            vertex_t u = g.GetSource (a);
+            if (this->m_isAffected[u] || !this->IsReachable (u)) continue;
+
+            this->Relax (g, u, v, this->m_distances[u] + g.GetInWeight (a));
+        }
+
+        if (this->IsReachable (v)) {
+            this->m_seeds.push_back (std::make_pair (this->m_distances[v], v));
+        }
+    }
+
+    // An arc (a, b) whose weight has decreased (or which has been added)
+    // may shorten the path toward b and its descendants, or provide an
+    // equal cost path with a better first hop.
+    for (const Arc & arc : arcs) {
+        const vertex_t & a = arc.first, & b = arc.second;
+        if (this->m_isAffected[a] || !this->IsReachable (a)) continue;
+
+        OspfCsrGraph::arc_t ab = g.FindArc (a, b);
+        if (ab == OspfCsrGraph::NULL_ARC) continue;
+
+        distance_t db = this->m_distances[a] + g.GetWeight (ab);
+        if (this->Relax (g, a, b, db)) {
+            this->m_seeds.push_back (std::make_pair (db, b));
+        }
+    }
+
+    this->Propagate (g);
+}
+
+void OspfSpf::Propagate (const OspfCsrGraph & g) {
+    // The bucket queue needs one bucket per possible weight, which is too
+    // much for the 24-bit metrics of the Summary LSAs.
+    if (g.GetMaxWeight() <= MAX_DIAL_WEIGHT) {
+        this->PropagateDial (g);
+    } else {
+        this->PropagateHeap (g);
+    }
+}
+
+void OspfSpf::PropagateDial (const OspfCsrGraph & g) {
+    // Tentative distances are in [d, d + C], so C + 1 buckets are enough.
+    // The seeds may be far away from each other, so they are only queued
+    // once the current distance reaches them. The label of a vertex at the
+    // current distance may still be improved by a better first hop through
+    // a 0-weight arc: it is then pushed again in the current bucket. So the
+    // labels at distance d are final once the bucket d is empty, and the
+    // search stops at the end of the bucket in which the last target (if
+    // any) is reached.
+    const std::size_t numBuckets = std::size_t (g.GetMaxWeight()) + 1;
+    if (this->m_buckets.size() < numBuckets) {
+        this->m_buckets.resize (numBuckets);
+    }
+
+    std::sort (this->m_seeds.begin(), this->m_seeds.end());
+    std::vector<std::pair<distance_t, vertex_t> >::const_iterator
+        sit  (this->m_seeds.begin()),
+        send (this->m_seeds.end());
+    std::size_t numQueued = 0;
+    const bool stopEarly = (this->m_numTargets > 0);
+    this->m_isComplete = true;
+
+    for (distance_t d = (sit == send) ? 0 : sit->first; numQueued > 0 || sit != send; ++d) {
+        std::vector<vertex_t> & bucket = this->m_buckets[d % numBuckets];
+
+        if (numQueued == 0 && sit->first > d) {
+            d = sit->first - 1;
+            continue;
+        }
+
+        for (; sit != send && sit->first == d; ++sit) {
+            bucket.push_back (sit->second);
+            ++numQueued;
+        }
+
+        // Relaxing a 0-weight arc may push a vertex in the current bucket,
+        // so the bucket is consumed as a stack.
+        while (!bucket.empty()) {
+            vertex_t u = bucket.back();
+            bucket.pop_back();
+            --numQueued;
+
+            // Lazy deletion: u has been pushed again with a lower distance.
+            if (this->m_distances[u] != d) continue;
+
+            if (stopEarly && this->m_isTarget[u]) {
+                this->m_isTarget[u] = false;
+                if (--this->m_numTargets == 0) {
+                    this->m_isComplete = false;
+                }
+            }
+
+            for (OspfCsrGraph::arc_t a = g.GetOutBegin (u), end = g.GetOutEnd (u); a != end; ++a) {
+                vertex_t v = g.GetTarget (a);
+                distance_t dv = d + g.GetWeight (a);
+
+                if (this->Relax (g, u, v, dv)) {
+                    this->m_buckets[dv % numBuckets].push_back (v);
+                    ++numQueued;
+                }
+            }
+        }
+
+        if (!this->m_isComplete) break;
+    }
+
+    // Flush the vertices still queued if the search has been stopped.
+    if (!this->m_isComplete) {
+        for (std::size_t i = 0; i < numBuckets; ++i) {
+            this->m_buckets[i].clear();
+        }
+    }
+
+    this->m_seeds.clear();
+}
+
+void OspfSpf::PropagateHeap (const OspfCsrGraph & g) {
+    // Same invariants as PropagateDial: the heap pops the entries by
+    // increasing (distance, vertex), a vertex whose label is improved is
+    // pushed again, and the stale entries are skipped. The labels at
+    // distance d are final once every entry at distance d has been popped,
+    // so the search stops at the first entry beyond the distance of the
+    // last target (if any).
+    typedef std::pair<distance_t, vertex_t> entry_t;
+    const std::greater<entry_t> cmp;
+
+    this->m_heap.assign (this->m_seeds.begin(), this->m_seeds.end());
+    std::make_heap (this->m_heap.begin(), this->m_heap.end(), cmp);
+    const bool stopEarly = (this->m_numTargets > 0);
+    distance_t dStop = INFINITE_DISTANCE;
+    this->m_isComplete = true;
+
+    while (!this->m_heap.empty()) {
+        std::pop_heap (this->m_heap.begin(), this->m_heap.end(), cmp);
+        entry_t entry = this->m_heap.back();
+        this->m_heap.pop_back();
+
+        distance_t d = entry.first;
+        vertex_t u = entry.second;
+        if (!this->m_isComplete && d > dStop) break;
+
+        // Lazy deletion: u has been pushed again with a lower distance.
+        if (this->m_distances[u] != d) continue;
+
+        if (stopEarly && this->m_isTarget[u]) {
+            this->m_isTarget[u] = false;
+            if (--this->m_numTargets == 0) {
+                this->m_isComplete = false;
+                dStop = d;
+            }
+        }
+
+        for (OspfCsrGraph::arc_t a = g.GetOutBegin (u), end = g.GetOutEnd (u); a != end; ++a) {
+            vertex_t v = g.GetTarget (a);
+            distance_t dv = d + g.GetWeight (a);
+
+            if (this->Relax (g, u, v, dv)) {
+                this->m_heap.push_back (entry_t (dv, v));
+                std::push_heap (this->m_heap.begin(), this->m_heap.end(), cmp);
+            }
+        }
+    }
+
+    this->m_heap.clear();
+    this->m_seeds.clear();
+}
+
+OspfSpf::vertex_t OspfSpf::GetSource() const {
+    return this->m_source;
+}
+
+bool OspfSpf::IsComplete() const {
+    return this->m_isComplete;
+}
+
+} // namespace ospf
+} // namespace ns3
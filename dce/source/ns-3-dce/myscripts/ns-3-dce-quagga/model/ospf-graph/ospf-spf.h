@@ -0,0 +1,441 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob, Alexandre Morignot
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Authors:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ *   Alexandre Morignot <alexandre.morignot@orange.fr>
+ */
+
+#ifndef OSPF_SPF_H
+#define OSPF_SPF_H
+
+#include <cstddef>                          // std::size_t
+#include <cstdint>                          // uint*_t
+#include <utility>                          // std::pair
+#include <vector>                           // std::vector
+
+#include "ns3/ospf-graph.h"                 // ns3::ospf::OspfGraph
+#include "ns3/ospf-packet.h"                // ns3::ospf::router_id_t
+
+namespace ns3 {
+namespace ospf {
+
+/**
+ * @class OspfCsrGraph
+ * @brief Read-only snapshot of an OspfGraph stored in the compressed sparse
+ *   row (CSR) format.
+ *
+ * The out-arcs of each vertex are stored contiguously, and each arc only
+ * carries its target and its weight, which is the lowest OSPF metric
+ * installed on the corresponding OspfEdge. This avoids to browse the
+ * std::map nested in each OspfEdge at each relaxation of the SPF.
+ *
+ * The in-arcs of each vertex are also stored (reverse CSR), so that the
+ * shortest path trees can be repaired incrementally (see OspfSpf::Update).
+ *
+ * Since OspfGraph stores its vertices in a boost::vecS, the vertex
+ * descriptors of the OspfGraph and the vertex indices of the snapshot
+ * are the same.
+ */
+
+class OspfCsrGraph
+{
+public:
+    typedef uint32_t vertex_t;  /**< Index of a vertex (== OspfGraph vertex descriptor). */
+    typedef uint32_t arc_t;     /**< Index of an arc. */
+    typedef uint32_t weight_t;  /**< 16-bit Router LSA metrics, 24-bit Summary LSA metrics. */
+
+    static const vertex_t NULL_VERTEX;  /**< Dummy vertex index (e.g. no predecessor). */
+    static const arc_t    NULL_ARC;     /**< Dummy arc index (e.g. arc not found). */
+
+private:
+    std::vector<arc_t>          m_offsets;      /**< Out-arcs of u are the arcs [m_offsets[u], m_offsets[u + 1]). */
+    std::vector<vertex_t>       m_targets;      /**< Target of each arc. */
+    std::vector<weight_t>       m_weights;      /**< Weight of each arc. */
+    std::vector<arc_t>          m_inOffsets;    /**< In-arcs of v are the in-arcs [m_inOffsets[v], m_inOffsets[v + 1]). */
+    std::vector<vertex_t>       m_sources;      /**< Source of each in-arc. */
+    std::vector<weight_t>       m_inWeights;    /**< Weight of each in-arc. */
+    std::vector<router_id_t>    m_routerIds;    /**< Router-id of each vertex. */
+    std::vector<uint8_t>        m_isNetwork;    /**< m_isNetwork[u] != 0 iif u represents a network. */
+    weight_t                    m_maxWeight;    /**< Highest weight of the snapshot. */
+
+public:
+
+    /**
+     * @brief Constructor.
+     */
+
+    OspfCsrGraph();
+
+    /**
+     * @brief (Re)build this snapshot from an OspfGraph. The nested
+     *   buffers are reused, so rebuilding does not allocate memory unless
+     *   the graph has grown.
+     * @param g The OspfGraph.
+     */
+
+    void Build(const OspfGraph & g);
+
+    /**
+     * @brief Retrieve the number of vertices of this snapshot.
+     * @return The number of vertices.
+     */
+
+    std::size_t GetNumVertices() const;
+
+    /**
+     * @brief Retrieve the number of arcs of this snapshot.
+     * @return The number of arcs.
+     */
+
+    std::size_t GetNumArcs() const;
+
+    /**
+     * @brief Retrieve the index of the first out-arc of a vertex.
+     * @param u A vertex.
+     * @return The index of the first out-arc of u.
+     */
+
+    inline arc_t GetOutBegin(vertex_t u) const {
+        return this->m_offsets[u];
+    }
+
+    /**
+     * @brief Retrieve the index following the last out-arc of a vertex.
+     * @param u A vertex.
+     * @return The index following the last out-arc of u.
+     */
+
+    inline arc_t GetOutEnd(vertex_t u) const {
+        return this->m_offsets[u + 1];
+    }
+
+    /**
+     * @brief Retrieve the target of an arc.
+     * @param a An arc index.
+     * @return The target vertex of a.
+     */
+
+    inline vertex_t GetTarget(arc_t a) const {
+        return this->m_targets[a];
+    }
+
+    /**
+     * @brief Retrieve the weight of an arc.
+     * @param a An arc index.
+     * @return The weight of a.
+     */
+
+    inline weight_t GetWeight(arc_t a) const {
+        return this->m_weights[a];
+    }
+
+    /**
+     * @brief Retrieve the index of the first in-arc of a vertex.
+     * @param v A vertex.
+     * @return The index of the first in-arc of v.
+     */
+
+    inline arc_t GetInBegin(vertex_t v) const {
+        return this->m_inOffsets[v];
+    }
+
+    /**
+     * @brief Retrieve the index following the last in-arc of a vertex.
+     * @param v A vertex.
+     * @return The index following the last in-arc of v.
+     */
+
+    inline arc_t GetInEnd(vertex_t v) const {
+        return this->m_inOffsets[v + 1];
+    }
+
+    /**
+     * @brief Retrieve the source of an in-arc.
+     * @param a An in-arc index.
+     * @return The source vertex of a.
+     */
+
+    inline vertex_t GetSource(arc_t a) const {
+        return this->m_sources[a];
+    }
+
+    /**
+     * @brief Retrieve the weight of an in-arc.
+     * @param a An in-arc index.
+     * @return The weight of a.
+     */
+
+    inline weight_t GetInWeight(arc_t a) const {
+        return this->m_inWeights[a];
+    }
+
+    /**
+     * @brief Search the arc (u, v).
+     * @param u The source vertex.
+     * @param v The target vertex.
+     * @return The index of the (out-)arc (u, v), NULL_ARC if not found.
+     */
+
+    arc_t FindArc(vertex_t u, vertex_t v) const;
+
+    /**
+     * @brief Retrieve the highest weight stored in this snapshot.
+     * @return The highest weight.
+     */
+
+    weight_t GetMaxWeight() const;
+
+    /**
+     * @brief Retrieve the router-id corresponding to a vertex.
+     * @param u A vertex.
+     * @return The corresponding router-id.
+     */
+
+    const router_id_t & GetRouterId(vertex_t u) const;
+
+    /**
+     * @brief Test whether a vertex represents a network (see OspfVertex).
+     * @param u A vertex.
+     * @return true iif u represents a network.
+     */
+
+    inline bool IsNetwork(vertex_t u) const {
+        return this->m_isNetwork[u] != 0;
+    }
+};
+
+/**
+ * @class OspfSpf
+ * @brief Shortest path tree computed over an OspfCsrGraph.
+ *
+ * The Dijkstra's algorithm relies on a bucket queue (Dial's algorithm):
+ * since the arc weights are bounded by C = OspfCsrGraph::GetMaxWeight(),
+ * the tentative distances of the vertices in the queue are always in
+ * [d, d + C], where d is the current distance. A circular array of C + 1
+ * buckets is thus sufficient. The arcs installed from the Summary LSAs
+ * carry 24-bit metrics: if C exceeds MAX_DIAL_WEIGHT, a binary heap is
+ * used instead, so that the buckets stay small. Distances and
+ * predecessors are stored in vectors indexed by the vertices. All the
+ * buffers are reused from one computation to another.
+ *
+ * Each vertex is also labeled by its first hop, i.e. the vertex following
+ * the source along its shortest path. The label is propagated with the
+ * distances, so it can be queried in O(1) instead of walking along the
+ * predecessors. If several shortest paths exist (ECMP), the first hop
+ * having the lowest router-id is kept: the labels (distance, router-id of
+ * the first hop) are compared in lexicographic order, which is compatible
+ * with the Dijkstra's algorithm. The first hops do thus not depend on the
+ * order of the vertices, nor on the history of the incremental updates;
+ * they only change when the set of shortest paths changes.
+ *
+ * A network is never a first hop of a router: a network attached to the
+ * source is labeled by itself, and the routers reached through it are
+ * labeled by themselves, like if they were directly attached to the
+ * source (RFC 2328, 16.1.1).
+ *
+ * The search may be stopped as soon as a given set of target vertices is
+ * settled. The resulting tree is then incomplete: only the targets and the
+ * vertices settled before them are meaningful.
+ *
+ * Once computed, the tree can be repaired after some arcs have been added,
+ * removed or reweighted (Ramalingam & Reps): only the vertices hanging
+ * below an arc whose weight has increased are recomputed, and only the
+ * vertices whose distance decreases are visited from the arcs whose
+ * weight has decreased.
+ */
+
+class OspfSpf
+{
+public:
+    typedef OspfCsrGraph::vertex_t          vertex_t;
+    typedef uint32_t                        distance_t;
+    typedef std::pair<vertex_t, vertex_t>   Arc;    /**< (source, target) */
+
+    static const distance_t INFINITE_DISTANCE;  /**< Distance of an unreachable vertex. */
+    static const OspfCsrGraph::weight_t MAX_DIAL_WEIGHT; /**< Highest weight handled by the bucket queue. */
+
+private:
+    vertex_t                            m_source;       /**< Root of the shortest path tree. */
+    std::vector<distance_t>             m_distances;    /**< Distance from the source to each vertex. */
+    std::vector<vertex_t>               m_predecessors; /**< Predecessor of each vertex in the shortest path tree. */
+    std::vector<vertex_t>               m_firstHops;    /**< First hop from the source toward each vertex. */
+    std::vector<bool>                   m_isTarget;     /**< m_isTarget[v] == true iif v is a target not yet settled. */
+    std::size_t                         m_numTargets;   /**< Number of targets not yet settled (0: no early stop). */
+    bool                                m_isComplete;   /**< false iif the last search has been stopped early. */
+    std::vector<std::vector<vertex_t> > m_buckets;      /**< Bucket queue (circular). */
+    std::vector<std::pair<distance_t, vertex_t> > m_heap;  /**< Binary heap (min-heap), used if the bucket queue would be too large. */
+    std::vector<std::pair<distance_t, vertex_t> > m_seeds; /**< Vertices from which the distances are propagated. */
+    std::vector<vertex_t>               m_affected;     /**< Vertices whose distance must be recomputed (Update). */
+    std::vector<bool>                   m_isAffected;   /**< m_isAffected[v] == true iif v is in m_affected. */
+
+    /**
+     * @brief Run the Dijkstra's algorithm from m_seeds. The distance and
+     *   the predecessor of each seed must already be set.
+     * @param g The OspfCsrGraph.
+     */
+
+    void Propagate(const OspfCsrGraph & g);
+
+    /**
+     * @brief Run the Dial's algorithm from m_seeds (see Propagate).
+     * @param g The OspfCsrGraph. Its weights must not exceed MAX_DIAL_WEIGHT.
+     */
+
+    void PropagateDial(const OspfCsrGraph & g);
+
+    /**
+     * @brief Run the Dijkstra's algorithm from m_seeds using a binary heap
+     *   (see Propagate).
+     * @param g The OspfCsrGraph.
+     */
+
+    void PropagateHeap(const OspfCsrGraph & g);
+
+    /**
+     * @brief Relax an arc (u, v): v is attached to u if it improves its
+     *   label (distance, router-id of the first hop), compared in
+     *   lexicographic order.
+     * @param g The OspfCsrGraph.
+     * @param u The source of the arc (already reached).
+     * @param v The target of the arc.
+     * @param dv The distance of v through u.
+     * @return true iif the label of v has been improved.
+     */
+
+    inline bool Relax(const OspfCsrGraph & g, vertex_t u, vertex_t v, distance_t dv) {
+        if (dv > this->m_distances[v]) return false;
+
+        vertex_t firstHop = (u == this->m_source || (g.IsNetwork (u) && this->m_firstHops[u] == u)) ?
+            v : this->m_firstHops[u];
+
+        // Equal cost paths: keep the first hop having the lowest router-id.
+        if (dv == this->m_distances[v]) {
+            if (v == this->m_source) return false;
+            if (!(g.GetRouterId (firstHop) < g.GetRouterId (this->m_firstHops[v]))) return false;
+        }
+
+        this->m_distances[v] = dv;
+        this->m_predecessors[v] = u;
+        this->m_firstHops[v] = firstHop;
+        return true;
+    }
+
+public:
+
+    /**
+     * @brief Constructor.
+     */
+
+    OspfSpf();
+
+    /**
+     * @brief Compute the shortest path tree rooted in a given vertex.
+     * @param g The OspfCsrGraph.
+     * @param source The root of the shortest path tree.
+     */
+
+    void Compute(const OspfCsrGraph & g, vertex_t source);
+
+    /**
+     * @brief Compute the shortest path tree rooted in a given vertex, and
+     *   stop as soon as the shortest path toward each target is known.
+     * @param g The OspfCsrGraph.
+     * @param source The root of the shortest path tree.
+     * @param targets The vertices of interest.
+     */
+
+    void Compute(const OspfCsrGraph & g, vertex_t source, const std::vector<vertex_t> & targets);
+
+    /**
+     * @brief Repair the shortest path tree previously computed by Compute()
+     *   once some arcs of the graph have been altered. The resulting
+     *   distances are the same as the ones computed by Compute(); the
+     *   predecessors may differ in case of equal cost paths, but not the
+     *   first hops.
+     *   The previous tree must be complete (see IsComplete()).
+     * @param g The OspfCsrGraph, rebuilt after the alteration. It may
+     *   have more vertices than the previous one.
+     * @param arcs The arcs added, removed or whose weight has changed.
+     */
+
+    void Update(const OspfCsrGraph & g, const std::vector<Arc> & arcs);
+
+    /**
+     * @brief Retrieve the root of the last computed shortest path tree.
+     * @return The source vertex.
+     */
+
+    vertex_t GetSource() const;
+
+    /**
+     * @brief Test whether the last computed shortest path tree spans every
+     *   vertex reachable from the source.
+     * @return false iif the search has been stopped once its targets were
+     *   settled.
+     */
+
+    bool IsComplete() const;
+
+    /**
+     * @brief Retrieve the distance from the source to a vertex.
+     * @param v A vertex.
+     * @return The distance (INFINITE_DISTANCE if v is unreachable).
+     */
+
+    inline distance_t GetDistance(vertex_t v) const {
+        return this->m_distances[v];
+    }
+
+    /**
+     * @brief Retrieve the predecessor of a vertex in the shortest path tree.
+     * @param v A vertex.
+     * @return The predecessor of v, OspfCsrGraph::NULL_VERTEX if v is the
+     *   source or is unreachable.
+     */
+
+    inline vertex_t GetPredecessor(vertex_t v) const {
+        return this->m_predecessors[v];
+    }
+
+    /**
+     * @brief Test whether a vertex is reachable from the source.
+     * @param v A vertex.
+     * @return true iif v is reachable.
+     */
+
+    inline bool IsReachable(vertex_t v) const {
+        return this->m_distances[v] != INFINITE_DISTANCE;
+    }
+
+    /**
+     * @brief Retrieve the first hop from the source toward a vertex, i.e.
+     *   the child of the source which is an ancestor of this vertex.
+     * @param v A vertex.
+     * @return The first hop toward v, OspfCsrGraph::NULL_VERTEX if v is the
+     *   source or is unreachable.
+     */
+
+    inline vertex_t GetFirstHop(vertex_t v) const {
+        return this->m_firstHops[v];
+    }
+};
+
+} // namespace ospf
+} // namespace ns3
+
+#endif // OSPF_SPF_H
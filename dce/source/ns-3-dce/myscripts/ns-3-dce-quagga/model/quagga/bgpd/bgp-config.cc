@@ -131,6 +131,14 @@ namespace ns3 {
         return ret;
     }
 
+    void BgpConfig::GetExternalNeighbors ( std::set<Ipv4Address> & neighbors ) const {
+        for ( NeighborsV4::const_iterator it = this->m_neighborsV4.begin(); it != this->m_neighborsV4.end(); ++it ) {
+            if ( it->second.GetRemoteAs() != this->m_asn ) {
+                neighbors.insert ( it->first );
+            }
+        }
+    }
+
     // FOR BACKWARD COMPATIBILITY
     void BgpConfig::AddNetwork ( const std::string& prefix ) {
         NS_LOG_WARN ( "OBSOLETE: AddNetwork()" );
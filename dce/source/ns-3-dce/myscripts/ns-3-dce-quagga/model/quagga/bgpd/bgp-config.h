@@ -176,6 +176,15 @@ public:
 
     BgpNeighbor & GetNeighbor ( const Address & address );
 
+    /**
+     * \brief Retrieve the IPv4 neighbors of this BGP router belonging to
+     *    another AS (eBGP).
+     * \param neighbors The set where the IP addresses of the eBGP neighbors
+     *    are inserted.
+     */
+
+    void GetExternalNeighbors ( std::set<Ipv4Address> & neighbors ) const;
+
     /**
      * \brief Configure a BGP network announcement on this router.
      * \param prefix The IPv4 prefix describing the target destinations.
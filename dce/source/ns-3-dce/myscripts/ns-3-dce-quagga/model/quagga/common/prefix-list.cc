@@ -111,7 +111,7 @@ namespace ns3 {
 
         // seq
         if ( this->GetSeq() ) {
-            out << " seq" << this->GetSeq();
+            out << " seq " << this->GetSeq();
         }
 
         // permit|deny
@@ -138,10 +138,10 @@ namespace ns3 {
         // le / ge
         switch ( this->GetOperator() ) {
             case LE:
-                out << " le" << this->GetPrefixLength();
+                out << " le " << static_cast<uint32_t> (this->GetPrefixLength());
                 break;
             case GE:
-                out << " ge" << this->GetPrefixLength();
+                out << " ge " << static_cast<uint32_t> (this->GetPrefixLength());
                 break;
             case EQ:
                 break;
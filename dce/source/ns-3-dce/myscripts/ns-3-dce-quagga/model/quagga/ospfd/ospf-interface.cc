@@ -27,13 +27,18 @@ NS_LOG_COMPONENT_DEFINE ( "OspfInterface" );
 
 namespace ns3 {
 
-OspfInterface::OspfInterface() {}
+OspfInterface::OspfInterface() :
+    m_networkType ( OSPF_NETWORK_DEFAULT )
+{}
 
 OspfInterface::OspfInterface ( const std::string& name, uint16_t cost ) :
     m_name ( name ),
     m_cost ( cost ),
     m_helloInterval ( 2 ),
-    m_deadInterval ( 6 )
+    m_deadInterval ( 6 ),
+    m_retransmitInterval ( 0 ),
+    m_transmitDelay ( 0 ),
+    m_networkType ( OSPF_NETWORK_DEFAULT )
 {}
 
 const std::string& OspfInterface::GetName() const {
@@ -80,10 +85,35 @@ void OspfInterface::SetRetransmitInterval(uint16_t interval) {
     this->m_retransmitInterval = interval;
 }
 
+OspfNetworkType OspfInterface::GetNetworkType() const {
+    return this->m_networkType;
+}
+
+void OspfInterface::SetNetworkType ( OspfNetworkType networkType ) {
+    this->m_networkType = networkType;
+}
+
 void OspfInterface::Print (std::ostream& os) const {
     std::string s ( "  ip ospf " );
     os << "interface " << this->GetName() << std::endl;
 
+    switch ( this->GetNetworkType() ) {
+        case OSPF_NETWORK_BROADCAST:
+            os << s << "network broadcast" << std::endl;
+            break;
+        case OSPF_NETWORK_NON_BROADCAST:
+            os << s << "network non-broadcast" << std::endl;
+            break;
+        case OSPF_NETWORK_POINT_TO_MULTIPOINT:
+            os << s << "network point-to-multipoint" << std::endl;
+            break;
+        case OSPF_NETWORK_POINT_TO_POINT:
+            os << s << "network point-to-point" << std::endl;
+            break;
+        default:
+            break;
+    }
+
     if ( uint16_t t = this->GetTransmitDelay()) {
         os << s << "transmit-delay " << t << std::endl;
     }
@@ -31,6 +31,18 @@ namespace ns3
 
 typedef uint16_t OspfCost;
 
+/**
+ * @brief OSPF network type of an interface (see "ip ospf network").
+ */
+
+typedef enum {
+    OSPF_NETWORK_DEFAULT = 0,           /**< Deduced by ospfd from the interface (broadcast for the ns-3 devices). */
+    OSPF_NETWORK_BROADCAST,             /**< Broadcast network, with DR/BDR election. */
+    OSPF_NETWORK_NON_BROADCAST,         /**< NBMA network, with DR/BDR election. */
+    OSPF_NETWORK_POINT_TO_MULTIPOINT,   /**< Point-to-multipoint network. */
+    OSPF_NETWORK_POINT_TO_POINT         /**< Point-to-point link, without DR/BDR election. */
+} OspfNetworkType;
+
 class OspfInterface
 {
 private:
@@ -40,6 +52,7 @@ private:
     OspfCost    m_cost;                 /**< Ospf cost assigned to this interface. */
     uint16_t    m_retransmitInterval;   /**< Retransmit interval. <1-65535>, 0 means default value. */
     uint16_t    m_transmitDelay;        /**< Transmit delay. */
+    OspfNetworkType m_networkType;      /**< OSPF network type of this interface. */
 
 public:
 
@@ -134,6 +147,23 @@ public:
 
     void SetRetransmitInterval ( uint16_t interval );
 
+    /**
+     * @brief Accessor to the OSPF network type of this OspfInterface.
+     * @return The corresponding OspfNetworkType.
+     */
+
+    OspfNetworkType GetNetworkType() const;
+
+    /**
+     * @brief Set the OSPF network type of this OspfInterface. A link
+     *   connecting two routers should be configured as point-to-point: the
+     *   adjacency is then established without waiting for the DR/BDR
+     *   election (i.e. the dead interval).
+     * @param networkType The new OSPF network type.
+     */
+
+    void SetNetworkType ( OspfNetworkType networkType );
+
     /**
      * @brief Write this OspfInterface in an output stream.
      * @param os The output stream.
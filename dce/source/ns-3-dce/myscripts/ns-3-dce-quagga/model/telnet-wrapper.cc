@@ -131,6 +131,8 @@ Telnet::Telnet(
     this->m_tcpClient->SetRecvCallback(MakeCallback(&TelnetSimpleSink::HandleData, &(this->m_sink)));
 }
 
+Telnet::~Telnet() {}
+
 void Telnet::Close() {
     this->m_sink.Close();
 }
@@ -177,6 +177,12 @@ public:
         const Time & time
     );
 
+    /**
+     * @brief Destructor.
+     */
+
+    virtual ~Telnet();
+
     /**
      * @brief Retrieve the Address of the telnet server.
      * @return The Address of the telnet server.
@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+
+#include "vty-pipeline.h"
+
+#define IAC         uint8_t(0xff)       // Telnet "Interpret As Command"
+#define PASSWORD    "Password: "        // Prompt of the authentication
+
+#include "ns3/log.h"                    // NS_LOG_*
+#include "ns3/simulator.h"              // ns3::Simulator
+
+NS_LOG_COMPONENT_DEFINE ("VtyPipeline");
+
+namespace ns3 {
+
+// VtyCommand
+
+Time VtyCommand::GetLatency() const {
+    return this->completed - this->sent;
+}
+
+// VtyPipeline
+
+VtyPipeline::VtyPipeline(const std::string & outputFilename, size_t bufferSize):
+    TelnetSimpleSink(outputFilename, bufferSize),
+    m_isError(false),
+    m_isEcho(false),
+    m_numIacBytes(0)
+{
+    NS_LOG_FUNCTION (this);
+
+    // The greeting of the VTY is completed by the first prompt.
+    this->Push("");
+}
+
+VtyPipeline::~VtyPipeline() {
+    NS_LOG_FUNCTION (this);
+    if (this->m_pending.size()) {
+        NS_LOG_WARN (this->m_pending.size() << " command(s) not acknowledged");
+    }
+}
+
+void VtyPipeline::SetCompletionCallback(CompletionCallback completion) {
+    this->m_completion = completion;
+}
+
+void VtyPipeline::Push(const std::string & line) {
+    VtyCommand command;
+    command.line = line;
+    command.sent = Simulator::Now();
+    command.isError = false;
+    this->m_pending.push_back(command);
+}
+
+std::size_t VtyPipeline::GetNumPending() const {
+    return this->m_pending.size();
+}
+
+bool VtyPipeline::IsPrompt() const {
+    // hostname[(node)]# or hostname[(node)]> (a hostname has no space)
+    const std::string & line = this->m_line;
+    std::size_t n = line.size();
+
+    if (line == PASSWORD) return true;
+
+    return n >= 3
+        && line[n - 1] == ' '
+        && (line[n - 2] == '#' || line[n - 2] == '>')
+        && line.find(' ') == n - 1;
+}
+
+void VtyPipeline::HandleLine() {
+    if (this->m_isEcho) {
+        // The VTY echoes the command after the prompt.
+        this->m_isEcho = false;
+        return;
+    }
+
+    this->m_output += this->m_line + '\n';
+    if (this->m_line.size() && this->m_line[0] == '%') {
+        // e.g. "% Unknown command." or "% Command incomplete."
+        this->m_isError = true;
+    }
+}
+
+void VtyPipeline::HandlePrompt() {
+    this->m_isEcho = true;
+
+    if (this->m_pending.empty()) {
+        NS_LOG_WARN ("Unexpected prompt [" << this->m_line << "]");
+    } else {
+        VtyCommand command = this->m_pending.front();
+        this->m_pending.pop_front();
+        command.completed = Simulator::Now();
+        command.output = this->m_output;
+        command.isError = this->m_isError;
+
+        NS_LOG_LOGIC ("[" << command.line << "] acknowledged in " << command.GetLatency().GetSeconds() << "s");
+        if (!this->m_completion.IsNull()) {
+            this->m_completion(command);
+        }
+    }
+
+    this->m_output.clear();
+    this->m_isError = false;
+}
+
+void VtyPipeline::HandleBatch(uint8_t * buffer) {
+    TelnetSimpleSink::HandleBatch(buffer);
+
+    for (uint8_t * p = buffer; *p; ++p) {
+        uint8_t c = *p;
+
+        if (this->m_numIacBytes) {
+            // Option negotiated by the server, e.g. IAC WILL ECHO.
+            --this->m_numIacBytes;
+            continue;
+        }
+
+        switch (c) {
+            case IAC:
+                this->m_numIacBytes = 2;
+                break;
+            case '\r':
+                break;
+            case '\n':
+                this->HandleLine();
+                this->m_line.clear();
+                break;
+            default:
+                this->m_line.push_back(c);
+                if (c == ' ' && this->IsPrompt()) {
+                    this->HandlePrompt();
+                    this->m_line.clear();
+                }
+                break;
+        }
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,153 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+
+#ifndef VTY_PIPELINE_H
+#define VTY_PIPELINE_H
+
+#include <cstddef>                      // std::size_t
+#include <cstdint>                      // uint*_t
+#include <deque>                        // std::deque
+#include <string>                       // std::string
+
+#include "ns3/callback.h"               // ns3::Callback
+#include "ns3/nstime.h"                 // ns3::Time
+
+#include "telnet-wrapper.h"             // ns3::TelnetSimpleSink
+
+namespace ns3 {
+
+/**
+ * @brief A command sent to a Quagga VTY, and its acknowledgement.
+ */
+
+struct VtyCommand {
+    std::string line;       /**< The command, without its trailing newline. */
+    std::string output;     /**< What the VTY printed between its echo and the next prompt. */
+    Time        sent;       /**< When the command has been sent. */
+    Time        completed;  /**< When the next prompt has been received. */
+    bool        isError;    /**< true iif the VTY printed a "% ..." message. */
+
+    /**
+     * @brief Retrieve the time taken by the VTY to acknowledge the command.
+     * @return The latency.
+     */
+
+    Time GetLatency() const;
+};
+
+/**
+ * \class VtyPipeline
+ * @brief Telnet sink matching each command sent to a Quagga VTY with the
+ *    prompt acknowledging it.
+ *
+ * The VTY handles the commands in order, and prints a prompt
+ * ("hostname> ", "hostname(config)# ", "Password: "...) once the
+ * previous command is processed. Each prompt thus completes the oldest
+ * pending command. The first pending command is the greeting of the VTY,
+ * completed by the first prompt of the session. The response is still
+ * written in the output file, if any.
+ */
+
+class VtyPipeline :
+    public TelnetSimpleSink
+{
+public:
+    typedef Callback<void, const VtyCommand &> CompletionCallback;
+
+private:
+    std::deque<VtyCommand>  m_pending;      /**< Commands sent but not yet acknowledged. */
+    CompletionCallback      m_completion;   /**< Called back for each acknowledged command. */
+    std::string             m_line;         /**< Current (incomplete) line of the response. */
+    std::string             m_output;       /**< Output of the oldest pending command. */
+    bool                    m_isError;      /**< true iif m_output contains an error message. */
+    bool                    m_isEcho;       /**< true iif m_line is the echo of a command. */
+    uint8_t                 m_numIacBytes;  /**< Telnet negotiation bytes still to skip. */
+
+    /**
+     * @brief Test whether the current line is a prompt of the VTY.
+     * @return true iif it is a prompt.
+     */
+
+    bool IsPrompt() const;
+
+    /**
+     * @brief Handle a complete line of the response.
+     */
+
+    void HandleLine();
+
+    /**
+     * @brief Handle a prompt: complete the oldest pending command.
+     */
+
+    void HandlePrompt();
+
+public:
+
+    /**
+     * @brief Constructor.
+     * @param outputFilename The absolute path of the file where we write
+     *    the response. Pass an empty string to not write it.
+     * @param bufferSize Size of the nested buffer.
+     */
+
+    VtyPipeline(const std::string & outputFilename = "", size_t bufferSize = 200);
+
+    /**
+     * @brief Destructor.
+     */
+
+    virtual ~VtyPipeline();
+
+    /**
+     * @brief Set the function called back when a command is acknowledged.
+     * @param completion The callback.
+     */
+
+    void SetCompletionCallback(CompletionCallback completion);
+
+    /**
+     * @brief Register a command which has just been sent to the VTY.
+     * @param line The command (a single line).
+     */
+
+    void Push(const std::string & line);
+
+    /**
+     * @brief Retrieve the number of commands not acknowledged yet.
+     * @return The number of pending commands.
+     */
+
+    std::size_t GetNumPending() const;
+
+    /**
+     * @brief Function called back when a batch of response is handled.
+     * @param buffer The buffer containing the batch (null terminated) and
+     *    of size this->GetBufferSize().
+     */
+
+    void virtual HandleBatch(uint8_t * buffer);
+};
+
+} // namespace ns3
+
+#endif
@@ -0,0 +1,108 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+#include "ns3/worker-pool.h"
+
+namespace ns3 {
+
+WorkerPool::WorkerPool (std::size_t numThreads) :
+    m_task (NULL),
+    m_numTasks (0),
+    m_nextTask (0),
+    m_numBusy (0),
+    m_batch (0),
+    m_stop (false)
+{
+    for (std::size_t i = 1; i < numThreads; ++i) {
+        this->m_threads.push_back (std::thread (&WorkerPool::Work, this));
+    }
+}
+
+WorkerPool::~WorkerPool () {
+    {
+        std::lock_guard<std::mutex> lock (this->m_mutex);
+        this->m_stop = true;
+    }
+    this->m_cvStart.notify_all();
+
+    for (std::thread & thread : this->m_threads) {
+        thread.join();
+    }
+}
+
+std::size_t WorkerPool::GetNumThreads () const {
+    return this->m_threads.size() + 1;
+}
+
+void WorkerPool::RunTasks () {
+    for (std::size_t i = this->m_nextTask++; i < this->m_numTasks; i = this->m_nextTask++) {
+        (*this->m_task) (i);
+    }
+}
+
+void WorkerPool::Work () {
+    uint64_t batch = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock (this->m_mutex);
+            this->m_cvStart.wait (lock, [&] { return this->m_stop || this->m_batch != batch; });
+            if (this->m_stop) return;
+            batch = this->m_batch;
+        }
+
+        this->RunTasks();
+
+        {
+            std::lock_guard<std::mutex> lock (this->m_mutex);
+            if (--this->m_numBusy == 0) {
+                this->m_cvDone.notify_one();
+            }
+        }
+    }
+}
+
+void WorkerPool::Run (std::size_t numTasks, const WorkerPool::Task & task) {
+    if (this->m_threads.empty() || numTasks <= 1) {
+        for (std::size_t i = 0; i < numTasks; ++i) {
+            task (i);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock (this->m_mutex);
+        this->m_task = &task;
+        this->m_numTasks = numTasks;
+        this->m_nextTask = 0;
+        this->m_numBusy = this->m_threads.size();
+        ++this->m_batch;
+    }
+    this->m_cvStart.notify_all();
+
+    this->RunTasks();
+
+    std::unique_lock<std::mutex> lock (this->m_mutex);
+    this->m_cvDone.wait (lock, [&] { return this->m_numBusy == 0; });
+    this->m_task = NULL;
+}
+
+} // end namespace ns3
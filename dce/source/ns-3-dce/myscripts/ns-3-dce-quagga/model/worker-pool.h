@@ -0,0 +1,113 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <atomic>                       // std::atomic
+#include <condition_variable>           // std::condition_variable
+#include <cstddef>                      // std::size_t
+#include <cstdint>                      // uint*_t
+#include <functional>                   // std::function
+#include <mutex>                        // std::mutex
+#include <thread>                       // std::thread
+#include <vector>                       // std::vector
+
+namespace ns3 {
+
+/**
+ * @class WorkerPool
+ * @brief Fixed set of threads running batches of independent tasks.
+ *
+ * A batch is made of tasks identified by an index in [0, n). The calling
+ * thread takes part to the batch and Run() returns once every task is
+ * done, so the results can be stored in a vector indexed by the tasks and
+ * merged in a deterministic order.
+ *
+ * WARNING: the ns-3 simulator, its logging and its reference counting are
+ * not thread-safe. A task must only read shared immutable data and write
+ * its own results.
+ */
+
+class WorkerPool
+{
+public:
+    typedef std::function<void (std::size_t)> Task; /**< Run the i-th task of a batch. */
+
+private:
+    std::vector<std::thread>    m_threads;      /**< Worker threads (the caller of Run excluded). */
+    std::mutex                  m_mutex;        /**< Protects the members below. */
+    std::condition_variable     m_cvStart;      /**< Signals a new batch (or the shutdown) to the workers. */
+    std::condition_variable     m_cvDone;       /**< Signals the end of the batch to the caller of Run. */
+    const Task *                m_task;         /**< Task of the current batch. */
+    std::size_t                 m_numTasks;     /**< Number of tasks of the current batch. */
+    std::atomic<std::size_t>    m_nextTask;     /**< Index of the next task to run. */
+    std::size_t                 m_numBusy;      /**< Number of workers still running the current batch. */
+    uint64_t                    m_batch;        /**< Identifies the current batch. */
+    bool                        m_stop;         /**< Set to true to terminate the workers. */
+
+    /**
+     * @brief Run the tasks of the current batch until there is none left.
+     */
+
+    void RunTasks();
+
+    /**
+     * @brief Main loop of a worker thread.
+     */
+
+    void Work();
+
+public:
+
+    /**
+     * @brief Constructor.
+     * @param numThreads The number of threads running a batch, including
+     *   the caller of Run. 0 and 1 mean that tasks are run sequentially.
+     */
+
+    WorkerPool(std::size_t numThreads);
+
+    /**
+     * @brief Destructor. Terminate and join the worker threads.
+     */
+
+    ~WorkerPool();
+
+    /**
+     * @brief Retrieve the number of threads running a batch.
+     * @return The number of threads (including the caller of Run).
+     */
+
+    std::size_t GetNumThreads() const;
+
+    /**
+     * @brief Run a batch of tasks and wait for its completion.
+     * @param numTasks The number of tasks.
+     * @param task The function called for each task index in [0, numTasks).
+     */
+
+    void Run(std::size_t numTasks, const Task & task);
+};
+
+} // end namespace ns3
+
+#endif // WORKER_POOL_H
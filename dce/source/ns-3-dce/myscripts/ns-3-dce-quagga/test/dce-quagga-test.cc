@@ -0,0 +1,1876 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * Copyright (c) 2015 Marc-Olivier Buob
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author:
+ *   Marc-Olivier Buob  <marcolivier.buob@orange.fr>
+ */
+
+#include <algorithm>                        // std::min, std::shuffle
+#include <cstdint>                          // uint*_t
+#include <fstream>                          // std::ifstream
+#include <random>                           // std::mt19937
+#include <set>                              // std::set
+#include <sstream>                          // std::istringstream, std::ostringstream
+#include <string>                           // std::string
+#include <utility>                          // std::pair
+#include <vector>                           // std::vector
+
+#include "ns3/test.h"                       // ns3::TestCase, ns3::TestSuite
+#include "ns3/boolean.h"                    // ns3::BooleanValue
+#include "ns3/internet-stack-helper.h"      // ns3::InternetStackHelper
+#include "ns3/node.h"                       // ns3::Node
+#include "ns3/packet.h"                     // ns3::Packet
+#include "ns3/simulator.h"                  // ns3::Simulator
+#include "ns3/singleton.h"                  // ns3::Singleton
+#include "ns3/uinteger.h"                   // ns3::UintegerValue
+
+#include "ns3/bgp-config.h"                 // ns3::BgpConfig
+#include "ns3/bgp-config-channel.h"         // ns3::MemoryBgpConfigChannel, ns3::ReloadBgpConfigChannel
+#include "ns3/ibgp2d.h"                     // ns3::Ibgp2d
+#include "ns3/ipv4-prefix-aggregate.h"      // ns3::Ipv4PrefixAggregate
+#include "ns3/ospf-first-hop-cache.h"       // ns3::ospf::OspfFirstHopCache
+#include "ns3/ospf-graph.h"                 // ns3::ospf::OspfGraph
+#include "ns3/ospf-lsa-view.h"              // ns3::ospf::ParseOspfLsUpdate
+#include "ns3/ospf-lsdb.h"                  // ns3::ospf::OspfLsdb
+#include "ns3/ospf-packet.h"                // OSPF_*
+#include "ns3/ospf-spf.h"                   // ns3::ospf::OspfSpf
+#include "ns3/quagga-fs.h"                  // ns3::QuaggaFs
+#include "ns3/vty-pipeline.h"               // ns3::VtyPipeline
+#include "ns3/worker-pool.h"                // ns3::WorkerPool
+
+using namespace ns3;
+using namespace ns3::ospf;
+
+//----------------------------------------------------------------------------
+// Internal usage
+//----------------------------------------------------------------------------
+
+typedef OspfCsrGraph::vertex_t vertex_t;
+
+/**
+ * @brief Append a 16-bit integer (network byte order) to a buffer.
+ * @param bytes The buffer.
+ * @param x The integer.
+ */
+
+static void WriteUint16 (std::vector<uint8_t> & bytes, uint16_t x) {
+    bytes.push_back (x >> 8);
+    bytes.push_back (x & 0xff);
+}
+
+/**
+ * @brief Append a 32-bit integer (network byte order) to a buffer.
+ * @param bytes The buffer.
+ * @param x The integer.
+ */
+
+static void WriteUint32 (std::vector<uint8_t> & bytes, uint32_t x) {
+    WriteUint16 (bytes, x >> 16);
+    WriteUint16 (bytes, x & 0xffff);
+}
+
+/**
+ * @brief Append an LSA header to a buffer.
+ * @param bytes The buffer.
+ * @param type The LS type.
+ * @param linkStateId The link-state id.
+ * @param advertisingRouter The advertising router.
+ * @param sequenceNumber The LS sequence number.
+ * @param checksum The LS checksum.
+ * @param age The LS age.
+ * @param size The size of the LSA (header included).
+ */
+
+static void WriteLsaHeader (
+    std::vector<uint8_t> & bytes,
+    uint8_t type,
+    uint32_t linkStateId,
+    uint32_t advertisingRouter,
+    uint32_t sequenceNumber,
+    uint16_t checksum,
+    uint16_t age,
+    uint16_t size
+) {
+    WriteUint16 (bytes, age);
+    bytes.push_back (0);                    // options
+    bytes.push_back (type);
+    WriteUint32 (bytes, linkStateId);
+    WriteUint32 (bytes, advertisingRouter);
+    WriteUint32 (bytes, sequenceNumber);
+    WriteUint16 (bytes, checksum);
+    WriteUint16 (bytes, size);
+}
+
+/**
+ * @brief Build an LS-Update packet (area 0.0.0.0).
+ * @param linkHeaderSize The size of the link-layer header.
+ * @param lsas The LSAs carried by the packet.
+ * @param numLsas The number of LSAs.
+ * @return The bytes of the packet.
+ */
+
+static std::vector<uint8_t> MakeLsUpdate (
+    uint32_t linkHeaderSize,
+    const std::vector<uint8_t> & lsas,
+    uint32_t numLsas
+) {
+    std::vector<uint8_t> bytes (linkHeaderSize, 0);
+
+    // IPv4 header (20 bytes)
+    bytes.push_back (0x45);
+    bytes.resize (bytes.size() + 19, 0);
+    bytes[linkHeaderSize + 9] = 89;         // IPPROTO_OSPF
+
+    // OSPF header (24 bytes) + number of LSAs
+    const std::size_t ospfOffset = bytes.size();
+    bytes.push_back (2);                    // version
+    bytes.push_back (OSPF_TYPE_LS_UPDATE);
+    WriteUint16 (bytes, 28 + lsas.size());  // length
+    WriteUint32 (bytes, 0x01010101);        // router-id
+    WriteUint32 (bytes, 0);                 // area-id
+    bytes.resize (bytes.size() + 12, 0);    // checksum, authentication
+    WriteUint32 (bytes, numLsas);
+
+    bytes.insert (bytes.end(), lsas.begin(), lsas.end());
+    NS_ASSERT (bytes.size() == ospfOffset + 28 + lsas.size());
+    return bytes;
+}
+
+/**
+ * @brief Build an LS-Update packet carrying a Router LSA (two links, the
+ *   first one having a TOS metric), a Network LSA and an AS External LSA.
+ * @param linkHeaderSize The size of the link-layer header.
+ * @return The bytes of the packet.
+ */
+
+static std::vector<uint8_t> MakeSampleLsUpdate (uint32_t linkHeaderSize) {
+    std::vector<uint8_t> lsas;
+
+    // Router LSA
+    WriteLsaHeader (lsas, OSPF_LSA_TYPE_ROUTER, 9, 9, 0x80000005, 0x1234, 7, 24 + 16 + 12);
+    WriteUint16 (lsas, 0);                  // flags
+    WriteUint16 (lsas, 2);                  // number of links
+    WriteUint32 (lsas, 100);
+    WriteUint32 (lsas, 200);
+    lsas.push_back (OSPF_LSR_TYPE_TRANSIT);
+    lsas.push_back (1);                     // number of TOS
+    WriteUint16 (lsas, 10);
+    WriteUint32 (lsas, 0);                  // TOS metric
+    WriteUint32 (lsas, 101);
+    WriteUint32 (lsas, 201);
+    lsas.push_back (OSPF_LSR_TYPE_STUB);
+    lsas.push_back (0);
+    WriteUint16 (lsas, 20);
+
+    // Network LSA (one attached router)
+    WriteLsaHeader (lsas, OSPF_LSA_TYPE_NETWORK, 100, 9, 0x80000005, 0x1234, 7, 28);
+    WriteUint32 (lsas, 0xffffff00);
+    WriteUint32 (lsas, 9);
+
+    // AS External LSA (type 2)
+    WriteLsaHeader (lsas, OSPF_LSA_TYPE_EXTERNAL, 0x0a000000, 9, 0x80000005, 0x1234, 7, 36);
+    WriteUint32 (lsas, 0xff000000);
+    WriteUint32 (lsas, 0x80000123);
+    WriteUint32 (lsas, 0);                  // forwarding address
+    WriteUint32 (lsas, 0);                  // route tag
+
+    return MakeLsUpdate (linkHeaderSize, lsas, 3);
+}
+
+/**
+ * @brief Build a random OSPF graph. About a third of the arcs have a weight
+ *   in [0, 2], like the arcs leaving a network vertex, so that the graph
+ *   has many equal cost paths.
+ * @param g The graph (cleared).
+ * @param rng The random generator.
+ * @param numVertices The number of vertices.
+ * @param maxWeight The highest weight of the other arcs.
+ */
+
+static void MakeRandomGraph (OspfGraph & g, std::mt19937 & rng, uint32_t numVertices, uint32_t maxWeight) {
+    g.clear();
+
+    // The router-ids are shuffled, so that the tie-break on the first hops
+    // does not follow the order of the vertices.
+    std::vector<uint32_t> rids;
+    for (uint32_t i = 0; i < numVertices; ++i) {
+        rids.push_back (i + 1);
+    }
+    std::shuffle (rids.begin(), rids.end(), rng);
+
+    for (uint32_t i = 0; i < numVertices; ++i) {
+        boost::add_vertex (OspfVertex (router_id_t (rids[i])), g);
+    }
+
+    const uint32_t numArcs = rng() % (4 * numVertices);
+    for (uint32_t k = 0; k < numArcs; ++k) {
+        vertex_t u = rng() % numVertices, v = rng() % numVertices;
+        if (u == v || boost::edge (u, v, g).second) continue;
+
+        metric_t weight = (rng() % 3 == 0) ? rng() % 3 : 1 + rng() % maxWeight;
+        boost::add_edge (u, v, OspfEdge (Ipv4Address (k), Ipv4Address (k), weight), g);
+    }
+}
+
+/**
+ * @brief Build the LS-Updates flooded in the topologies of the Ibgp2d test
+ *   cases, where the routers are connected through transit networks.
+ */
+
+class LsUpdate
+{
+public:
+    /**
+     * @brief A link of a Router LSA toward a transit network.
+     */
+
+    struct Link {
+        const char * dr;        /**< Interface address of the DR (identifies the network). */
+        const char * ifAddress; /**< Interface address of the router on this network. */
+        uint16_t     metric;    /**< Metric of the link. */
+    };
+
+private:
+    std::vector<uint8_t> m_lsas;    /**< The LSAs added so far. */
+    uint32_t             m_numLsas; /**< The number of LSAs added so far. */
+
+public:
+    LsUpdate ();
+
+    /**
+     * @brief Add a Router LSA.
+     * @param routerId The advertising router.
+     * @param sequenceNumber The LS sequence number (1: first instance).
+     * @param links The links of the router.
+     */
+
+    void AddRouterLsa (const char * routerId, uint32_t sequenceNumber, const std::vector<Link> & links);
+
+    /**
+     * @brief Add a Network LSA.
+     * @param dr The interface address of the DR.
+     * @param mask The mask of the network.
+     * @param routerId The advertising router (the DR).
+     * @param sequenceNumber The LS sequence number (1: first instance).
+     */
+
+    void AddNetworkLsa (const char * dr, const char * mask, const char * routerId, uint32_t sequenceNumber);
+
+    /**
+     * @brief Add an AS External LSA.
+     * @param network The address of the external network.
+     * @param mask The mask of the external network.
+     * @param routerId The advertising router (the ASBR).
+     * @param sequenceNumber The LS sequence number (1: first instance).
+     * @param age The LS age (OSPF_LSA_MAX_AGE: flush the LSA).
+     */
+
+    void AddExternalLsa (const char * network, const char * mask, const char * routerId, uint32_t sequenceNumber, uint16_t age = 0);
+
+    /**
+     * @brief Build the LS-Update, as sniffed on a point-to-point device.
+     * @return The packet.
+     */
+
+    Ptr<Packet> Build () const;
+};
+
+LsUpdate::LsUpdate () :
+    m_numLsas (0)
+{}
+
+void LsUpdate::AddRouterLsa (const char * routerId, uint32_t sequenceNumber, const std::vector<Link> & links) {
+    const uint32_t rid = Ipv4Address (routerId).Get();
+    WriteLsaHeader (this->m_lsas, OSPF_LSA_TYPE_ROUTER, rid, rid, 0x80000000 + sequenceNumber, 0, 0, 24 + 12 * links.size());
+    WriteUint16 (this->m_lsas, 0);          // flags
+    WriteUint16 (this->m_lsas, links.size());
+
+    for (const Link & link : links) {
+        WriteUint32 (this->m_lsas, Ipv4Address (link.dr).Get());
+        WriteUint32 (this->m_lsas, Ipv4Address (link.ifAddress).Get());
+        this->m_lsas.push_back (OSPF_LSR_TYPE_TRANSIT);
+        this->m_lsas.push_back (0);         // number of TOS
+        WriteUint16 (this->m_lsas, link.metric);
+    }
+    ++this->m_numLsas;
+}
+
+void LsUpdate::AddNetworkLsa (const char * dr, const char * mask, const char * routerId, uint32_t sequenceNumber) {
+    const uint32_t rid = Ipv4Address (routerId).Get();
+    WriteLsaHeader (this->m_lsas, OSPF_LSA_TYPE_NETWORK, Ipv4Address (dr).Get(), rid, 0x80000000 + sequenceNumber, 0, 0, 28);
+    WriteUint32 (this->m_lsas, Ipv4Mask (mask).Get());
+    WriteUint32 (this->m_lsas, rid);        // attached router
+    ++this->m_numLsas;
+}
+
+void LsUpdate::AddExternalLsa (const char * network, const char * mask, const char * routerId, uint32_t sequenceNumber, uint16_t age) {
+    WriteLsaHeader (this->m_lsas, OSPF_LSA_TYPE_EXTERNAL, Ipv4Address (network).Get(), Ipv4Address (routerId).Get(), 0x80000000 + sequenceNumber, 0, age, 36);
+    WriteUint32 (this->m_lsas, Ipv4Mask (mask).Get());
+    WriteUint32 (this->m_lsas, 0x80000014); // type 2, metric 20
+    WriteUint32 (this->m_lsas, 0);          // forwarding address
+    WriteUint32 (this->m_lsas, 0);          // route tag
+    ++this->m_numLsas;
+}
+
+Ptr<Packet> LsUpdate::Build () const {
+    std::vector<uint8_t> bytes = MakeLsUpdate (OSPF_PPP_HEADER_SIZE, this->m_lsas, this->m_numLsas);
+    return Create<Packet> (&bytes[0], bytes.size());
+}
+
+//----------------------------------------------------------------------------
+// OspfSpfTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check the distances and the shortest path trees computed by
+ *   OspfSpf::Compute against a Bellman-Ford computation.
+ */
+
+class OspfSpfTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    OspfSpfTestCase ();
+};
+
+OspfSpfTestCase::OspfSpfTestCase () :
+    TestCase ("Check OspfSpf::Compute")
+{}
+
+void OspfSpfTestCase::DoRun () {
+    std::mt19937 rng (1);
+    OspfGraph g;
+    OspfCsrGraph csr;
+    OspfSpf spf;
+
+    for (uint32_t iteration = 0; iteration < 100; ++iteration) {
+        uint32_t numVertices = 2 + rng() % 30;
+        MakeRandomGraph (g, rng, numVertices, 50);
+        csr.Build (g);
+        NS_TEST_ASSERT_MSG_EQ (csr.GetNumArcs(), boost::num_edges (g), "Each arc must be stored once");
+
+        vertex_t s = rng() % numVertices;
+        spf.Compute (csr, s);
+
+        // Bellman-Ford over the out-arcs of the snapshot.
+        std::vector<OspfSpf::distance_t> distances (numVertices, OspfSpf::INFINITE_DISTANCE);
+        distances[s] = 0;
+        for (uint32_t k = 1; k < numVertices; ++k) {
+            for (vertex_t u = 0; u < numVertices; ++u) {
+                if (distances[u] == OspfSpf::INFINITE_DISTANCE) continue;
+                for (OspfCsrGraph::arc_t a = csr.GetOutBegin (u); a != csr.GetOutEnd (u); ++a) {
+                    vertex_t v = csr.GetTarget (a);
+                    distances[v] = std::min (distances[v], distances[u] + csr.GetWeight (a));
+                }
+            }
+        }
+
+        for (vertex_t v = 0; v < numVertices; ++v) {
+            NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (v), distances[v], "Wrong distance toward " << v);
+
+            // The predecessors form a shortest path tree.
+            vertex_t p = spf.GetPredecessor (v);
+            if (v == s || !spf.IsReachable (v)) {
+                NS_TEST_ASSERT_MSG_EQ (p, OspfCsrGraph::NULL_VERTEX, v << " has no predecessor");
+                continue;
+            }
+
+            OspfCsrGraph::arc_t a = csr.FindArc (p, v);
+            NS_TEST_ASSERT_MSG_NE (a, OspfCsrGraph::NULL_ARC, "The predecessor of " << v << " must be adjacent to it");
+            NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (p) + csr.GetWeight (a), distances[v], "The predecessor of " << v << " must lie on a shortest path");
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// OspfSpfUpdateTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that OspfSpf::Update repairs the shortest path trees as
+ *   OspfSpf::Compute would rebuild them.
+ */
+
+class OspfSpfUpdateTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+    /**
+     * @brief Alter random graphs and compare the repaired trees with the
+     *   recomputed ones.
+     * @param maxWeight The highest weight of the arcs (above 0xFFFF, the
+     *   bucket queue is replaced by a binary heap).
+     */
+
+    void CheckUpdate (uint32_t maxWeight);
+
+public:
+    OspfSpfUpdateTestCase ();
+};
+
+OspfSpfUpdateTestCase::OspfSpfUpdateTestCase () :
+    TestCase ("Check OspfSpf::Update against OspfSpf::Compute")
+{}
+
+void OspfSpfUpdateTestCase::DoRun () {
+    this->CheckUpdate (50);
+    this->CheckUpdate (0x100000);
+}
+
+void OspfSpfUpdateTestCase::CheckUpdate (uint32_t maxWeight) {
+    std::mt19937 rng (maxWeight);
+    OspfGraph g;
+    OspfCsrGraph csr;
+    OspfSpf repaired, computed;
+
+    for (uint32_t iteration = 0; iteration < 100; ++iteration) {
+        uint32_t numVertices = 2 + rng() % 30;
+        MakeRandomGraph (g, rng, numVertices, maxWeight);
+        csr.Build (g);
+
+        vertex_t s = rng() % numVertices;
+        repaired.Compute (csr, s);
+
+        for (uint32_t round = 0; round < 10; ++round) {
+            // Add, remove or reweight a few arcs.
+            std::set<OspfSpf::Arc> arcs;
+            for (uint32_t k = rng() % 5; k > 0; --k) {
+                vertex_t u = rng() % numVertices, v = rng() % numVertices;
+                if (u == v) continue;
+
+                metric_t weight = (rng() % 3 == 0) ? rng() % 3 : 1 + rng() % maxWeight;
+                std::pair<OspfGraph::edge_descriptor, bool> e = boost::edge (u, v, g);
+                if (!e.second) {
+                    boost::add_edge (u, v, OspfEdge (Ipv4Address (round), Ipv4Address (round), weight), g);
+                } else if (rng() % 3 == 0) {
+                    boost::remove_edge (u, v, g);
+                } else {
+                    g[e.first].SetMetric (g[e.first].GetNetwork(), weight);
+                }
+                arcs.insert (OspfSpf::Arc (u, v));
+            }
+
+            csr.Build (g);
+            repaired.Update (csr, std::vector<OspfSpf::Arc> (arcs.begin(), arcs.end()));
+            computed.Compute (csr, s);
+
+            for (vertex_t v = 0; v < numVertices; ++v) {
+                NS_TEST_ASSERT_MSG_EQ (repaired.GetDistance (v), computed.GetDistance (v), "Update and Compute disagree on the distance of " << v);
+                NS_TEST_ASSERT_MSG_EQ (repaired.GetFirstHop (v), computed.GetFirstHop (v), "Update and Compute disagree on the first hop of " << v);
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// OspfSpfTargetsTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check the first hops labeled by OspfSpf, and that stopping the
+ *   search once some targets are settled does not alter their labels.
+ */
+
+class OspfSpfTargetsTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+    /**
+     * @brief Check the first hops of the routers reached through a transit
+     *   network attached to the source.
+     */
+
+    void CheckFirstHops ();
+
+    /**
+     * @brief Compare the labels of some targets computed with and without
+     *   early stop on random graphs.
+     */
+
+    void CheckTargets ();
+
+public:
+    OspfSpfTargetsTestCase ();
+};
+
+OspfSpfTargetsTestCase::OspfSpfTargetsTestCase () :
+    TestCase ("Check the first hops and the early stop of OspfSpf")
+{}
+
+void OspfSpfTargetsTestCase::DoRun () {
+    this->CheckFirstHops();
+    this->CheckTargets();
+}
+
+void OspfSpfTargetsTestCase::CheckFirstHops () {
+    // s reaches t through a, and x through a transit network n and r.
+    OspfGraph g;
+    vertex_t s = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.1")), g);
+    vertex_t a = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.2")), g);
+    vertex_t t = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.3")), g);
+    vertex_t n = boost::add_vertex (OspfVertex (router_id_t ("10.0.1.1"), true), g);
+    vertex_t r = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.5")), g);
+    vertex_t x = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.6")), g);
+
+    boost::add_edge (s, a, OspfEdge (Ipv4Address ("10.0.0.2"), Ipv4Address ("10.0.0.1"), 1), g);
+    boost::add_edge (a, t, OspfEdge (Ipv4Address ("10.0.0.3"), Ipv4Address ("10.0.0.2"), 1), g);
+    boost::add_edge (s, n, OspfEdge (Ipv4Address ("10.0.1.1"), Ipv4Address ("10.0.1.1"), 1), g);
+    boost::add_edge (n, r, OspfEdge (Ipv4Address ("10.0.1.1"), Ipv4Address ("10.0.1.5"), 0), g);
+    boost::add_edge (r, x, OspfEdge (Ipv4Address ("10.0.0.6"), Ipv4Address ("10.0.0.5"), 1), g);
+
+    OspfCsrGraph csr;
+    csr.Build (g);
+    OspfSpf spf;
+    spf.Compute (csr, s);
+
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (s), OspfCsrGraph::NULL_VERTEX, "The source has no first hop");
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (a), a, "A neighbor of the source is its own first hop");
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (t), a, "The first hop is inherited from the predecessor");
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (n), n, "A network attached to the source is its own first hop");
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (r), r, "A router reached through an attached network is its own first hop");
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (x), r, "The first hop is inherited from the router behind the network");
+}
+
+void OspfSpfTargetsTestCase::CheckTargets () {
+    std::mt19937 rng (3);
+    OspfGraph g;
+    OspfCsrGraph csr;
+    OspfSpf computed, partial;
+
+    for (uint32_t iteration = 0; iteration < 1000; ++iteration) {
+        uint32_t numVertices = 2 + rng() % 30;
+        MakeRandomGraph (g, rng, numVertices, 50);
+        csr.Build (g);
+
+        vertex_t s = rng() % numVertices;
+        computed.Compute (csr, s);
+
+        std::vector<vertex_t> targets;
+        for (uint32_t k = 0; k < 3; ++k) {
+            targets.push_back (rng() % numVertices);
+        }
+        partial.Compute (csr, s, targets);
+
+        for (vertex_t t : targets) {
+            NS_TEST_ASSERT_MSG_EQ (partial.GetDistance (t), computed.GetDistance (t), "Early stop altered the distance of " << t);
+            NS_TEST_ASSERT_MSG_EQ (partial.GetFirstHop (t), computed.GetFirstHop (t), "Early stop altered the first hop of " << t);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// WorkerPoolTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that WorkerPool runs each task of a batch exactly once.
+ */
+
+class WorkerPoolTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    WorkerPoolTestCase ();
+};
+
+WorkerPoolTestCase::WorkerPoolTestCase () :
+    TestCase ("Check WorkerPool")
+{}
+
+void WorkerPoolTestCase::DoRun () {
+    WorkerPool pool (4);
+    NS_TEST_ASSERT_MSG_EQ (pool.GetNumThreads(), 4, "Wrong number of threads");
+
+    for (std::size_t numTasks = 0; numTasks < 64; ++numTasks) {
+        std::vector<uint32_t> results (numTasks, 0);
+        pool.Run (numTasks, [&results] (std::size_t i) { results[i] += i + 1; });
+
+        for (std::size_t i = 0; i < numTasks; ++i) {
+            NS_TEST_ASSERT_MSG_EQ (results[i], i + 1, "Task " << i << '/' << numTasks << " must run exactly once");
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+// OspfFirstHopCacheTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check OspfGraphSignature and the LRU eviction of
+ *   OspfFirstHopCache.
+ */
+
+class OspfFirstHopCacheTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+    /**
+     * @brief Compute the signature of a graph made of two routers.
+     * @param rid1 The router-id of the first vertex.
+     * @param rid2 The router-id of the second vertex.
+     * @param metric The metric of the arcs.
+     * @return The signature.
+     */
+
+    static OspfGraphSignature MakeSignature (const char * rid1, const char * rid2, metric_t metric);
+
+public:
+    OspfFirstHopCacheTestCase ();
+};
+
+OspfFirstHopCacheTestCase::OspfFirstHopCacheTestCase () :
+    TestCase ("Check OspfFirstHopCache")
+{}
+
+OspfGraphSignature OspfFirstHopCacheTestCase::MakeSignature (const char * rid1, const char * rid2, metric_t metric) {
+    OspfGraph g;
+    vertex_t u = boost::add_vertex (OspfVertex (router_id_t (rid1)), g);
+    vertex_t v = boost::add_vertex (OspfVertex (router_id_t (rid2)), g);
+    boost::add_edge (u, v, OspfEdge (Ipv4Address (rid2), Ipv4Address (rid1), metric), g);
+    boost::add_edge (v, u, OspfEdge (Ipv4Address (rid1), Ipv4Address (rid2), metric), g);
+
+    OspfCsrGraph csr;
+    csr.Build (g);
+    OspfGraphSignature signature;
+    signature.Build (csr, std::vector<vertex_t> (1, v));
+    return signature;
+}
+
+void OspfFirstHopCacheTestCase::DoRun () {
+    // The signature does not depend on the order of the vertices, but on
+    // the whole metrics (the Summary LSAs carry 24-bit metrics).
+    OspfGraphSignature s1 = MakeSignature ("10.0.0.1", "10.0.0.2", 1);
+    NS_TEST_ASSERT_MSG_EQ (s1 == MakeSignature ("10.0.0.2", "10.0.0.1", 1), false, "The ASBR differs");
+    NS_TEST_ASSERT_MSG_EQ (s1 == MakeSignature ("10.0.0.1", "10.0.0.2", 1), true, "Same LSDB content");
+    NS_TEST_ASSERT_MSG_EQ (MakeSignature ("10.0.0.1", "10.0.0.2", 0x10001) == MakeSignature ("10.0.0.1", "10.0.0.2", 0x20001), false, "The metrics above 0xFFFF must not be truncated");
+
+    OspfGraphSignature s2 = MakeSignature ("10.0.0.1", "10.0.0.2", 2);
+    OspfGraphSignature s3 = MakeSignature ("10.0.0.1", "10.0.0.2", 3);
+    const router_id_t v ("10.0.0.1");
+    OspfFirstHopCache::FirstHops firstHops;
+    firstHops.push_back (OspfFirstHopCache::FirstHop (router_id_t ("10.0.0.2"), router_id_t ("10.0.0.2")));
+
+    OspfFirstHopCache cache;
+    cache.SetCapacity (2);
+    NS_TEST_ASSERT_MSG_EQ (cache.Find (s1, v) == NULL, true, "The cache is empty");
+    cache.Insert (s1, v, firstHops);
+    cache.Insert (s2, v, firstHops);
+
+    // s1 is used again, so s2 is the least recently used signature.
+    const OspfFirstHopCache::FirstHops * found = cache.Find (s1, v);
+    NS_TEST_ASSERT_MSG_EQ (found != NULL, true, "s1 must be cached");
+    router_id_t firstHop;
+    NS_TEST_ASSERT_MSG_EQ (OspfFirstHopCache::GetFirstHop (*found, router_id_t ("10.0.0.2"), firstHop), true, "The target must be found");
+    NS_TEST_ASSERT_MSG_EQ (firstHop, router_id_t ("10.0.0.2"), "Wrong first hop");
+    NS_TEST_ASSERT_MSG_EQ (OspfFirstHopCache::GetFirstHop (*found, router_id_t ("10.0.0.3"), firstHop), false, "The target is unknown");
+
+    cache.Insert (s3, v, firstHops);
+    NS_TEST_ASSERT_MSG_EQ (cache.Find (s2, v) == NULL, true, "s2 must be evicted");
+    NS_TEST_ASSERT_MSG_EQ (cache.Find (s1, v) != NULL, true, "s1 must be kept");
+    NS_TEST_ASSERT_MSG_EQ (cache.Find (s3, v) != NULL, true, "s3 must be kept");
+    NS_TEST_ASSERT_MSG_EQ (cache.Find (s3, router_id_t ("10.0.0.2")) == NULL, true, "Only v has been inserted");
+    NS_TEST_ASSERT_MSG_EQ (cache.GetNumHits(), 3, "Wrong number of hits");
+    NS_TEST_ASSERT_MSG_EQ (cache.GetNumMisses(), 3, "Wrong number of misses");
+
+    // Shrinking the cache evicts the least recently used signatures.
+    cache.SetCapacity (1);
+    NS_TEST_ASSERT_MSG_EQ (cache.Find (s1, v) == NULL, true, "s1 must be evicted");
+    NS_TEST_ASSERT_MSG_EQ (cache.Find (s3, v) != NULL, true, "s3 must be kept");
+}
+
+//----------------------------------------------------------------------------
+// OspfSpfTieBreakTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that the equal cost first hops are broken on the lowest
+ *   router-id, whatever the order of the vertices and the history of the
+ *   updates.
+ */
+
+class OspfSpfTieBreakTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    OspfSpfTieBreakTestCase ();
+};
+
+OspfSpfTieBreakTestCase::OspfSpfTieBreakTestCase () :
+    TestCase ("Check the tie-break between equal cost first hops")
+{}
+
+void OspfSpfTieBreakTestCase::DoRun () {
+    // s reaches t through a (10.0.0.3) and b (10.0.0.2) at the same cost.
+    // a is discovered first, but b has the lowest router-id.
+    OspfGraph g;
+    vertex_t s = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.1")), g);
+    vertex_t a = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.3")), g);
+    vertex_t b = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.2")), g);
+    vertex_t t = boost::add_vertex (OspfVertex (router_id_t ("10.0.0.4")), g);
+
+    boost::add_edge (s, a, OspfEdge (Ipv4Address ("10.0.0.3"), Ipv4Address ("10.0.0.1"), 1), g);
+    boost::add_edge (a, t, OspfEdge (Ipv4Address ("10.0.0.4"), Ipv4Address ("10.0.0.3"), 1), g);
+    boost::add_edge (s, b, OspfEdge (Ipv4Address ("10.0.0.2"), Ipv4Address ("10.0.0.1"), 1), g);
+    boost::add_edge (b, t, OspfEdge (Ipv4Address ("10.0.0.4"), Ipv4Address ("10.0.0.2"), 1), g);
+
+    OspfCsrGraph csr;
+    csr.Build (g);
+    OspfSpf spf;
+    spf.Compute (csr, s);
+
+    NS_TEST_ASSERT_MSG_EQ (spf.GetDistance (t), 2, "Wrong distance toward t");
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (t), b, "The first hop having the lowest router-id must be kept");
+
+    // b becomes more expensive: t is then reached through a.
+    boost::remove_edge (s, b, g);
+    boost::add_edge (s, b, OspfEdge (Ipv4Address ("10.0.0.2"), Ipv4Address ("10.0.0.1"), 2), g);
+    csr.Build (g);
+    spf.Update (csr, std::vector<OspfSpf::Arc> (1, OspfSpf::Arc (s, b)));
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (t), a, "The first hop must follow the increase of the weight");
+
+    // Back to equal costs: b wins again, whatever the history.
+    boost::remove_edge (s, b, g);
+    boost::add_edge (s, b, OspfEdge (Ipv4Address ("10.0.0.2"), Ipv4Address ("10.0.0.1"), 1), g);
+    csr.Build (g);
+    spf.Update (csr, std::vector<OspfSpf::Arc> (1, OspfSpf::Arc (s, b)));
+    NS_TEST_ASSERT_MSG_EQ (spf.GetFirstHop (t), b, "The first hops must not depend on the updates");
+}
+
+//----------------------------------------------------------------------------
+// OspfLsdbTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check the comparison of the LSA instances (RFC 2328, section
+ *   13.1) and the outcome of OspfLsdb::Install.
+ */
+
+class OspfLsdbTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+    /**
+     * @brief Install an AS External LSA in an LSDB.
+     * @param lsdb The LSDB.
+     * @param sequenceNumber The LS sequence number.
+     * @param checksum The LS checksum.
+     * @param age The LS age.
+     * @param metric The metric (i.e. the content of the LSA).
+     * @param now The current time.
+     * @return The outcome of OspfLsdb::Install.
+     */
+
+    static OspfLsdb::Result Install (
+        OspfLsdb & lsdb,
+        uint32_t sequenceNumber,
+        uint16_t checksum,
+        uint16_t age,
+        uint32_t metric,
+        const Time & now
+    );
+
+public:
+    OspfLsdbTestCase ();
+};
+
+OspfLsdbTestCase::OspfLsdbTestCase () :
+    TestCase ("Check OspfLsdb::Install")
+{}
+
+OspfLsdb::Result OspfLsdbTestCase::Install (
+    OspfLsdb & lsdb,
+    uint32_t sequenceNumber,
+    uint16_t checksum,
+    uint16_t age,
+    uint32_t metric,
+    const Time & now
+) {
+    std::vector<uint8_t> bytes;
+    WriteLsaHeader (bytes, OSPF_LSA_TYPE_EXTERNAL, 0x0a000000, 9, sequenceNumber, checksum, age, 36);
+    WriteUint32 (bytes, 0xff000000);
+    WriteUint32 (bytes, metric);
+    WriteUint32 (bytes, 0);
+    WriteUint32 (bytes, 0);
+    return lsdb.Install (OspfLsaView (&bytes[0], bytes.size()), now);
+}
+
+void OspfLsdbTestCase::DoRun () {
+    OspfLsdb lsdb;
+
+    // Sequence numbers
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x80000002, 5, 0, 1, Seconds (0)), OspfLsdb::LSA_CHANGED, "A new LSA must be installed");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x80000002, 5, 0, 1, Seconds (1)), OspfLsdb::LSA_DISCARDED, "A duplicate must be discarded");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x80000001, 5, 0, 2, Seconds (1)), OspfLsdb::LSA_DISCARDED, "An older instance must be discarded");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 5, 0, 2, Seconds (1)), OspfLsdb::LSA_CHANGED, "The sequence numbers are signed");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x80000003, 5, 0, 2, Seconds (1)), OspfLsdb::LSA_DISCARDED, "The sequence numbers are signed");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 6, 0, 2, Seconds (2)), OspfLsdb::LSA_REFRESHED, "A refresh without change must be reported as such");
+
+    // Checksums
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 5, 0, 3, Seconds (2)), OspfLsdb::LSA_DISCARDED, "The lowest checksum is the oldest instance");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 7, 0, 3, Seconds (2)), OspfLsdb::LSA_CHANGED, "The highest checksum is the most recent instance");
+
+    // Ages: the youngest instance wins if the difference exceeds MaxAgeDiff.
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 7, OSPF_LSA_MAX_AGE_DIFF + 1, 3, Seconds (2)), OspfLsdb::LSA_DISCARDED, "An older instance must be discarded");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 7, 0, 3, Seconds (2 + OSPF_LSA_MAX_AGE_DIFF + 1)), OspfLsdb::LSA_REFRESHED, "A younger instance must be installed");
+
+    // MaxAge
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 7, OSPF_LSA_MAX_AGE, 3, Seconds (1000)), OspfLsdb::LSA_FLUSHED, "A MaxAge instance must flush the LSA");
+    NS_TEST_ASSERT_MSG_EQ (lsdb.GetSize(), 0, "A flushed LSA must be removed");
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x7fffffff, 7, OSPF_LSA_MAX_AGE, 3, Seconds (1000)), OspfLsdb::LSA_DISCARDED, "An unknown MaxAge LSA must be discarded");
+
+    // Expiration
+    NS_TEST_ASSERT_MSG_EQ (Install (lsdb, 0x80000001, 5, 100, 1, Seconds (1000)), OspfLsdb::LSA_CHANGED, "A new LSA must be installed");
+    std::vector<OspfLsdb::Key> keys;
+    lsdb.Expire (Seconds (1000 + OSPF_LSA_MAX_AGE - 101), keys);
+    NS_TEST_ASSERT_MSG_EQ (keys.size(), 0, "The LSA has not reached MaxAge yet");
+    lsdb.Expire (Seconds (1000 + OSPF_LSA_MAX_AGE - 100), keys);
+    NS_TEST_ASSERT_MSG_EQ (keys.size(), 1, "The LSA has reached MaxAge");
+    NS_TEST_ASSERT_MSG_EQ (lsdb.GetSize(), 0, "An expired LSA must be removed");
+}
+
+//----------------------------------------------------------------------------
+// OspfLsaViewTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that ParseOspfLsUpdate only builds views lying inside the
+ *   packet.
+ */
+
+class OspfLsaViewTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    OspfLsaViewTestCase ();
+};
+
+OspfLsaViewTestCase::OspfLsaViewTestCase () :
+    TestCase ("Check the bounds of the LSA views")
+{}
+
+void OspfLsaViewTestCase::DoRun () {
+    std::vector<OspfLsaView> lsas;
+
+    // Well-formed packets, sniffed on a PPP and on a CSMA device.
+    std::vector<uint8_t> bytes = MakeSampleLsUpdate (OSPF_PPP_HEADER_SIZE);
+    NS_TEST_ASSERT_MSG_EQ (ParseOspfLsUpdate (&bytes[0], bytes.size(), lsas), true, "The packet must be parsed");
+    NS_TEST_ASSERT_MSG_EQ (lsas.size(), 3, "The packet carries 3 LSAs");
+
+    std::vector<uint8_t> frame = MakeSampleLsUpdate (OSPF_ETHERNET_HEADER_SIZE);
+    NS_TEST_ASSERT_MSG_EQ (ParseOspfLsUpdate (&frame[0], frame.size(), lsas, OSPF_ETHERNET_HEADER_SIZE), true, "The frame must be parsed");
+    NS_TEST_ASSERT_MSG_EQ (lsas.size(), 3, "The frame carries 3 LSAs");
+
+    ParseOspfLsUpdate (&bytes[0], bytes.size(), lsas);
+    OspfRouterLsaView router (lsas[0]);
+    OspfRouterLsaView::LinkIterator it (router.GetLinks());
+    NS_TEST_ASSERT_MSG_EQ (it.GetLinkId(), Ipv4Address (100), "Wrong link id");
+    NS_TEST_ASSERT_MSG_EQ (it.GetMetric(), 10, "Wrong metric");
+    it.Next();
+    NS_TEST_ASSERT_MSG_EQ (it.GetLinkId(), Ipv4Address (101), "The TOS metrics must be skipped");
+    NS_TEST_ASSERT_MSG_EQ (it.GetMetric(), 20, "Wrong metric");
+    it.Next();
+    NS_TEST_ASSERT_MSG_EQ (it.IsEnd(), true, "The Router LSA has 2 links");
+    NS_TEST_ASSERT_MSG_EQ (OspfNetworkLsaView (lsas[1]).GetNumAttachedRouters(), 1, "The Network LSA has 1 attached router");
+    NS_TEST_ASSERT_MSG_EQ (OspfExternalLsaView (lsas[2]).GetMetric(), 0x123, "Wrong external metric");
+    NS_TEST_ASSERT_MSG_EQ (OspfExternalLsaView (lsas[2]).IsType2(), true, "Wrong external metric type");
+
+    // Truncated packets are rejected, and the views kept lie in the packet.
+    for (std::size_t size = 0; size < bytes.size(); ++size) {
+        std::vector<uint8_t> truncated (bytes.begin(), bytes.begin() + size);
+        truncated.reserve (1);
+        NS_TEST_ASSERT_MSG_EQ (ParseOspfLsUpdate (truncated.data(), size, lsas), false, "A packet truncated to " << size << " bytes must be rejected");
+        for (const OspfLsaView & lsa : lsas) {
+            NS_TEST_ASSERT_MSG_EQ (lsa.GetBody() + lsa.GetBodySize() <= truncated.data() + size, true, "A view exceeds the packet truncated to " << size << " bytes");
+        }
+    }
+
+    // A Router LSA announcing more links than it carries is rejected.
+    std::vector<uint8_t> tooManyLinks (bytes);
+    const std::size_t routerOffset = OSPF_PPP_HEADER_SIZE + 20 + 28;
+    tooManyLinks[routerOffset + 23] = 3;
+    NS_TEST_ASSERT_MSG_EQ (ParseOspfLsUpdate (&tooManyLinks[0], tooManyLinks.size(), lsas), false, "The links must fit in the Router LSA");
+    NS_TEST_ASSERT_MSG_EQ (lsas.size(), 0, "No LSA precedes the malformed one");
+
+    // An LSA shorter than its type specific fields is rejected.
+    std::vector<uint8_t> tooShort (bytes);
+    const std::size_t networkOffset = routerOffset + 24 + 16 + 12;
+    tooShort[networkOffset + 19] = 20;
+    NS_TEST_ASSERT_MSG_EQ (ParseOspfLsUpdate (&tooShort[0], tooShort.size(), lsas), false, "The LSA must hold its header");
+    NS_TEST_ASSERT_MSG_EQ (lsas.size(), 1, "The LSAs preceding the malformed one must be kept");
+
+    // More LSAs announced than carried.
+    std::vector<uint8_t> tooManyLsas (bytes);
+    tooManyLsas[routerOffset - 1] = 4;
+    NS_TEST_ASSERT_MSG_EQ (ParseOspfLsUpdate (&tooManyLsas[0], tooManyLsas.size(), lsas), false, "The LSAs must fit in the packet");
+    NS_TEST_ASSERT_MSG_EQ (lsas.size(), 3, "The LSAs carried must be kept");
+}
+
+//----------------------------------------------------------------------------
+// Ipv4PrefixAggregateTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check the covering set maintained by Ipv4PrefixAggregate and the
+ *   changes it reports.
+ */
+
+class Ipv4PrefixAggregateTestCase :
+    public TestCase
+{
+private:
+    virtual void DoRun ();
+
+    /**
+     * @brief Build a set of prefixes.
+     * @param prefixes The prefixes, separated by spaces.
+     * @return The corresponding set.
+     */
+
+    static std::set<Ipv4Prefix> MakeSet (const std::string & prefixes);
+
+public:
+    Ipv4PrefixAggregateTestCase ();
+};
+
+Ipv4PrefixAggregateTestCase::Ipv4PrefixAggregateTestCase () :
+    TestCase ("Check Ipv4PrefixAggregate")
+{}
+
+std::set<Ipv4Prefix> Ipv4PrefixAggregateTestCase::MakeSet (const std::string & prefixes) {
+    std::set<Ipv4Prefix> ret;
+    std::istringstream iss (prefixes);
+    std::string prefix;
+    while (iss >> prefix) {
+        ret.insert (Ipv4Prefix (prefix.c_str()));
+    }
+    return ret;
+}
+
+void Ipv4PrefixAggregateTestCase::DoRun () {
+    Ipv4PrefixAggregate aggregate;
+    std::set<Ipv4Prefix> added, removed, entries;
+
+    NS_TEST_ASSERT_MSG_EQ (aggregate.Add (Ipv4Prefix ("10.0.0.0/9"), added, removed), true, "The prefix is new");
+    NS_TEST_ASSERT_MSG_EQ (added == MakeSet ("10.0.0.0/9") && removed.empty(), true, "The prefix must enter the covering set");
+    NS_TEST_ASSERT_MSG_EQ (aggregate.Add (Ipv4Prefix ("10.0.0.0/9"), added, removed), false, "The prefix is already added");
+
+    // Two siblings are merged into their parent.
+    added.clear();
+    removed.clear();
+    aggregate.Add (Ipv4Prefix ("10.128.0.0/9"), added, removed);
+    NS_TEST_ASSERT_MSG_EQ (added == MakeSet ("10.0.0.0/8"), true, "The siblings must be merged");
+    NS_TEST_ASSERT_MSG_EQ (removed == MakeSet ("10.0.0.0/9"), true, "The merged sibling must leave the covering set");
+
+    // A prefix included in a covering prefix changes nothing.
+    added.clear();
+    removed.clear();
+    aggregate.Add (Ipv4Prefix ("10.1.0.0/16"), added, removed);
+    NS_TEST_ASSERT_MSG_EQ (added.empty() && removed.empty(), true, "An included prefix must not alter the covering set");
+
+    // Removing a sibling splits the parent, the included prefix is kept.
+    added.clear();
+    removed.clear();
+    aggregate.Remove (Ipv4Prefix ("10.0.0.0/9"), added, removed);
+    NS_TEST_ASSERT_MSG_EQ (added == MakeSet ("10.128.0.0/9 10.1.0.0/16"), true, "The parent must be split");
+    NS_TEST_ASSERT_MSG_EQ (removed == MakeSet ("10.0.0.0/8"), true, "The parent must leave the covering set");
+
+    // 0.0.0.0/0 collapses the covering set, and restores it once removed.
+    added.clear();
+    removed.clear();
+    aggregate.Add (Ipv4Prefix ("0.0.0.0/0"), added, removed);
+    aggregate.GetEntries (entries);
+    NS_TEST_ASSERT_MSG_EQ (entries == MakeSet ("0.0.0.0/0"), true, "The default route must cover everything");
+    NS_TEST_ASSERT_MSG_EQ (removed == MakeSet ("10.128.0.0/9 10.1.0.0/16"), true, "The covered entries must be removed");
+
+    added.clear();
+    removed.clear();
+    entries.clear();
+    aggregate.Remove (Ipv4Prefix ("0.0.0.0/0"), added, removed);
+    aggregate.GetEntries (entries);
+    NS_TEST_ASSERT_MSG_EQ (entries == MakeSet ("10.128.0.0/9 10.1.0.0/16"), true, "The covering set must be restored");
+    NS_TEST_ASSERT_MSG_EQ (added == entries && removed == MakeSet ("0.0.0.0/0"), true, "The restoration must be reported");
+    NS_TEST_ASSERT_MSG_EQ (aggregate.GetNumEntries(), 2, "Wrong number of entries");
+    NS_TEST_ASSERT_MSG_EQ (aggregate.GetNumPrefixes(), 2, "Wrong number of prefixes");
+}
+
+//----------------------------------------------------------------------------
+// BgpConfigChannelTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check MemoryBgpConfigChannel and ReloadBgpConfigChannel.
+ */
+
+class BgpConfigChannelTestCase :
+    public TestCase
+{
+private:
+    std::vector<VtyCommand> m_commands;   /**< Commands acknowledged so far. */
+    std::size_t             m_numReloads; /**< Number of reloads triggered so far. */
+
+    virtual void DoRun ();
+
+    /**
+     * @brief Check MemoryBgpConfigChannel.
+     */
+
+    void CheckMemory ();
+
+    /**
+     * @brief Check ReloadBgpConfigChannel.
+     */
+
+    void CheckReload ();
+
+    /**
+     * @brief Record an acknowledged command.
+     * @param command The command.
+     */
+
+    void HandleCommand (const VtyCommand & command);
+
+    /**
+     * @brief Record a reload.
+     * @param node The Node running bgpd.
+     */
+
+    void HandleReload (Ptr<Node> node);
+
+public:
+    BgpConfigChannelTestCase ();
+};
+
+BgpConfigChannelTestCase::BgpConfigChannelTestCase () :
+    TestCase ("Check the Memory and Reload BGP configuration channels"),
+    m_numReloads (0)
+{}
+
+void BgpConfigChannelTestCase::HandleCommand (const VtyCommand & command) {
+    this->m_commands.push_back (command);
+}
+
+void BgpConfigChannelTestCase::HandleReload (Ptr<Node> node) {
+    ++this->m_numReloads;
+}
+
+void BgpConfigChannelTestCase::DoRun () {
+    this->CheckMemory();
+    this->CheckReload();
+    Simulator::Destroy();
+}
+
+void BgpConfigChannelTestCase::CheckMemory () {
+    this->m_commands.clear();
+
+    MemoryBgpConfigChannel channel;
+    channel.SetCommandCallback (MakeCallback (&BgpConfigChannelTestCase::HandleCommand, this));
+    NS_TEST_ASSERT_MSG_EQ (channel.IsOpen(), false, "The channel is not open yet");
+    channel.Open (CreateObject<Node>());
+    NS_TEST_ASSERT_MSG_EQ (channel.IsOpen(), true, "The channel must be open");
+
+    channel.Configure ("ip prefix-list IBGP2-1 seq 1 permit 10.0.0.0/8 le 32\nexit\n");
+    channel.Execute ("clear ip bgp * soft out\n");
+    NS_TEST_ASSERT_MSG_EQ (channel.GetConfigured().size(), 1, "One batch configured");
+    NS_TEST_ASSERT_MSG_EQ (channel.GetConfigured()[0], "ip prefix-list IBGP2-1 seq 1 permit 10.0.0.0/8 le 32\nexit\n", "The batch must be stored as is");
+    NS_TEST_ASSERT_MSG_EQ (channel.GetExecuted().size(), 1, "One batch executed");
+
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands.size(), 3, "Each line must be acknowledged");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[0].line, "ip prefix-list IBGP2-1 seq 1 permit 10.0.0.0/8 le 32", "Wrong command");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[2].line, "clear ip bgp * soft out", "Wrong command");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[2].isError, false, "The commands are always accepted");
+
+    channel.Clear();
+    NS_TEST_ASSERT_MSG_EQ (channel.GetConfigured().size() + channel.GetExecuted().size(), 0, "The commands must be forgotten");
+    channel.Close();
+    NS_TEST_ASSERT_MSG_EQ (channel.IsOpen(), false, "The channel must be closed");
+}
+
+void BgpConfigChannelTestCase::CheckReload () {
+    this->m_commands.clear();
+    this->m_numReloads = 0;
+
+    Ptr<Node> node = CreateObject<Node>();
+    Ptr<BgpConfig> bgpConfig = CreateObject<BgpConfig>();
+    node->AggregateObject (bgpConfig);
+    bgpConfig->CreateDirectories (node);
+
+    ReloadBgpConfigChannel channel (MakeCallback (&BgpConfigChannelTestCase::HandleReload, this));
+    channel.SetCommandCallback (MakeCallback (&BgpConfigChannelTestCase::HandleCommand, this));
+    channel.Open (node);
+    channel.Configure ("ip prefix-list IBGP2-1 seq 1 permit 10.0.0.0/8 le 32\n");
+    channel.Configure ("no ip prefix-list IBGP2-1 seq 1 permit 10.0.0.0/8 le 32\n");
+
+    // The reload resets the sessions, so the enable commands are dropped.
+    channel.Execute ("clear ip bgp * soft out\n");
+
+    NS_TEST_ASSERT_MSG_EQ (channel.GetNumReloads(), 2, "Each batch must trigger a reload");
+    NS_TEST_ASSERT_MSG_EQ (this->m_numReloads, 2, "Each batch must trigger a reload");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands.size(), 2, "Each configured line must be acknowledged");
+    NS_TEST_ASSERT_MSG_EQ (channel.GetFragment(), "ip prefix-list IBGP2-1 seq 1 permit 10.0.0.0/8 le 32\nno ip prefix-list IBGP2-1 seq 1 permit 10.0.0.0/8 le 32\n", "The batches must be accumulated");
+
+    // The configuration file holds the static configuration, then the fragment.
+    std::ostringstream expected;
+    bgpConfig->Print (expected);
+    expected << channel.GetFragment();
+
+    std::ifstream conf ((QuaggaFs::GetRootDirectory (node) + bgpConfig->GetConfigFilename()).c_str());
+    std::ostringstream written;
+    written << conf.rdbuf();
+    NS_TEST_ASSERT_MSG_EQ (written.str(), expected.str(), "Wrong configuration file");
+
+    // Reopening the channel starts a new fragment.
+    channel.Close();
+    channel.Open (node);
+    NS_TEST_ASSERT_MSG_EQ (channel.GetFragment(), "", "The fragment must be reset");
+    NS_TEST_ASSERT_MSG_EQ (channel.GetNumReloads(), 0, "The reloads must be reset");
+    channel.Close();
+}
+
+//----------------------------------------------------------------------------
+// VtyPipelineTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that VtyPipeline matches each command with the prompt
+ *   acknowledging it.
+ */
+
+class VtyPipelineTestCase :
+    public TestCase
+{
+private:
+    std::vector<VtyCommand> m_commands;   /**< Commands acknowledged so far. */
+
+    virtual void DoRun ();
+
+    /**
+     * @brief Pass a chunk of the VTY response to a VtyPipeline.
+     * @param pipeline The VtyPipeline.
+     * @param response The chunk.
+     */
+
+    static void Receive (VtyPipeline & pipeline, const std::string & response);
+
+    /**
+     * @brief Record an acknowledged command.
+     * @param command The command.
+     */
+
+    void HandleCommand (const VtyCommand & command);
+
+public:
+    VtyPipelineTestCase ();
+};
+
+VtyPipelineTestCase::VtyPipelineTestCase () :
+    TestCase ("Check the VTY prompt matching")
+{}
+
+void VtyPipelineTestCase::Receive (VtyPipeline & pipeline, const std::string & response) {
+    std::vector<uint8_t> buffer (response.begin(), response.end());
+    buffer.push_back (0);
+    pipeline.HandleBatch (&buffer[0]);
+}
+
+void VtyPipelineTestCase::HandleCommand (const VtyCommand & command) {
+    this->m_commands.push_back (command);
+}
+
+void VtyPipelineTestCase::DoRun () {
+    VtyPipeline pipeline;
+    pipeline.SetCompletionCallback (MakeCallback (&VtyPipelineTestCase::HandleCommand, this));
+    NS_TEST_ASSERT_MSG_EQ (pipeline.GetNumPending(), 1, "The greeting is pending");
+
+    pipeline.Push ("zebra");
+    pipeline.Push ("enable");
+    pipeline.Push ("configure terminal");
+    pipeline.Push ("router bgp 1");
+    pipeline.Push ("foo");
+
+    // The telnet negotiation and the banner are not prompts, the password
+    // prompt may be split across two chunks.
+    Receive (pipeline, "\xff\xfb\x01\xff\xfb\x03\r\nHello, this is Quagga (version 0.99).\r\n\r\nUser Access Verification\r\n\r\nPass");
+    NS_TEST_ASSERT_MSG_EQ (pipeline.GetNumPending(), 6, "No prompt received yet");
+    Receive (pipeline, "word: ");
+    NS_TEST_ASSERT_MSG_EQ (pipeline.GetNumPending(), 5, "The password prompt acknowledges the greeting");
+
+    Receive (pipeline, "\r\nbgpd> enable\r\nbgpd# configure terminal\r\nbgpd(config)# router bgp 1\r\nbgpd(config-router)# foo\r\n% Unknown command.\r\n");
+    NS_TEST_ASSERT_MSG_EQ (pipeline.GetNumPending(), 1, "Each prompt acknowledges a command");
+    Receive (pipeline, "bgpd(config-router)# ");
+    NS_TEST_ASSERT_MSG_EQ (pipeline.GetNumPending(), 0, "Every command is acknowledged");
+
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands.size(), 6, "Every command must be reported");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[1].line, "zebra", "The commands must be reported in order");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[4].line, "router bgp 1", "The commands must be reported in order");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[4].isError, false, "The command has been accepted");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[5].line, "foo", "The commands must be reported in order");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[5].isError, true, "The command has been rejected");
+    NS_TEST_ASSERT_MSG_EQ (this->m_commands[5].output.find ("% Unknown command.") != std::string::npos, true, "The error message must be reported");
+}
+
+//----------------------------------------------------------------------------
+// Ibgp2dTestCase
+//----------------------------------------------------------------------------
+
+namespace ns3 {
+
+/**
+ * @brief Base class of the test cases running Ibgp2d instances. The
+ *   LS-Updates are handled as if they were sniffed on a point-to-point
+ *   device, and the commands sent to bgpd are recorded by a
+ *   MemoryBgpConfigChannel.
+ */
+
+class Ibgp2dTestCase :
+    public TestCase
+{
+protected:
+    /**
+     * @brief Constructor.
+     * @param name The name of the test case.
+     */
+
+    Ibgp2dTestCase (const std::string & name);
+
+    /**
+     * @brief Install bgpd and Ibgp2d on a new Node.
+     * @param routerId The router-id of the Node.
+     * @return The Ibgp2d instance.
+     */
+
+    static Ptr<Ibgp2d> CreateIbgp2d (const char * routerId);
+
+    /**
+     * @brief Add to an LS-Update the LSAs of the following topology:
+     *
+     *   a --- 10.0.1.0/24 --- u --- 10.0.0.0/24 --- v --- 10.0.2.0/24 --- b
+     *
+     *   u (1.1.1.1) has the lowest interface address of its networks,
+     *   v (2.2.2.2) is the DR of 10.0.2.0/24. The ASBRs a (3.3.3.3) and
+     *   b (4.4.4.4) announce 192.168.0.0/16 and 172.16.0.0/16. u is the
+     *   first hop of v toward a, and of a toward b.
+     * @param lsUpdate The LS-Update.
+     */
+
+    static void AddChain (LsUpdate & lsUpdate);
+
+    /**
+     * @brief Schedule the reception of an LS-Update by some Ibgp2d
+     *   instances, one second later.
+     * @param ibgp2ds The Ibgp2d instances.
+     * @param lsUpdate The LS-Update.
+     */
+
+    static void Flood (const std::vector<Ptr<Ibgp2d> > & ibgp2ds, const LsUpdate & lsUpdate);
+
+    /**
+     * @brief Schedule the reception of an LS-Update by an Ibgp2d
+     *   instance, one second later.
+     * @param ibgp2d The Ibgp2d instance.
+     * @param lsUpdate The LS-Update.
+     */
+
+    static void Flood (Ptr<Ibgp2d> ibgp2d, const LsUpdate & lsUpdate);
+
+    /**
+     * @brief Pass a packet to an Ibgp2d instance.
+     * @param ibgp2d The Ibgp2d instance.
+     * @param packet The packet.
+     */
+
+    static void Receive (Ptr<Ibgp2d> ibgp2d, Ptr<Packet> packet);
+
+    /**
+     * @brief Retrieve the commands configured in bgpd by an Ibgp2d
+     *   instance since the previous call.
+     * @param ibgp2d The Ibgp2d instance.
+     * @return The commands.
+     */
+
+    static std::string GetConfiguration (Ptr<Ibgp2d> ibgp2d);
+
+    /**
+     * @brief Count the commands starting with a given string.
+     * @param configuration The commands.
+     * @param head The beginning of the commands.
+     * @return The number of commands starting with head.
+     */
+
+    static std::size_t Count (const std::string & configuration, const std::string & head);
+
+    /**
+     * @brief Retrieve the route-map bound to an iBGP2 neighbor.
+     * @param configuration The commands.
+     * @param neighbor The interface address of the neighbor.
+     * @return The name of the route-map, "" if it is not bound by these
+     *   commands.
+     */
+
+    static std::string GetRouteMap (const std::string & configuration, const char * neighbor);
+
+    /**
+     * @brief Retrieve the prefix-list matched by an iBGP2 route-map.
+     * @param routeMap The name of the route-map.
+     * @return The name of the prefix-list.
+     */
+
+    static std::string GetPrefixList (const std::string & routeMap);
+
+    /**
+     * @brief Retrieve the sequence number of a prefix-list entry.
+     * @param configuration The commands.
+     * @param command "ip prefix-list" (entry added) or "no ip prefix-list"
+     *   (entry removed).
+     * @param prefixList The name of the prefix-list.
+     * @param prefix The prefix of the entry.
+     * @return The sequence number, 0 if the entry is not altered by these
+     *   commands.
+     */
+
+    static uint32_t GetSeq (
+        const std::string & configuration,
+        const std::string & command,
+        const std::string & prefixList,
+        const char * prefix
+    );
+};
+
+Ibgp2dTestCase::Ibgp2dTestCase (const std::string & name) :
+    TestCase (name)
+{}
+
+Ptr<Ibgp2d> Ibgp2dTestCase::CreateIbgp2d (const char * routerId) {
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper internet;
+    internet.Install (node);
+    node->AggregateObject (CreateObject<BgpConfig>());
+
+    Ptr<Ibgp2d> ibgp2d = CreateObject<Ibgp2d>();
+    ibgp2d->SetAsn (1);
+    ibgp2d->SetRouterId (Ipv4Address (routerId));
+    ibgp2d->SetBgpConfigChannel (new MemoryBgpConfigChannel);
+    ibgp2d->m_linkHeaderSizes["0"] = OSPF_PPP_HEADER_SIZE;
+    node->AddApplication (ibgp2d);
+    return ibgp2d;
+}
+
+void Ibgp2dTestCase::AddChain (LsUpdate & lsUpdate) {
+    lsUpdate.AddRouterLsa ("1.1.1.1", 1, {{"10.0.0.1", "10.0.0.1", 1}, {"10.0.1.1", "10.0.1.1", 1}});
+    lsUpdate.AddRouterLsa ("2.2.2.2", 1, {{"10.0.0.1", "10.0.0.2", 1}, {"10.0.2.2", "10.0.2.2", 1}});
+    lsUpdate.AddRouterLsa ("3.3.3.3", 1, {{"10.0.1.1", "10.0.1.3", 1}});
+    lsUpdate.AddRouterLsa ("4.4.4.4", 1, {{"10.0.2.2", "10.0.2.4", 1}});
+    lsUpdate.AddNetworkLsa ("10.0.0.1", "255.255.255.0", "1.1.1.1", 1);
+    lsUpdate.AddNetworkLsa ("10.0.1.1", "255.255.255.0", "1.1.1.1", 1);
+    lsUpdate.AddNetworkLsa ("10.0.2.2", "255.255.255.0", "2.2.2.2", 1);
+    lsUpdate.AddExternalLsa ("192.168.0.0", "255.255.0.0", "3.3.3.3", 1);
+    lsUpdate.AddExternalLsa ("172.16.0.0", "255.255.0.0", "4.4.4.4", 1);
+}
+
+void Ibgp2dTestCase::Flood (const std::vector<Ptr<Ibgp2d> > & ibgp2ds, const LsUpdate & lsUpdate) {
+    Ptr<Packet> packet = lsUpdate.Build();
+    for (Ptr<Ibgp2d> ibgp2d : ibgp2ds) {
+        Simulator::Schedule (Seconds (1), &Ibgp2dTestCase::Receive, ibgp2d, packet);
+    }
+}
+
+void Ibgp2dTestCase::Flood (Ptr<Ibgp2d> ibgp2d, const LsUpdate & lsUpdate) {
+    Flood (std::vector<Ptr<Ibgp2d> > (1, ibgp2d), lsUpdate);
+}
+
+void Ibgp2dTestCase::Receive (Ptr<Ibgp2d> ibgp2d, Ptr<Packet> packet) {
+    ibgp2d->HandlePacket ("0", packet);
+}
+
+std::string Ibgp2dTestCase::GetConfiguration (Ptr<Ibgp2d> ibgp2d) {
+    MemoryBgpConfigChannel * channel = static_cast<MemoryBgpConfigChannel *> (ibgp2d->GetBgpConfigChannel());
+    std::string configuration;
+    for (const std::string & commands : channel->GetConfigured()) {
+        configuration += commands;
+    }
+    channel->Clear();
+    return configuration;
+}
+
+std::size_t Ibgp2dTestCase::Count (const std::string & configuration, const std::string & head) {
+    std::size_t ret = 0;
+    std::istringstream iss (configuration);
+    std::string line;
+    while (std::getline (iss, line)) {
+        if (line.compare (0, head.size(), head) == 0) ++ret;
+    }
+    return ret;
+}
+
+std::string Ibgp2dTestCase::GetRouteMap (const std::string & configuration, const char * neighbor) {
+    std::ostringstream oss;
+    oss << "neighbor " << Ipv4Address (neighbor) << " route-map ";
+    const std::string head = oss.str();
+
+    std::istringstream iss (configuration);
+    std::string line;
+    while (std::getline (iss, line)) {
+        if (line.compare (0, head.size(), head) == 0) {
+            return line.substr (head.size(), line.rfind (" out") - head.size());
+        }
+    }
+    return "";
+}
+
+std::string Ibgp2dTestCase::GetPrefixList (const std::string & routeMap) {
+    return IBGP2_PREFIX_LIST_PREFIX + routeMap.substr (std::string (IBGP2_ROUTE_MAP_PREFIX).size());
+}
+
+uint32_t Ibgp2dTestCase::GetSeq (
+    const std::string & configuration,
+    const std::string & command,
+    const std::string & prefixList,
+    const char * prefix
+) {
+    std::ostringstream oss;
+    oss << command << ' ' << prefixList << " seq ";
+    const std::string head = oss.str();
+    oss.str ("");
+    oss << Ipv4Prefix (prefix);
+    const std::string network = oss.str();
+
+    std::istringstream iss (configuration);
+    std::string line;
+    while (std::getline (iss, line)) {
+        if (line.compare (0, head.size(), head) != 0) continue;
+
+        // <seq> permit <prefix> [le 32]
+        std::istringstream entry (line.substr (head.size()));
+        uint32_t seq;
+        std::string action, p;
+        if (entry >> seq >> action >> p && p == network) return seq;
+    }
+    return 0;
+}
+
+} // namespace ns3
+
+//----------------------------------------------------------------------------
+// Ibgp2dFastPathTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that the changes of external networks are remapped in the
+ *   filters without any SPF, unlike the changes of the IGP graph.
+ */
+
+class Ibgp2dFastPathTestCase :
+    public Ibgp2dTestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    Ibgp2dFastPathTestCase ();
+};
+
+Ibgp2dFastPathTestCase::Ibgp2dFastPathTestCase () :
+    Ibgp2dTestCase ("Check the Ibgp2d fast path on external-only changes")
+{}
+
+void Ibgp2dFastPathTestCase::DoRun () {
+    Ptr<Ibgp2d> ibgp2d = CreateIbgp2d ("1.1.1.1");
+
+    LsUpdate lsUpdate;
+    AddChain (lsUpdate);
+    Flood (ibgp2d, lsUpdate);
+    Simulator::Run();
+
+    // v only gets the routes of a from u.
+    std::string configuration = GetConfiguration (ibgp2d);
+    const std::string prefixList = GetPrefixList (GetRouteMap (configuration, "10.0.0.2"));
+    NS_TEST_ASSERT_MSG_EQ (ibgp2d->GetStats().numSpfRuns, 1, "The filters are computed by an SPF");
+    NS_TEST_ASSERT_MSG_NE (GetSeq (configuration, "ip prefix-list", prefixList, "192.168.0.0/16"), 0, "v must get the routes of a");
+    NS_TEST_ASSERT_MSG_EQ (GetSeq (configuration, "ip prefix-list", prefixList, "172.16.0.0/16"), 0, "v must not get the routes of b");
+
+    // a announces, then withdraws, a new external network.
+    LsUpdate announce;
+    announce.AddExternalLsa ("198.51.100.0", "255.255.255.0", "3.3.3.3", 1);
+    Flood (ibgp2d, announce);
+    Simulator::Run();
+
+    configuration = GetConfiguration (ibgp2d);
+    NS_TEST_ASSERT_MSG_EQ (ibgp2d->GetStats().numSpfRuns, 1, "An external-only change must not trigger an SPF");
+    NS_TEST_ASSERT_MSG_NE (GetSeq (configuration, "ip prefix-list", prefixList, "198.51.100.0/24"), 0, "The new network of a must be permitted");
+
+    LsUpdate withdraw;
+    withdraw.AddExternalLsa ("198.51.100.0", "255.255.255.0", "3.3.3.3", 2, OSPF_LSA_MAX_AGE);
+    Flood (ibgp2d, withdraw);
+    Simulator::Run();
+
+    configuration = GetConfiguration (ibgp2d);
+    NS_TEST_ASSERT_MSG_EQ (ibgp2d->GetStats().numSpfRuns, 1, "An external-only change must not trigger an SPF");
+    NS_TEST_ASSERT_MSG_NE (GetSeq (configuration, "no ip prefix-list", prefixList, "198.51.100.0/24"), 0, "The withdrawn network of a must be denied");
+
+    // A change of metric alters the IGP graph.
+    LsUpdate metric;
+    metric.AddRouterLsa ("2.2.2.2", 2, {{"10.0.0.1", "10.0.0.2", 1}, {"10.0.2.2", "10.0.2.2", 10}});
+    Flood (ibgp2d, metric);
+    Simulator::Run();
+    NS_TEST_ASSERT_MSG_EQ (ibgp2d->GetStats().numSpfRuns, 2, "A change of the IGP graph must trigger an SPF");
+
+    Simulator::Destroy();
+}
+
+//----------------------------------------------------------------------------
+// Ibgp2dBatchReuseTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that the Ibgp2d instances reusing the first hops computed by
+ *   another instance of the same batch get the same filters.
+ */
+
+class Ibgp2dBatchReuseTestCase :
+    public Ibgp2dTestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    Ibgp2dBatchReuseTestCase ();
+};
+
+Ibgp2dBatchReuseTestCase::Ibgp2dBatchReuseTestCase () :
+    Ibgp2dTestCase ("Check the reuse of the first hops in a batch")
+{}
+
+void Ibgp2dBatchReuseTestCase::DoRun () {
+    // The first instance computes the trees, the second one reuses them
+    // (and not those cached by the previous test cases).
+    Singleton<OspfFirstHopCache>::Get()->Clear();
+
+    std::vector<Ptr<Ibgp2d> > ibgp2ds;
+    for (uint32_t i = 0; i < 2; ++i) {
+        Ptr<Ibgp2d> ibgp2d = CreateIbgp2d ("1.1.1.1");
+        ibgp2d->SetAttribute ("BatchMode", BooleanValue (true));
+        ibgp2ds.push_back (ibgp2d);
+    }
+
+    LsUpdate lsUpdate;
+    AddChain (lsUpdate);
+    Flood (ibgp2ds, lsUpdate);
+    Simulator::Run();
+
+    const std::string configuration = GetConfiguration (ibgp2ds[0]);
+    const std::string prefixList = GetPrefixList (GetRouteMap (configuration, "10.0.0.2"));
+    NS_TEST_ASSERT_MSG_NE (GetSeq (configuration, "ip prefix-list", prefixList, "192.168.0.0/16"), 0, "v must get the routes of a");
+    NS_TEST_ASSERT_MSG_EQ (GetConfiguration (ibgp2ds[1]), configuration, "Both instances must push the same filters");
+
+    Simulator::Destroy();
+}
+
+//----------------------------------------------------------------------------
+// Ibgp2dBatchTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that the Ibgp2d instances processed in a batch push the same
+ *   filters as an instance running on its own, whatever the number of
+ *   threads, and recompute them once per timestamp.
+ */
+
+class Ibgp2dBatchTestCase :
+    public Ibgp2dTestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    Ibgp2dBatchTestCase ();
+};
+
+Ibgp2dBatchTestCase::Ibgp2dBatchTestCase () :
+    Ibgp2dTestCase ("Check Ibgp2dBatch")
+{}
+
+void Ibgp2dBatchTestCase::DoRun () {
+    Singleton<OspfFirstHopCache>::Get()->Clear();
+
+    // The reference computes its trees on its own.
+    Ptr<Ibgp2d> reference = CreateIbgp2d ("1.1.1.1");
+    reference->SetAttribute ("SharedFirstHopCache", BooleanValue (false));
+
+    // The batch runs u with 1, 2 and 4 threads, and v.
+    std::vector<Ptr<Ibgp2d> > ibgp2ds (1, reference);
+    for (uint32_t numThreads = 1; numThreads <= 4; numThreads *= 2) {
+        Ptr<Ibgp2d> ibgp2d = CreateIbgp2d ("1.1.1.1");
+        ibgp2d->SetAttribute ("BatchMode", BooleanValue (true));
+        ibgp2d->SetAttribute ("NumThreads", UintegerValue (numThreads));
+        ibgp2ds.push_back (ibgp2d);
+    }
+
+    Ptr<Ibgp2d> v = CreateIbgp2d ("2.2.2.2");
+    v->SetAttribute ("BatchMode", BooleanValue (true));
+    ibgp2ds.push_back (v);
+
+    // The batch receives two LS-Updates at the same time, which lead to a
+    // single recomputation. The reference receives them as a single one.
+    LsUpdate lsUpdate, external, merged;
+    AddChain (lsUpdate);
+    external.AddExternalLsa ("198.51.100.0", "255.255.255.0", "3.3.3.3", 1);
+    AddChain (merged);
+    merged.AddExternalLsa ("198.51.100.0", "255.255.255.0", "3.3.3.3", 1);
+
+    const std::vector<Ptr<Ibgp2d> > batch (ibgp2ds.begin() + 1, ibgp2ds.end());
+    Flood (batch, lsUpdate);
+    Flood (batch, external);
+    Flood (reference, merged);
+    Simulator::Run();
+
+    std::string configuration = GetConfiguration (reference);
+    NS_TEST_ASSERT_MSG_NE (GetRouteMap (configuration, "10.0.0.2"), "", "u must configure v");
+    for (std::size_t i = 1; i + 1 < ibgp2ds.size(); ++i) {
+        NS_TEST_ASSERT_MSG_EQ (GetConfiguration (ibgp2ds[i]), configuration, "Instance " << i << " must push the filters of the reference");
+        NS_TEST_ASSERT_MSG_EQ (ibgp2ds[i]->GetStats().numSpfRuns, 1, "Instance " << i << " must recompute its filters once");
+    }
+
+    // v only gets the routes of b from u.
+    const std::string configurationV = GetConfiguration (v);
+    const std::string prefixList = GetPrefixList (GetRouteMap (configurationV, "10.0.0.1"));
+    NS_TEST_ASSERT_MSG_NE (GetSeq (configurationV, "ip prefix-list", prefixList, "172.16.0.0/16"), 0, "u must get the routes of b");
+    NS_TEST_ASSERT_MSG_EQ (GetSeq (configurationV, "ip prefix-list", prefixList, "192.168.0.0/16"), 0, "u must not get the routes of a");
+
+    // b becomes unreachable: the trees are repaired, or found in the cache.
+    LsUpdate failure;
+    failure.AddRouterLsa ("2.2.2.2", 2, {{"10.0.0.1", "10.0.0.2", 1}});
+    Flood (ibgp2ds, failure);
+    Simulator::Run();
+
+    configuration = GetConfiguration (reference);
+    NS_TEST_ASSERT_MSG_NE (configuration, "", "The filters must change");
+    for (std::size_t i = 1; i + 1 < ibgp2ds.size(); ++i) {
+        NS_TEST_ASSERT_MSG_EQ (GetConfiguration (ibgp2ds[i]), configuration, "Instance " << i << " must push the filters of the reference");
+    }
+
+    Simulator::Destroy();
+}
+
+//----------------------------------------------------------------------------
+// Ibgp2dPrefixListTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that a prefix has the same sequence number in every
+ *   prefix-list, and that this number is released once the prefix leaves
+ *   every prefix-list.
+ */
+
+class Ibgp2dPrefixListTestCase :
+    public Ibgp2dTestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    Ibgp2dPrefixListTestCase ();
+};
+
+Ibgp2dPrefixListTestCase::Ibgp2dPrefixListTestCase () :
+    Ibgp2dTestCase ("Check the sequence numbers of the iBGP2 prefix-lists")
+{}
+
+void Ibgp2dPrefixListTestCase::DoRun () {
+    Ptr<Ibgp2d> ibgp2d = CreateIbgp2d ("1.1.1.1");
+
+    // u (1.1.1.1) is connected to v1 (2.2.2.2), v2 (3.3.3.3) and the ASBR
+    // a (4.4.4.4) through distinct networks. v1 and v2 share a network with
+    // the ASBR b (5.5.5.5), so they only get the routes of a from u.
+    LsUpdate lsUpdate;
+    lsUpdate.AddRouterLsa ("1.1.1.1", 1, {{"10.0.0.1", "10.0.0.1", 1}, {"10.0.1.1", "10.0.1.1", 1}, {"10.0.2.1", "10.0.2.1", 1}});
+    lsUpdate.AddRouterLsa ("2.2.2.2", 1, {{"10.0.0.1", "10.0.0.2", 1}, {"10.0.3.2", "10.0.3.2", 1}});
+    lsUpdate.AddRouterLsa ("3.3.3.3", 1, {{"10.0.1.1", "10.0.1.3", 1}, {"10.0.3.2", "10.0.3.3", 1}});
+    lsUpdate.AddRouterLsa ("4.4.4.4", 1, {{"10.0.2.1", "10.0.2.4", 1}});
+    lsUpdate.AddRouterLsa ("5.5.5.5", 1, {{"10.0.3.2", "10.0.3.5", 1}});
+    lsUpdate.AddNetworkLsa ("10.0.0.1", "255.255.255.0", "1.1.1.1", 1);
+    lsUpdate.AddNetworkLsa ("10.0.1.1", "255.255.255.0", "1.1.1.1", 1);
+    lsUpdate.AddNetworkLsa ("10.0.2.1", "255.255.255.0", "1.1.1.1", 1);
+    lsUpdate.AddNetworkLsa ("10.0.3.2", "255.255.255.0", "2.2.2.2", 1);
+    lsUpdate.AddExternalLsa ("192.168.0.0", "255.255.0.0", "4.4.4.4", 1);
+    lsUpdate.AddExternalLsa ("172.16.0.0", "255.255.0.0", "5.5.5.5", 1);
+    Flood (ibgp2d, lsUpdate);
+    Simulator::Run();
+
+    std::string configuration = GetConfiguration (ibgp2d);
+    const std::string prefixList1 = GetPrefixList (GetRouteMap (configuration, "10.0.0.2"));
+    const std::string prefixList2 = GetPrefixList (GetRouteMap (configuration, "10.0.1.3"));
+    NS_TEST_ASSERT_MSG_NE (prefixList1, prefixList2, "v1 and v2 have distinct filters");
+
+    uint32_t seq = GetSeq (configuration, "ip prefix-list", prefixList1, "192.168.0.0/16");
+    NS_TEST_ASSERT_MSG_NE (seq, 0, "v1 must get the routes of a");
+    NS_TEST_ASSERT_MSG_EQ (GetSeq (configuration, "ip prefix-list", prefixList2, "192.168.0.0/16"), seq, "A prefix must have the same sequence number in every prefix-list");
+    NS_TEST_ASSERT_MSG_NE (GetSeq (configuration, "ip prefix-list", prefixList1, "10.0.0.0/24"), GetSeq (configuration, "ip prefix-list", prefixList2, "10.0.1.0/24"), "Distinct prefixes must have distinct sequence numbers");
+
+    // a withdraws its network: the entry is removed from both prefix-lists.
+    LsUpdate withdraw;
+    withdraw.AddExternalLsa ("192.168.0.0", "255.255.0.0", "4.4.4.4", 2, OSPF_LSA_MAX_AGE);
+    Flood (ibgp2d, withdraw);
+    Simulator::Run();
+
+    configuration = GetConfiguration (ibgp2d);
+    NS_TEST_ASSERT_MSG_EQ (GetSeq (configuration, "no ip prefix-list", prefixList1, "192.168.0.0/16"), seq, "The entry must be removed from the prefix-list of v1");
+    NS_TEST_ASSERT_MSG_EQ (GetSeq (configuration, "no ip prefix-list", prefixList2, "192.168.0.0/16"), seq, "The entry must be removed from the prefix-list of v2");
+
+    // The sequence number is then free for the next prefix.
+    LsUpdate announce;
+    announce.AddExternalLsa ("198.51.100.0", "255.255.255.0", "4.4.4.4", 1);
+    Flood (ibgp2d, announce);
+    Simulator::Run();
+
+    configuration = GetConfiguration (ibgp2d);
+    NS_TEST_ASSERT_MSG_EQ (GetSeq (configuration, "ip prefix-list", prefixList1, "198.51.100.0/24"), seq, "The released sequence number must be reused");
+    NS_TEST_ASSERT_MSG_EQ (GetSeq (configuration, "ip prefix-list", prefixList2, "198.51.100.0/24"), seq, "The released sequence number must be reused");
+
+    Simulator::Destroy();
+}
+
+//----------------------------------------------------------------------------
+// Ibgp2dPolicyTestCase
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Check that the iBGP2 neighbors having the same filter share an
+ *   outbound policy, and that a policy is removed once unused.
+ */
+
+class Ibgp2dPolicyTestCase :
+    public Ibgp2dTestCase
+{
+private:
+    virtual void DoRun ();
+
+public:
+    Ibgp2dPolicyTestCase ();
+};
+
+Ibgp2dPolicyTestCase::Ibgp2dPolicyTestCase () :
+    Ibgp2dTestCase ("Check the iBGP2 policies shared by the neighbors")
+{}
+
+void Ibgp2dPolicyTestCase::DoRun () {
+    Ptr<Ibgp2d> ibgp2d = CreateIbgp2d ("1.1.1.1");
+
+    // u (1.1.1.1), v1 (2.2.2.2) and v2 (3.3.3.3) share a LAN, u is the
+    // first hop of v1 and v2 toward the ASBR a (4.4.4.4).
+    LsUpdate lsUpdate;
+    lsUpdate.AddRouterLsa ("1.1.1.1", 1, {{"10.0.0.1", "10.0.0.1", 1}, {"10.0.1.1", "10.0.1.1", 1}});
+    lsUpdate.AddRouterLsa ("2.2.2.2", 1, {{"10.0.0.1", "10.0.0.2", 1}});
+    lsUpdate.AddRouterLsa ("3.3.3.3", 1, {{"10.0.0.1", "10.0.0.3", 1}});
+    lsUpdate.AddRouterLsa ("4.4.4.4", 1, {{"10.0.1.1", "10.0.1.4", 1}});
+    lsUpdate.AddNetworkLsa ("10.0.0.1", "255.255.255.0", "1.1.1.1", 1);
+    lsUpdate.AddNetworkLsa ("10.0.1.1", "255.255.255.0", "1.1.1.1", 1);
+    lsUpdate.AddExternalLsa ("192.168.0.0", "255.255.0.0", "4.4.4.4", 1);
+    Flood (ibgp2d, lsUpdate);
+    Simulator::Run();
+
+    std::string configuration = GetConfiguration (ibgp2d);
+    const std::string routeMap = GetRouteMap (configuration, "10.0.0.2");
+    NS_TEST_ASSERT_MSG_NE (routeMap, "", "v1 must be bound to a route-map");
+    NS_TEST_ASSERT_MSG_EQ (GetRouteMap (configuration, "10.0.0.3"), routeMap, "v1 and v2 must share their route-map");
+    NS_TEST_ASSERT_MSG_NE (GetRouteMap (configuration, "10.0.1.4"), routeMap, "a has another filter");
+    NS_TEST_ASSERT_MSG_EQ (Count (configuration, "route-map "), 2, "One route-map per distinct filter");
+
+    // v2 gets a link toward a: u is no more its first hop toward a.
+    LsUpdate link;
+    link.AddRouterLsa ("3.3.3.3", 2, {{"10.0.0.1", "10.0.0.3", 1}, {"10.0.2.3", "10.0.2.3", 1}});
+    link.AddRouterLsa ("4.4.4.4", 2, {{"10.0.1.1", "10.0.1.4", 1}, {"10.0.2.3", "10.0.2.4", 1}});
+    link.AddNetworkLsa ("10.0.2.3", "255.255.255.0", "3.3.3.3", 1);
+    Flood (ibgp2d, link);
+    Simulator::Run();
+
+    configuration = GetConfiguration (ibgp2d);
+    const std::string routeMap2 = GetRouteMap (configuration, "10.0.0.3");
+    NS_TEST_ASSERT_MSG_NE (routeMap2, "", "v2 must leave the shared route-map");
+    NS_TEST_ASSERT_MSG_NE (routeMap2, routeMap, "v2 must leave the shared route-map");
+    NS_TEST_ASSERT_MSG_EQ (GetRouteMap (configuration, "10.0.0.2"), "", "v1 must keep its route-map");
+    NS_TEST_ASSERT_MSG_EQ (Count (configuration, "no route-map "), 0, "The shared route-map is still used by v1");
+
+    // Back to the initial topology: v2 joins v1 again.
+    LsUpdate failure;
+    failure.AddRouterLsa ("3.3.3.3", 3, {{"10.0.0.1", "10.0.0.3", 1}});
+    failure.AddRouterLsa ("4.4.4.4", 3, {{"10.0.1.1", "10.0.1.4", 1}});
+    Flood (ibgp2d, failure);
+    Simulator::Run();
+
+    configuration = GetConfiguration (ibgp2d);
+    NS_TEST_ASSERT_MSG_EQ (GetRouteMap (configuration, "10.0.0.3"), routeMap, "v2 must join the route-map of v1");
+    NS_TEST_ASSERT_MSG_EQ (Count (configuration, "route-map "), 0, "No route-map must be created");
+    NS_TEST_ASSERT_MSG_EQ (Count (configuration, "no route-map " + routeMap2), 1, "The unused route-map must be removed");
+    NS_TEST_ASSERT_MSG_EQ (Count (configuration, "no ip prefix-list " + GetPrefixList (routeMap2)), 1, "The unused prefix-list must be removed");
+
+    Simulator::Destroy();
+}
+
+//----------------------------------------------------------------------------
+// DceQuaggaTestSuite
+//----------------------------------------------------------------------------
+
+/**
+ * @brief Unit tests of the iBGP2 building blocks.
+ */
+
+static class DceQuaggaTestSuite :
+    public TestSuite
+{
+public:
+    DceQuaggaTestSuite ();
+} g_dceQuaggaTestSuite;
+
+DceQuaggaTestSuite::DceQuaggaTestSuite () :
+    TestSuite ("dce-quagga", UNIT)
+{
+    this->AddTestCase (new OspfSpfTestCase, TestCase::QUICK);
+    this->AddTestCase (new OspfSpfUpdateTestCase, TestCase::QUICK);
+    this->AddTestCase (new OspfSpfTargetsTestCase, TestCase::QUICK);
+    this->AddTestCase (new WorkerPoolTestCase, TestCase::QUICK);
+    this->AddTestCase (new OspfFirstHopCacheTestCase, TestCase::QUICK);
+    this->AddTestCase (new OspfSpfTieBreakTestCase, TestCase::QUICK);
+    this->AddTestCase (new OspfLsdbTestCase, TestCase::QUICK);
+    this->AddTestCase (new OspfLsaViewTestCase, TestCase::QUICK);
+    this->AddTestCase (new Ipv4PrefixAggregateTestCase, TestCase::QUICK);
+    this->AddTestCase (new BgpConfigChannelTestCase, TestCase::QUICK);
+    this->AddTestCase (new VtyPipelineTestCase, TestCase::QUICK);
+    this->AddTestCase (new Ibgp2dFastPathTestCase, TestCase::QUICK);
+    this->AddTestCase (new Ibgp2dBatchReuseTestCase, TestCase::QUICK);
+    this->AddTestCase (new Ibgp2dBatchTestCase, TestCase::QUICK);
+    this->AddTestCase (new Ibgp2dPrefixListTestCase, TestCase::QUICK);
+    this->AddTestCase (new Ibgp2dPolicyTestCase, TestCase::QUICK);
+}